@@ -0,0 +1,221 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include "benchmark.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        std::string escapeJson(const std::string& text)
+        {
+            std::string out;
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                    out += '\\';
+                out += c;
+            }
+            return out;
+        }
+
+        /// Value of "key": in a single line of our own JSON output.
+        bool findField(const std::string& line, const std::string& key, std::string& value)
+        {
+            auto pos = line.find("\"" + key + "\":");
+            if (pos == std::string::npos)
+                return false;
+
+            pos = line.find_first_not_of(' ', pos + key.size() + 3);
+            if (pos == std::string::npos)
+                return false;
+
+            if (line[pos] == '"')
+            {
+                value.clear();
+                for (++pos; pos < line.size() && line[pos] != '"'; ++pos)
+                {
+                    if (line[pos] == '\\' && pos + 1 < line.size())
+                        ++pos;
+                    value += line[pos];
+                }
+            }
+            else
+                value = line.substr(pos, line.find_first_of(",}", pos) - pos);
+
+            return true;
+        }
+    }
+
+    BenchmarkSuite::BenchmarkSuite(double minSeconds, const std::string& filter) : minSeconds(minSeconds), filter(filter)
+    {
+
+    }
+
+    void BenchmarkSuite::run(const std::string& group, const std::string& name, double flops, double bytes, const std::function<void()>& body)
+    {
+        std::string key = group + "/" + name;
+        if (!filter.empty() && key.find(filter) == std::string::npos)
+            return;
+
+        // Warm up caches, allocators and lazily tuned kernels, then size batches so each of the samples takes ~minSeconds / samples.
+        const int samples = 7;
+        body();
+        auto start = Clock::now();
+        body();
+        double once = std::max(1e-9, std::chrono::duration<double>(Clock::now() - start).count());
+        long batch = std::max(1L, (long)(minSeconds / samples / once));
+
+        std::vector<double> times;
+        for (int s = 0; s < samples; ++s)
+        {
+            start = Clock::now();
+            for (long i = 0; i < batch; ++i)
+                body();
+            times.push_back(std::chrono::duration<double>(Clock::now() - start).count() / batch);
+        }
+
+        std::sort(times.begin(), times.end());
+
+        BenchmarkResult result;
+        result.group = group;
+        result.name = name;
+        result.seconds = times[samples / 2];
+        result.iterations = batch * samples;
+        result.flops = flops;
+        result.bytes = bytes;
+        results.push_back(result);
+
+        std::cout << "." << std::flush;
+    }
+
+    void BenchmarkSuite::print(const MachinePeak& peak) const
+    {
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+
+        std::cout << "\n=== " << peak.cpuModel << " | peak/core " << std::fixed << std::setprecision(1) << peak.gflopsPerCore << " GFLOP/s, "
+            << peak.bandwidthPerCoreGBs << " GB/s | " << peak.threads << " threads " << peak.gflops << " GFLOP/s, " << peak.bandwidthGBs << " GB/s ===\n";
+        std::cout << std::left << std::setw(14) << "group" << std::setw(34) << "case" << std::right << std::setw(12) << "time us"
+            << std::setw(10) << "GFLOP/s" << std::setw(8) << "%peak" << std::setw(9) << "GB/s" << std::setw(8) << "%bw" << "\n";
+
+        for (auto& r : results)
+        {
+            std::cout << std::left << std::setw(14) << r.group << std::setw(34) << r.name << std::right
+                << std::setw(12) << std::setprecision(2) << r.seconds * 1e6
+                << std::setw(10) << r.gflops() << std::setw(8) << std::setprecision(1) << (peak.gflopsPerCore > 0 ? 100.0 * r.gflops() / peak.gflopsPerCore : 0.0)
+                << std::setw(9) << std::setprecision(2) << r.bandwidthGBs()
+                << std::setw(8) << std::setprecision(1) << (peak.bandwidthPerCoreGBs > 0 ? 100.0 * r.bandwidthGBs() / peak.bandwidthPerCoreGBs : 0.0) << "\n";
+        }
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    int BenchmarkSuite::checkPeak(const MachinePeak& peak) const
+    {
+        if (peak.gflops <= 0.0)
+            return 0;
+
+        int above = 0;
+        for (auto& r : results)
+        {
+            if (r.gflops() <= peak.gflops)
+                continue;
+
+            std::cout << r.group << "/" << r.name << " runs at " << r.gflops() << " GFLOP/s, above the " << peak.gflops << " GFLOP/s peak\n";
+            ++above;
+        }
+
+        return above;
+    }
+
+    bool BenchmarkSuite::writeJson(const std::string& path, const MachinePeak& peak) const
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+
+        file << std::setprecision(6);
+        file << "{\n";
+        file << "  \"machine\": {\"cpu\": \"" << escapeJson(peak.cpuModel) << "\", \"threads\": " << peak.threads
+            << ", \"gflopsPerCore\": " << peak.gflopsPerCore << ", \"gflops\": " << peak.gflops
+            << ", \"bandwidthPerCoreGBs\": " << peak.bandwidthPerCoreGBs << ", \"bandwidthGBs\": " << peak.bandwidthGBs << "},\n";
+        file << "  \"results\": [\n";
+
+        // One result per line: readBaseline() relies on it.
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& r = results[i];
+            file << "    {\"group\": \"" << escapeJson(r.group) << "\", \"name\": \"" << escapeJson(r.name) << "\""
+                << ", \"seconds\": " << r.seconds << ", \"iterations\": " << r.iterations
+                << ", \"flops\": " << r.flops << ", \"bytes\": " << r.bytes
+                << ", \"gflops\": " << r.gflops() << ", \"bandwidthGBs\": " << r.bandwidthGBs() << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+
+        file << "  ]\n}\n";
+
+        return (bool)file;
+    }
+
+    std::map<std::string, double> BenchmarkSuite::readBaseline(const std::string& path)
+    {
+        std::map<std::string, double> baseline;
+        std::ifstream file(path);
+        std::string line, group, name, seconds;
+
+        while (std::getline(file, line))
+            if (findField(line, "group", group) && findField(line, "name", name) && findField(line, "seconds", seconds))
+                baseline[group + "/" + name] = std::stod(seconds);
+
+        return baseline;
+    }
+
+    int BenchmarkSuite::compare(const std::map<std::string, double>& baseline, double tolerance) const
+    {
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+        int regressions = 0, improvements = 0, missing = 0;
+
+        std::cout << "=== Baseline comparison (tolerance " << std::fixed << std::setprecision(0) << tolerance * 100 << "%) ===\n";
+        for (auto& r : results)
+        {
+            auto it = baseline.find(r.group + "/" + r.name);
+            if (it == baseline.end() || it -> second <= 0.0)
+            {
+                std::cout << std::left << std::setw(48) << r.group + "/" + r.name << std::right << "  not in baseline\n";
+                ++missing;
+                continue;
+            }
+
+            double ratio = r.seconds / it -> second;
+            const char* verdict = "";
+            if (ratio > 1.0 + tolerance)
+            {
+                verdict = "  <-- SLOWER";
+                ++regressions;
+            }
+            else if (ratio < 1.0 - tolerance)
+            {
+                verdict = "  faster";
+                ++improvements;
+            }
+
+            std::cout << std::left << std::setw(48) << r.group + "/" + r.name << std::right << std::setprecision(2)
+                << std::setw(8) << ratio << "x time" << verdict << "\n";
+        }
+
+        std::cout << regressions << " slower, " << improvements << " faster, " << missing << " not in baseline\n";
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+
+        // A case the baseline doesn't cover can't be checked, so it fails the gate like a regression
+        return regressions + missing;
+    }
+}
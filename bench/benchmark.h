@@ -0,0 +1,53 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+#include "machine.h"
+
+namespace SushiAI
+{
+    struct BenchmarkResult
+    {
+        std::string group;
+        std::string name;
+        double seconds = 0.0;       // median time of one iteration
+        long iterations = 0;        // iterations timed in total
+        double flops = 0.0;         // per iteration
+        double bytes = 0.0;         // minimum memory traffic per iteration
+
+        double gflops() const { return seconds > 0.0 ? flops / seconds * 1e-9 : 0.0; }
+        double bandwidthGBs() const { return seconds > 0.0 ? bytes / seconds * 1e-9 : 0.0; }
+    };
+
+    /// Times benchmark bodies, prints them against machine peak and reads/writes JSON result files.
+    class BenchmarkSuite
+    {
+        private:
+            double minSeconds;
+            std::string filter;
+            std::vector<BenchmarkResult> results;
+
+        public:
+            /// minSeconds is the total time spent timing each case; only names containing filter are run.
+            BenchmarkSuite(double minSeconds = 0.5, const std::string& filter = "");
+
+            /// Times body() and records one result. Skipped when the name does not match the filter.
+            void run(const std::string& group, const std::string& name, double flops, double bytes, const std::function<void()>& body);
+
+            const std::vector<BenchmarkResult>& getResults() const { return results; }
+
+            /// Table of time, GFLOP/s and GB/s, with the fraction of single-core peak (the kernels are single-threaded).
+            void print(const MachinePeak& peak) const;
+            /// Prints and counts the cases above the measured all-thread peak: a kernel can't beat the machine,
+            /// so any such case means a wrong flop count or a peak measured too low.
+            int checkPeak(const MachinePeak& peak) const;
+            bool writeJson(const std::string& path, const MachinePeak& peak) const;
+
+            /// "group/name" → seconds from a file written by writeJson(). Empty when the file is missing.
+            static std::map<std::string, double> readBaseline(const std::string& path);
+            /// Prints the speed ratio of every case found in the baseline and returns how many got slower than
+            /// 1 + tolerance or are missing from the baseline.
+            int compare(const std::map<std::string, double>& baseline, double tolerance) const;
+    };
+}
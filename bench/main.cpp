@@ -0,0 +1,567 @@
+#include <cmath>
+#include <string>
+#include <memory>
+#include <array>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include "benchmark.h"
+#include "initializer.h"
+#include "sequential.h"
+#include "optimizer.h"
+#include "machine.h"
+#include "backend.h"
+#include "gemmtuner.h"
+#include "inference.h"
+#include "staticmlp.h"
+#include "pipeline.h"
+#include "sharding.h"
+#include "tensor.h"
+#include "layer.h"
+#include "loss.h"
+#include "ops.h"
+
+using namespace SushiAI;
+
+namespace
+{
+    const double F = sizeof(float);
+
+    std::shared_ptr<Tensor> randomTensor(const std::vector<int>& shape, bool requiresGrad = false)
+    {
+        static std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        auto t = std::make_shared<Tensor>(shape, 0.0f, requiresGrad);
+        for (auto& v : t -> getData())
+            v = dist(gen);
+
+        return t;
+    }
+
+    /// Times the gradient function of `result` alone (the forward pass is built once, outside the timing).
+    /// Forward cases use inputs without requiresGradient: a result's gradient function holds the result
+    /// itself until backward() releases the graph, so timing repeated forwards of a graph would leak.
+    void runBackward(BenchmarkSuite& suite, const std::string& group, const std::string& name, double flops, double bytes, const std::shared_ptr<Tensor>& result)
+    {
+        std::fill(result -> getGradient().begin(), result -> getGradient().end(), 1.0f);
+        suite.run(group, name, flops, bytes, [&]() { result -> gradientFunction(); });
+    }
+
+    void benchMatmul(BenchmarkSuite& suite)
+    {
+        // Skinny MLP shapes first, then square ones.
+        const int shapes[][3] = { { 64, 2, 16 }, { 64, 16, 16 }, { 64, 100, 1 }, { 64, 100, 100 }, { 128, 128, 128 }, { 256, 256, 256 }, { 512, 512, 512 } };
+
+        for (auto& s : shapes)
+        {
+            int m = s[0], k = s[1], n = s[2];
+            auto a = randomTensor({ m, k }), b = randomTensor({ k, n });
+            std::string shape = std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n);
+            double bytes = ((double)m * k + (double)k * n + (double)m * n) * F;
+
+            suite.run("matmul", shape, 2.0 * m * k * n, bytes, [&]() { matmul(a, b); });
+        }
+
+        for (int size : { 64, 256 })
+        {
+            auto a = randomTensor({ size, size }, true), b = randomTensor({ size, size }, true);
+            auto c = matmul(a, b);
+            std::string shape = std::to_string(size) + "x" + std::to_string(size) + "x" + std::to_string(size);
+
+            runBackward(suite, "matmul", shape + " backward", 4.0 * size * size * size, 5.0 * size * size * F, c);
+        }
+
+        const int batched[][4] = { { 8, 64, 64, 64 }, { 32, 32, 32, 32 } };
+        for (auto& s : batched)
+        {
+            int batch = s[0], m = s[1], k = s[2], n = s[3];
+            auto a = randomTensor({ batch, m, k }), b = randomTensor({ batch, k, n });
+            std::string shape = std::to_string(batch) + "@" + std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n);
+            double bytes = batch * ((double)m * k + (double)k * n + (double)m * n) * F;
+
+            suite.run("mul", shape, 2.0 * batch * m * k * n, bytes, [&]() { mul(a, b); });
+        }
+    }
+
+    /// Direct seven-loop convolution, the correctness and speed reference for conv2d.
+    std::vector<float> naiveConv2d(const Tensor& x, const Tensor& w, int stride, int padding, int groups)
+    {
+        const auto& xs = x.getShape();
+        const auto& ws = w.getShape();
+        int N = xs[0], C = xs[1], H = xs[2], W = xs[3], K = ws[0], Cg = ws[1], R = ws[2], S = ws[3];
+        int OH = (H + 2 * padding - R) / stride + 1, OW = (W + 2 * padding - S) / stride + 1, Kg = K / groups;
+
+        std::vector<float> y((size_t)N * K * OH * OW, 0.0f);
+        for (int n = 0; n < N; ++n)
+            for (int k = 0; k < K; ++k)
+                for (int oh = 0; oh < OH; ++oh)
+                    for (int ow = 0; ow < OW; ++ow)
+                    {
+                        float sum = 0.0f;
+                        for (int c = 0; c < Cg; ++c)
+                            for (int r = 0; r < R; ++r)
+                                for (int s = 0; s < S; ++s)
+                                {
+                                    int ih = oh * stride - padding + r, iw = ow * stride - padding + s;
+                                    if (ih >= 0 && ih < H && iw >= 0 && iw < W)
+                                        sum += x.getData()[(((size_t)n * C + k / Kg * Cg + c) * H + ih) * W + iw] * w.getData()[(((size_t)k * Cg + c) * R + r) * S + s];
+                                }
+                        y[(((size_t)n * K + k) * OH + oh) * OW + ow] = sum;
+                    }
+
+        return y;
+    }
+
+    void benchConv(BenchmarkSuite& suite)
+    {
+        // { batch, channels, size, out channels, kernel, stride, padding, groups }
+        const int shapes[][8] =
+        {
+            { 8, 16, 32, 32, 3, 1, 1, 1 },          // 3x3
+            { 8, 32, 16, 64, 3, 2, 1, 1 },          // strided 3x3
+            { 8, 64, 16, 64, 1, 1, 0, 1 },          // pointwise
+            { 8, 64, 16, 64, 3, 1, 1, 64 },         // depthwise
+        };
+
+        for (auto& s : shapes)
+        {
+            int batch = s[0], C = s[1], size = s[2], K = s[3], R = s[4], stride = s[5], padding = s[6], groups = s[7];
+            auto x = randomTensor({ batch, C, size, size }), w = randomTensor({ K, C / groups, R, R });
+            auto xGrad = randomTensor({ batch, C, size, size }, true), wGrad = randomTensor({ K, C / groups, R, R }, true);
+
+            int out = (size + 2 * padding - R) / stride + 1;
+            double flops = 2.0 * batch * K * out * out * (C / groups) * R * R;
+            double bytes = ((double)x -> getTotalSize() + w -> getTotalSize() + (double)batch * K * out * out) * F;
+            std::string shape = std::to_string(batch) + "x" + std::to_string(C) + "x" + std::to_string(size) + "x" + std::to_string(size)
+                + " k" + std::to_string(R) + " -> " + std::to_string(K) + (stride > 1 ? " s" + std::to_string(stride) : "") + (groups > 1 ? " g" + std::to_string(groups) : "");
+
+            auto reference = naiveConv2d(*x, *w, stride, padding, groups);
+            auto y = conv2d(x, w, nullptr, stride, padding, 1, groups);
+            float error = 0.0f;
+            for (size_t i = 0; i < reference.size(); ++i)
+                error = std::max(error, std::fabs(reference[i] - y -> getData()[i]));
+            if (error > 1e-3f)
+                std::cerr << "conv2d " << shape << ": max |error| vs naive reference " << error << "\n";
+
+            suite.run("conv2d", shape + " naive", flops, bytes, [&]() { naiveConv2d(*x, *w, stride, padding, groups); });
+            suite.run("conv2d", shape, flops, bytes, [&]() { conv2d(x, w, nullptr, stride, padding, 1, groups); });
+            runBackward(suite, "conv2d", shape + " backward", 2.0 * flops, 2.0 * bytes, conv2d(xGrad, wGrad, nullptr, stride, padding, 1, groups));
+        }
+    }
+
+    void benchPooling(BenchmarkSuite& suite)
+    {
+        auto x = randomTensor({ 32, 64, 32, 32 }), xGrad = randomTensor({ 32, 64, 32, 32 }, true);
+        double n = (double)x -> getTotalSize();
+
+        suite.run("pooling", "maxPool2d 32x64x32x32 k2", n, 1.25 * n * F, [&]() { maxPool2d(x, 2, 2); });
+        suite.run("pooling", "maxPool2d 32x64x32x32 k3 s1 p1", 9.0 * n, 2.0 * n * F, [&]() { maxPool2d(x, 3, 1, 1); });
+        runBackward(suite, "pooling", "maxPool2d 32x64x32x32 k2 backward", 0.25 * n, 2.5 * n * F, maxPool2d(xGrad, 2, 2));
+        suite.run("pooling", "avgPool2d 32x64x32x32 k2", n, 1.25 * n * F, [&]() { avgPool2d(x, 2, 2); });
+        suite.run("pooling", "globalAvgPool2d 32x64x32x32", n, n * F, [&]() { globalAvgPool2d(x); });
+    }
+
+    /// softmax(Q K^T / sqrt(D)) V with the full [T, T] score matrix of each head materialised.
+    std::vector<float> naiveAttention(const Tensor& q, const Tensor& k, const Tensor& v, int heads, bool causal)
+    {
+        const auto& shape = q.getShape();
+        int B = shape[0], T = shape[1], E = shape[2], D = E / heads;
+        float scale = 1.0f / std::sqrt((float)D);
+
+        std::vector<float> y(q.getTotalSize(), 0.0f), scores((size_t)T * T);
+        for (int b = 0; b < B; ++b)
+            for (int h = 0; h < heads; ++h)
+            {
+                const float* Q = q.getData().data() + (size_t)b * T * E + h * D;
+                const float* K = k.getData().data() + (size_t)b * T * E + h * D;
+                const float* V = v.getData().data() + (size_t)b * T * E + h * D;
+
+                for (int i = 0; i < T; ++i)
+                {
+                    float* row = scores.data() + (size_t)i * T;
+                    int keys = causal ? i + 1 : T;
+                    float maxScore = -INFINITY, sum = 0.0f;
+
+                    for (int j = 0; j < keys; ++j)
+                    {
+                        float dot = 0.0f;
+                        for (int d = 0; d < D; ++d)
+                            dot += Q[(size_t)i * E + d] * K[(size_t)j * E + d];
+                        row[j] = dot * scale;
+                        maxScore = std::max(maxScore, row[j]);
+                    }
+                    for (int j = 0; j < keys; ++j)
+                        sum += row[j] = std::exp(row[j] - maxScore);
+
+                    float* out = y.data() + ((size_t)b * T + i) * E + h * D;
+                    for (int j = 0; j < keys; ++j)
+                        for (int d = 0; d < D; ++d)
+                            out[d] += row[j] / sum * V[(size_t)j * E + d];
+                }
+            }
+
+        return y;
+    }
+
+    void benchAttention(BenchmarkSuite& suite)
+    {
+        const int batch = 4, seq = 256, embed = 256, heads = 4;
+        auto q = randomTensor({ batch, seq, embed }), k = randomTensor({ batch, seq, embed }), v = randomTensor({ batch, seq, embed });
+        auto qGrad = randomTensor({ batch, seq, embed }, true), kGrad = randomTensor({ batch, seq, embed }, true), vGrad = randomTensor({ batch, seq, embed }, true);
+
+        for (bool causal : { false, true })
+        {
+            std::string shape = "4x256x256 h4" + std::string(causal ? " causal" : "");
+            double flops = 4.0 * batch * seq * seq * embed * (causal ? 0.5 : 1.0);
+            double bytes = 4.0 * q -> getTotalSize() * F;
+
+            auto reference = naiveAttention(*q, *k, *v, heads, causal);
+            auto y = scaledDotProductAttention(q, k, v, heads, causal);
+            float error = 0.0f;
+            for (size_t i = 0; i < reference.size(); ++i)
+                error = std::max(error, std::fabs(reference[i] - y -> getData()[i]));
+            if (error > 1e-4f)
+                std::cerr << "attention " << shape << ": max |error| vs naive reference " << error << "\n";
+
+            suite.run("attention", shape + " naive", flops, bytes, [&]() { naiveAttention(*q, *k, *v, heads, causal); });
+            suite.run("attention", shape, flops, bytes, [&]() { scaledDotProductAttention(q, k, v, heads, causal); });
+            runBackward(suite, "attention", shape + " backward", 2.5 * flops, 2.0 * bytes, scaledDotProductAttention(qGrad, kGrad, vGrad, heads, causal));
+        }
+    }
+
+    void benchRecurrent(BenchmarkSuite& suite)
+    {
+        const int batch = 32, steps = 50, inputSize = 64, hidden = 128;
+        auto x = randomTensor({ batch, steps, inputSize }), xGrad = randomTensor({ batch, steps, inputSize }, true);
+        std::string shape = "32x50x64 h128";
+
+        LSTM lstmLayer(inputSize, hidden, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>());
+        GRU gruLayer(inputSize, hidden, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>());
+
+        // One input-projection GEMM plus a [batch, hidden] x [hidden, gates] GEMM per step
+        for (auto [layer, gates] : { std::pair<Layer*, int>{ &lstmLayer, 4 }, std::pair<Layer*, int>{ &gruLayer, 3 } })
+        {
+            std::string name = gates == 4 ? "lstm " : "gru ";
+            double flops = 2.0 * batch * steps * gates * hidden * (inputSize + hidden);
+            double bytes = ((double)x -> getTotalSize() + 2.0 * batch * steps * gates * hidden) * F;
+
+            suite.run("recurrent", name + shape, flops, bytes, [&]() { layer -> forward(x, false); });
+            runBackward(suite, "recurrent", name + shape + " backward", 2.0 * flops, 2.0 * bytes, layer -> forward(xGrad, true));
+        }
+    }
+
+    void benchNormalization(BenchmarkSuite& suite)
+    {
+        auto x = randomTensor({ 256, 1024 }), xGrad = randomTensor({ 256, 1024 }, true);
+        auto gamma = randomTensor({ 1024 }), beta = randomTensor({ 1024 });
+        auto gammaGrad = randomTensor({ 1024 }, true), betaGrad = randomTensor({ 1024 }, true);
+        double n = (double)x -> getTotalSize();
+
+        // One statistics pass plus one normalize pass over the rows
+        suite.run("normalization", "layerNorm 256x1024", 8.0 * n, 2.0 * n * F, [&]() { layerNorm(x, gamma, beta); });
+        runBackward(suite, "normalization", "layerNorm 256x1024 backward", 10.0 * n, 4.0 * n * F, layerNorm(xGrad, gammaGrad, betaGrad));
+        suite.run("normalization", "rmsNorm 256x1024", 5.0 * n, 2.0 * n * F, [&]() { rmsNorm(x, gamma); });
+        runBackward(suite, "normalization", "rmsNorm 256x1024 backward", 8.0 * n, 4.0 * n * F, rmsNorm(xGrad, gammaGrad));
+    }
+
+    void benchAdd(BenchmarkSuite& suite)
+    {
+        const int rows = 256, cols = 1024;
+        auto a = randomTensor({ rows, cols }), same = randomTensor({ rows, cols }), row = randomTensor({ cols });
+        double n = (double)rows * cols;
+
+        suite.run("add", "256x1024 + 256x1024", n, 3.0 * n * F, [&]() { add(a, same); });
+        suite.run("add", "256x1024 + 1024 broadcast", n, (2.0 * n + cols) * F, [&]() { add(a, row); });
+
+        auto aGrad = randomTensor({ rows, cols }, true), rowGrad = randomTensor({ cols }, true);
+        runBackward(suite, "add", "256x1024 + 1024 backward", 2.0 * n, (3.0 * n + cols) * F, add(aGrad, rowGrad));
+    }
+
+    void benchActivations(BenchmarkSuite& suite)
+    {
+        auto x = randomTensor({ 1024, 1024 }), xGrad = randomTensor({ 1024, 1024 }, true);
+        double n = (double)x -> getTotalSize();
+
+        struct Activation { const char* name; double forwardFlops, backwardFlops; std::shared_ptr<Tensor> (*fn)(const std::shared_ptr<Tensor>&); };
+        const Activation activations[] =
+        {
+            { "relu", 1, 2, [](const std::shared_ptr<Tensor>& t) { return relu(t); } },
+            { "leakyRelu", 1, 2, [](const std::shared_ptr<Tensor>& t) { return leakyRelu(t); } },
+            { "sigmoid", 4, 3, [](const std::shared_ptr<Tensor>& t) { return sigmoid(t); } },
+            { "tanh", 4, 3, [](const std::shared_ptr<Tensor>& t) { return SushiAI::tanh(t); } },
+        };
+
+        for (auto& act : activations)
+        {
+            suite.run("activation", std::string(act.name) + " 1M", act.forwardFlops * n, 2.0 * n * F, [&]() { act.fn(x); });
+            runBackward(suite, "activation", std::string(act.name) + " 1M backward", act.backwardFlops * n, 3.0 * n * F, act.fn(xGrad));
+        }
+    }
+
+    void benchSoftmax(BenchmarkSuite& suite)
+    {
+        auto logits = randomTensor({ 256, 1000 }), logitsGrad = randomTensor({ 256, 1000 }, true);
+        auto targets = std::make_shared<Tensor>(std::vector<int>{ 256, 1000 }, 0.0f, false);
+        for (int i = 0; i < 256; ++i)
+            targets -> getData()[i * 1000 + i % 1000] = 1.0f;
+        double n = (double)logits -> getTotalSize();
+
+        suite.run("softmax", "256x1000", 4.0 * n, 2.0 * n * F, [&]() { softmax(logits); });
+        runBackward(suite, "softmax", "256x1000 backward", 4.0 * n, 3.0 * n * F, softmax(logitsGrad));
+        suite.run("softmax", "crossEntropy 256x1000", 6.0 * n, 2.0 * n * F, [&]() { crossEntropyLoss(logits, targets); });
+        runBackward(suite, "softmax", "crossEntropy 256x1000 backward", 3.0 * n, 3.0 * n * F, crossEntropyLoss(logitsGrad, targets));
+    }
+
+    void benchOptimizers(BenchmarkSuite& suite)
+    {
+        std::vector<std::shared_ptr<Tensor>> params = { randomTensor({ 1024, 1024 }, true), randomTensor({ 1024 }, true) };
+        for (auto& p : params)
+            std::fill(p -> getGradient().begin(), p -> getGradient().end(), 1e-3f);
+        double n = 1024.0 * 1024 + 1024;
+
+        SGD sgd(1e-4f, 0.9f);
+        Adam adam(1e-4f);
+
+        suite.run("optimizer", "SGD momentum 1M", 5.0 * n, 5.0 * n * F, [&]() { sgd.step(params); });
+        suite.run("optimizer", "Adam 1M", 15.0 * n, 7.0 * n * F, [&]() { adam.step(params); });
+    }
+
+    void benchEmbedding(BenchmarkSuite& suite)
+    {
+        const int vocab = 1000000, dim = 64, lookups = 512;
+        auto indices = std::make_shared<Tensor>(std::vector<int>{ lookups }, 0.0f, false);
+        std::mt19937 gen(7);
+        for (auto& v : indices -> getData())
+            v = (float)(gen() % vocab);
+
+        // Lookup, backward and a lazy Adam step: only the looked-up rows are read or written.
+        Embedding table(vocab, dim, std::make_shared<UniformInitializer>(-0.05f, 0.05f));
+        Adam adam(1e-3f);
+        std::vector<float> seed((size_t)lookups * dim, 1.0f);
+        double touched = (double)lookups * dim;
+
+        suite.run("embedding", "1Mx64 sparse Adam step, 512 lookups", 15.0 * touched, 9.0 * touched * F, [&]()
+        {
+            adam.zeroGradient(table.parameters());
+            table.forward(indices) -> backward(seed);
+            adam.step(table.parameters());
+        });
+    }
+
+    void benchTrainingStep(BenchmarkSuite& suite)
+    {
+        const int batch = 64;
+        const int sizes[] = { 256, 512, 512, 10 };
+
+        auto model = std::make_shared<Sequential>();
+        double weights = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+            model -> add(std::make_shared<Linear>(sizes[i], sizes[i + 1], std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>()));
+            if (i < 2)
+                model -> add(std::make_shared<ReLU>());
+            weights += (double)sizes[i] * sizes[i + 1];
+        }
+
+        auto x = randomTensor({ batch, sizes[0] });
+        auto y = randomTensor({ batch, sizes[3] });
+        MSELoss loss;
+        Adam adam(1e-4f);
+
+        // Forward GEMMs + two backward GEMMs per Linear; traffic is dominated by the weights (read 3x, grad, Adam state).
+        suite.run("training", "MLP 256-512-512-10 batch 64", 6.0 * batch * weights, 12.0 * weights * F, [&]()
+        {
+            auto out = model -> forward(x, true);
+            loss.forward(out, y) -> backward();
+            adam.step(model -> parameters());
+            adam.zeroGradient(model -> parameters());
+        });
+    }
+
+    void benchPipeline(BenchmarkSuite& suite)
+    {
+        const int batch = 64;
+        const int sizes[] = { 256, 512, 512, 10 };
+
+        auto model = std::make_shared<Sequential>();
+        double weights = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+            model -> add(std::make_shared<Linear>(sizes[i], sizes[i + 1], std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>()));
+            if (i < 2)
+                model -> add(std::make_shared<ReLU>());
+            weights += (double)sizes[i] * sizes[i + 1];
+        }
+
+        auto x = randomTensor({ batch, sizes[0] });
+        auto y = randomTensor({ batch, sizes[3] });
+        MSELoss loss;
+
+        // The training step above split over two balanced stages and four micro-batches (gradients only)
+        Pipeline pipeline(model, balanceStages(*model, x, 2), 4);
+        suite.run("training", "MLP pipeline 2 stages x 4 micro", 6.0 * batch * weights, 8.0 * weights * F, [&]()
+        {
+            pipeline.trainStep(x, y, loss);
+            for (auto& p : model -> parameters())
+                std::fill(p -> getGradient().begin(), p -> getGradient().end(), 0.0f);
+        });
+    }
+
+    void benchInference(BenchmarkSuite& suite)
+    {
+        // The 2-16-16-1 regressor of the demo in main.cpp
+        Sequential model;
+        model.add(std::make_shared<Linear>(2, 16, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>()));
+        model.add(std::make_shared<Linear>(16, 16, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>()));
+        model.add(std::make_shared<Tanh>());
+        model.add(std::make_shared<Linear>(16, 1, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>()));
+
+        const int batch = 8;
+        const double flops = 2.0 * (2 * 16 + 16 * 16 + 16 * 1), bytes = (2 * 16 + 16 + 16 * 16 + 16 + 16 + 1) * F;
+
+        auto x = randomTensor({ 1, 2 });
+        auto plan = model.compile({ 1, 2 });
+        Tensor y({ 1, 1 }, 0.0f, false);
+
+        StaticSequential<StaticLinear<2, 16>, StaticLinear<16, 16, PlanActivation::Tanh>, StaticLinear<16, 1>> net;
+        net.load(model);
+
+        std::array<float, 2> sample{ x -> getData()[0], x -> getData()[1] };
+        auto xs = randomTensor({ batch, 2 });
+        std::vector<float> ys(batch);
+
+        // The body sits behind a std::function, so storing its result is enough to keep it from being dropped
+        volatile float sink = 0.0f;
+
+        suite.run("inference", "MLP 2-16-16-1 Sequential::forward", flops, bytes, [&]() { model.forward(x, false); });
+        suite.run("inference", "MLP 2-16-16-1 InferencePlan", flops, bytes, [&]() { plan -> run(*x, y); });
+        suite.run("inference", "MLP 2-16-16-1 StaticSequential", flops, bytes, [&]() { sink = net.forward(sample)[0]; });
+        suite.run("inference", "MLP 2-16-16-1 StaticSequential batch 8", batch * flops, bytes, [&]()
+        {
+            net.forwardBatch<batch>(xs -> getData().data(), ys.data());
+            sink = ys[0];
+        });
+    }
+
+    void benchSharding(BenchmarkSuite& suite)
+    {
+        const int size = 256;
+        auto x = randomTensor({ size, size }), xGrad = randomTensor({ size, size }, true);
+        std::vector<float> seed((size_t)size * size, 1.0f);
+        double flops = 2.0 * size * size * size, bytes = 3.0 * size * size * F;
+
+        // Whole forward + backward: a Linear's last graph node is its bias add, so runBackward() would miss the GEMMs
+        auto time = [&](const std::string& name, Layer& layer)
+        {
+            suite.run("sharding", name + " 256x256x256", flops, bytes, [&]() { layer.forward(x, false); });
+            suite.run("sharding", name + " 256x256x256 fwd+bwd", 3.0 * flops, 3.0 * bytes, [&]() { layer.forward(xGrad, true) -> backward(seed); });
+        };
+
+        Linear linear(size, size, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>());
+        time("Linear", linear);
+
+        ShardedLinear column(size, size, 2, ShardMode::Column, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>());
+        time("column x2", column);
+        ShardedLinear row(size, size, 2, ShardMode::Row, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>());
+        time("row x2", row);
+    }
+
+    void usage()
+    {
+        std::cout << "SushiAIBench [--quick] [--filter <text>] [--backend <reference|simd|blas>] [--tune <cache.txt>] [--json <out.json>] [--baseline <baseline.json>] [--tolerance <0.15>]\n"
+            << "  Exit code 2 when a case is slower than baseline by more than the tolerance or missing from it,\n"
+            << "  3 when the baseline file is missing or empty, 4 when a case runs above the measured peak.\n"
+            << "  Compare backends by recording one as the baseline: --backend simd --json simd.json, then --backend blas --baseline simd.json\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double minSeconds = 0.5, tolerance = 0.15;
+    std::string filter, jsonPath, baselinePath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--quick")
+            minSeconds = 0.1;
+        else if (arg == "--filter" && hasValue)
+            filter = argv[++i];
+        else if (arg == "--backend" && hasValue)
+        {
+            BackendKind kind;
+            if (!parseBackend(argv[++i], kind) || !setBackend(kind))
+            {
+                std::cerr << "Backend " << argv[i] << " is not available in this build\n";
+                return 1;
+            }
+        }
+        else if (arg == "--tune" && hasValue)
+            GemmTuner::enable(argv[++i]);
+        else if (arg == "--json" && hasValue)
+            jsonPath = argv[++i];
+        else if (arg == "--baseline" && hasValue)
+            baselinePath = argv[++i];
+        else if (arg == "--tolerance" && hasValue)
+            tolerance = std::atof(argv[++i]);
+        else
+        {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    const MachinePeak& peak = machinePeak();
+    BenchmarkSuite suite(minSeconds, filter);
+    std::cout << "Backend: " << backend().name << "\n";
+
+    benchMatmul(suite);
+    benchConv(suite);
+    benchPooling(suite);
+    benchAttention(suite);
+    benchRecurrent(suite);
+    benchNormalization(suite);
+    benchAdd(suite);
+    benchActivations(suite);
+    benchSoftmax(suite);
+    benchOptimizers(suite);
+    benchEmbedding(suite);
+    benchInference(suite);
+    benchSharding(suite);
+    benchTrainingStep(suite);
+    benchPipeline(suite);
+
+    suite.print(peak);
+    int abovePeak = suite.checkPeak(peak);
+
+    if (GemmTuner::isEnabled())
+        GemmTuner::printTable();
+
+    if (!jsonPath.empty())
+    {
+        if (suite.writeJson(jsonPath, peak))
+            std::cout << "Results written to " << jsonPath << "\n";
+        else
+            std::cerr << "Could not write " << jsonPath << "\n";
+    }
+
+    if (!baselinePath.empty())
+    {
+        auto baseline = BenchmarkSuite::readBaseline(baselinePath);
+        if (baseline.empty())
+        {
+            std::cerr << "No baseline at " << baselinePath << " (record one with --json " << baselinePath << ")\n";
+            return 3;
+        }
+
+        if (suite.compare(baseline, tolerance) > 0)
+            return 2;
+    }
+
+    return abovePeak > 0 ? 4 : 0;
+}
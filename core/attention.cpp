@@ -0,0 +1,279 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "tensor.h"
+#include "ops.h"
+#include "opsdetail.h"
+#include "profiler.h"
+#include "backend.h"
+#include "parallel.h"
+#include "vectormath.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using namespace simd;
+        using namespace detail;
+
+        // Query rows × key columns of one score tile. 64 × 128 floats of scores plus the Q, K, V panels of
+        // a 64-wide head stay inside L2 while the tile is reused by both GEMMs.
+        constexpr int QueryBlock = 64;
+        constexpr int KeyBlock = 128;
+
+        /// Row-major [B, T, E] tensors with H heads of D = E / H columns each; head h of batch b starts
+        /// at base + b·T·E + h·D and its rows are E apart, so GEMMs read it in place with lda = E.
+        struct AttentionGeometry
+        {
+            int batch, queries, keys, embed, heads, headDim;
+            bool causal;
+            float scale;
+
+            size_t queryOffset(int b, int h) const { return (size_t)b * queries * embed + (size_t)h * headDim; }
+            size_t keyOffset(int b, int h) const { return (size_t)b * keys * embed + (size_t)h * headDim; }
+            /// Keys visible to the query rows [i0, i0 + rows): causal masking hides key j > query i.
+            int keyEnd(int i0, int rows) const { return causal ? std::min(keys, i0 + rows) : keys; }
+        };
+
+        /// Scales a score tile and hides the keys after each query under causal masking.
+        void scaleAndMask(const AttentionGeometry& g, float* S, int i0, int rows, int j0, int cols)
+        {
+            for (int r = 0; r < rows; ++r)
+            {
+                float* row = S + (size_t)r * cols;
+                mapUnary(row, row, cols, [&](vf x) { return vmul(x, vset(g.scale)); });
+
+                if (g.causal)
+                    for (int c = std::max(0, i0 + r - j0 + 1); c < cols; ++c)
+                        row[c] = -std::numeric_limits<float>::infinity();
+            }
+        }
+
+        /// Forward of one (batch, head): online softmax over key blocks, never holding more than one
+        /// QueryBlock × KeyBlock tile of scores. Writes O and the log-sum-exp of every query row.
+        void attentionForward(const AttentionGeometry& g, int b, int h, const float* Q, const float* K, const float* V, float* O, float* logSumExp)
+        {
+            const Backend& be = backend();
+            const int E = g.embed, D = g.headDim;
+
+            Q += g.queryOffset(b, h);
+            O += g.queryOffset(b, h);
+            K += g.keyOffset(b, h);
+            V += g.keyOffset(b, h);
+
+            std::vector<float> S((size_t)QueryBlock * KeyBlock), acc((size_t)QueryBlock * D), rowMax(QueryBlock), rowSum(QueryBlock);
+
+            for (int i0 = 0; i0 < g.queries; i0 += QueryBlock)
+            {
+                const int rows = std::min(QueryBlock, g.queries - i0);
+                std::fill(acc.begin(), acc.end(), 0.0f);
+                std::fill(rowMax.begin(), rowMax.end(), -std::numeric_limits<float>::infinity());
+                std::fill(rowSum.begin(), rowSum.end(), 0.0f);
+
+                const int keyEnd = g.keyEnd(i0, rows);
+                for (int j0 = 0; j0 < keyEnd; j0 += KeyBlock)
+                {
+                    const int cols = std::min(KeyBlock, keyEnd - j0);
+
+                    // S = Q_i · K_j^T
+                    std::fill(S.begin(), S.begin() + (size_t)rows * cols, 0.0f);
+                    be.gemm(false, true, rows, cols, D, Q + (size_t)i0 * E, E, K + (size_t)j0 * E, E, S.data(), cols);
+                    scaleAndMask(g, S.data(), i0, rows, j0, cols);
+
+                    for (int r = 0; r < rows; ++r)
+                    {
+                        float* row = S.data() + (size_t)r * cols;
+                        float newMax = std::max(rowMax[r], *std::max_element(row, row + cols));
+
+                        // P = exp(S - m_new); exp(-inf) of masked keys flushes to 0
+                        mapUnary(row, row, cols, [newMax](vf x) { return vexp(vsub(x, vset(newMax))); });
+
+                        float sum = 0.0f;
+                        for (int c = 0; c < cols; ++c)
+                            sum += row[c];
+
+                        // Rescale what the earlier key blocks contributed to the new maximum
+                        float correction = std::exp(rowMax[r] - newMax);
+                        rowSum[r] = rowSum[r] * correction + sum;
+                        rowMax[r] = newMax;
+
+                        float* accRow = acc.data() + (size_t)r * D;
+                        for (int d = 0; d < D; ++d)
+                            accRow[d] *= correction;
+                    }
+
+                    // acc += P · V_j
+                    be.gemm(false, false, rows, D, cols, S.data(), cols, V + (size_t)j0 * E, E, acc.data(), D);
+                }
+
+                for (int r = 0; r < rows; ++r)
+                {
+                    float inverse = 1.0f / rowSum[r];
+                    float* out = O + (size_t)(i0 + r) * E;
+                    for (int d = 0; d < D; ++d)
+                        out[d] = acc[(size_t)r * D + d] * inverse;
+
+                    logSumExp[i0 + r] = rowMax[r] + std::log(rowSum[r]);
+                }
+            }
+        }
+
+        /// Backward of one (batch, head), recomputing each score tile from Q, K and the saved log-sum-exp
+        /// instead of keeping the probabilities. dQ, dK, dV (any may be null) are accumulated in place.
+        void attentionBackward(const AttentionGeometry& g, int b, int h, const float* Q, const float* K, const float* V, const float* O,
+            const float* dO, const float* logSumExp, float* dQ, float* dK, float* dV)
+        {
+            const Backend& be = backend();
+            const int E = g.embed, D = g.headDim;
+
+            const size_t qOffset = g.queryOffset(b, h), kOffset = g.keyOffset(b, h);
+            Q += qOffset; O += qOffset; dO += qOffset;
+            K += kOffset; V += kOffset;
+            if (dQ) dQ += qOffset;
+            if (dK) dK += kOffset;
+            if (dV) dV += kOffset;
+
+            // delta_i = dO_i · O_i, the softmax Jacobian's row term
+            std::vector<float> delta(g.queries);
+            for (int i = 0; i < g.queries; ++i)
+            {
+                float sum = 0.0f;
+                for (int d = 0; d < D; ++d)
+                    sum += dO[(size_t)i * E + d] * O[(size_t)i * E + d];
+                delta[i] = sum;
+            }
+
+            std::vector<float> P((size_t)QueryBlock * KeyBlock), dS((size_t)QueryBlock * KeyBlock);
+
+            for (int j0 = 0; j0 < g.keys; j0 += KeyBlock)
+            {
+                const int cols = std::min(KeyBlock, g.keys - j0);
+                // Under causal masking query blocks that end before j0 see none of these keys
+                const int iStart = g.causal ? j0 / QueryBlock * QueryBlock : 0;
+
+                for (int i0 = iStart; i0 < g.queries; i0 += QueryBlock)
+                {
+                    const int rows = std::min(QueryBlock, g.queries - i0);
+
+                    std::fill(P.begin(), P.begin() + (size_t)rows * cols, 0.0f);
+                    be.gemm(false, true, rows, cols, D, Q + (size_t)i0 * E, E, K + (size_t)j0 * E, E, P.data(), cols);
+                    scaleAndMask(g, P.data(), i0, rows, j0, cols);
+
+                    for (int r = 0; r < rows; ++r)
+                    {
+                        float* row = P.data() + (size_t)r * cols;
+                        float lse = logSumExp[i0 + r];
+                        mapUnary(row, row, cols, [lse](vf x) { return vexp(vsub(x, vset(lse))); });
+                    }
+
+                    // dV_j += P^T · dO_i
+                    if (dV)
+                        be.gemm(true, false, cols, D, rows, P.data(), cols, dO + (size_t)i0 * E, E, dV + (size_t)j0 * E, E);
+
+                    // dS = P ∘ (dO_i · V_j^T - delta) · scale
+                    std::fill(dS.begin(), dS.begin() + (size_t)rows * cols, 0.0f);
+                    be.gemm(false, true, rows, cols, D, dO + (size_t)i0 * E, E, V + (size_t)j0 * E, E, dS.data(), cols);
+
+                    for (int r = 0; r < rows; ++r)
+                    {
+                        const float* p = P.data() + (size_t)r * cols;
+                        float* ds = dS.data() + (size_t)r * cols;
+                        float d = delta[i0 + r];
+                        for (int c = 0; c < cols; ++c)
+                            ds[c] = p[c] * (ds[c] - d) * g.scale;
+                    }
+
+                    // dQ_i += dS · K_j,  dK_j += dS^T · Q_i
+                    if (dQ)
+                        be.gemm(false, false, rows, D, cols, dS.data(), cols, K + (size_t)j0 * E, E, dQ + (size_t)i0 * E, E);
+                    if (dK)
+                        be.gemm(true, false, cols, D, rows, dS.data(), cols, Q + (size_t)i0 * E, E, dK + (size_t)j0 * E, E);
+                }
+            }
+        }
+    }
+
+    #pragma region Attention
+
+    std::shared_ptr<Tensor> scaledDotProductAttention(const std::shared_ptr<Tensor>& q, const std::shared_ptr<Tensor>& k, const std::shared_ptr<Tensor>& v,
+        int heads, bool causal)
+    {
+        ProfileScope scope("attention", "forward");
+
+        const auto& sq = q -> getShape();
+        const auto& sk = k -> getShape();
+        if (sq.size() != 3 || sk.size() != 3 || v -> getShape() != sk)
+            throw std::invalid_argument("attention: expected q [B, Tq, E] and k, v [B, Tk, E]");
+        if (sq[0] != sk[0] || sq[2] != sk[2])
+            throw std::invalid_argument("attention: q, k and v must share batch and embedding sizes");
+        if (heads < 1 || sq[2] % heads != 0)
+            throw std::invalid_argument("attention: embedding size " + std::to_string(sq[2]) + " is not divisible into " + std::to_string(heads) + " heads");
+
+        AttentionGeometry g{ sq[0], sq[1], sk[1], sq[2], heads, sq[2] / heads, causal, 0.0f };
+        g.scale = 1.0f / std::sqrt((float)g.headDim);
+
+        bool requiresGrad = q -> requiresGradient || k -> requiresGradient || v -> requiresGradient;
+        auto result = std::make_shared<Tensor>(sq, 0.0f, requiresGrad);
+
+        // Log-sum-exp per (batch, head, query): all the backward pass needs to rebuild the probabilities.
+        auto logSumExp = std::make_shared<std::vector<float>>((size_t)g.batch * g.heads * g.queries);
+
+        const float* Q = q -> getData().data();
+        const float* K = k -> getData().data();
+        const float* V = v -> getData().data();
+        float* O = result -> getData().data();
+
+        ThreadPool::global().parallelFor(0, g.batch * g.heads, [&](int begin, int end)
+        {
+            for (int task = begin; task < end; ++task)
+                attentionForward(g, task / g.heads, task % g.heads, Q, K, V, O, logSumExp -> data() + (size_t)task * g.queries);
+        });
+
+        applyAutocast(result);
+
+        // Causal masking skips about half of the score tiles
+        double flops = 4.0 * g.batch * g.heads * g.queries * g.keys * g.headDim * (causal ? 0.5 : 1.0);
+
+        if (requiresGrad)
+        {
+            auto q_ptr = q, k_ptr = k, v_ptr = v;
+            auto result_ptr = result;
+
+            result -> setGradientFunction([q_ptr, k_ptr, v_ptr, result_ptr, logSumExp, g, flops, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("attention", "backward", layer);
+                scope.setCost(2.5 * flops, (double)(3 * q_ptr -> getTotalSize() + 4 * k_ptr -> getTotalSize()) * sizeof(float));
+
+                const float* Q = q_ptr -> getData().data();
+                const float* K = k_ptr -> getData().data();
+                const float* V = v_ptr -> getData().data();
+                const float* O = result_ptr -> getData().data();
+                const float* dO = result_ptr -> gradient.data();
+                float* dQ = q_ptr -> requiresGradient ? q_ptr -> gradient.data() : nullptr;
+                float* dK = k_ptr -> requiresGradient ? k_ptr -> gradient.data() : nullptr;
+                float* dV = v_ptr -> requiresGradient ? v_ptr -> gradient.data() : nullptr;
+
+                // Each (batch, head) owns its columns of dQ, dK and dV, so the tasks never write the same float.
+                ThreadPool::global().parallelFor(0, g.batch * g.heads, [&](int begin, int end)
+                {
+                    for (int task = begin; task < end; ++task)
+                        attentionBackward(g, task / g.heads, task % g.heads, Q, K, V, O, dO, logSumExp -> data() + (size_t)task * g.queries, dQ, dK, dV);
+                });
+            }, { q_ptr, k_ptr, v_ptr });
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(flops, (double)(2 * q -> getTotalSize() + 2 * k -> getTotalSize()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    #pragma endregion
+}
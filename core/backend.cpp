@@ -0,0 +1,323 @@
+#include <cmath>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "backend.h"
+
+#ifdef SUSHIAI_USE_BLAS
+#if __has_include(<mkl_cblas.h>)
+#include <mkl_cblas.h>
+#else
+#include <cblas.h>
+#endif
+#endif
+
+namespace SushiAI
+{
+    #pragma region Reference Kernels
+
+    namespace
+    {
+        void referenceGemm(bool transA, bool transB, int m, int n, int k, const float* A, int lda, const float* B, int ldb, float* C, int ldc)
+        {
+            auto a = [&](int i, int l) { return transA ? A[(size_t)l * lda + i] : A[(size_t)i * lda + l]; };
+            auto b = [&](int l, int j) { return transB ? B[(size_t)j * ldb + l] : B[(size_t)l * ldb + j]; };
+
+            if (!transA && !transB)
+            {
+                // i-k-j order: rows of B and C are streamed, every C element accumulates over k in ascending order
+                for (int i = 0; i < m; ++i)
+                    for (int l = 0; l < k; ++l)
+                    {
+                        float av = A[(size_t)i * lda + l];
+                        for (int j = 0; j < n; ++j)
+                            C[(size_t)i * ldc + j] += av * B[(size_t)l * ldb + j];
+                    }
+
+                return;
+            }
+
+            // Dot-product form, summed into a local before touching C
+            for (int i = 0; i < m; ++i)
+                for (int j = 0; j < n; ++j)
+                {
+                    float sum = 0.0f;
+                    for (int l = 0; l < k; ++l)
+                        sum += a(i, l) * b(l, j);
+
+                    C[(size_t)i * ldc + j] += sum;
+                }
+        }
+
+        void referenceGemmBatched(bool transA, bool transB, int m, int n, int k, const float* A, size_t strideA,
+            const float* B, size_t strideB, float* C, size_t strideC, int batch)
+        {
+            int lda = transA ? m : k, ldb = transB ? k : n;
+            for (int b = 0; b < batch; ++b)
+                referenceGemm(transA, transB, m, n, k, A + b * strideA, lda, B + b * strideB, ldb, C + b * strideC, n);
+        }
+
+        void referenceAdd(const float* a, const float* b, float* y, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                y[i] = a[i] + b[i];
+        }
+
+        void referenceAddRow(const float* a, const float* row, float* y, int rows, int cols)
+        {
+            for (int r = 0; r < rows; ++r)
+                for (int c = 0; c < cols; ++c)
+                    y[(size_t)r * cols + c] = a[(size_t)r * cols + c] + row[c];
+        }
+
+        void referenceAccumulate(const float* x, float* y, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                y[i] += x[i];
+        }
+
+        void referenceAccumulateRows(const float* x, float* y, int rows, int cols)
+        {
+            for (int r = 0; r < rows; ++r)
+                for (int c = 0; c < cols; ++c)
+                    y[c] += x[(size_t)r * cols + c];
+        }
+
+        void referenceRelu(const float* x, float* y, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                y[i] = std::max(0.0f, x[i]);
+        }
+
+        void referenceReluBackward(const float* y, const float* dy, float* dx, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                dx[i] += (y[i] > 0 ? 1.0f : 0.0f) * dy[i];
+        }
+
+        void referenceLeakyRelu(const float* x, float* y, size_t n, float alpha)
+        {
+            for (size_t i = 0; i < n; ++i)
+                y[i] = (x[i] > 0.0f ? x[i] : alpha * x[i]);
+        }
+
+        void referenceLeakyReluBackward(const float* x, const float* dy, float* dx, size_t n, float alpha)
+        {
+            for (size_t i = 0; i < n; ++i)
+                dx[i] += (x[i] > 0.0f ? 1.0f : alpha) * dy[i];
+        }
+
+        void referenceSigmoid(const float* x, float* y, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                y[i] = 1.0f / (1.0f + std::exp(-x[i]));
+        }
+
+        void referenceSigmoidBackward(const float* y, const float* dy, float* dx, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                dx[i] += y[i] * (1 - y[i]) * dy[i];
+        }
+
+        void referenceTanh(const float* x, float* y, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                y[i] = std::tanh(x[i]);
+        }
+
+        void referenceTanhBackward(const float* y, const float* dy, float* dx, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                dx[i] += (1.0f - y[i] * y[i]) * dy[i];
+        }
+
+        void referenceSoftmax(const float* x, float* y, size_t n)
+        {
+            float maxV = *std::max_element(x, x + n);
+            float sumExp = 0.0f;
+            for (size_t i = 0; i < n; ++i)
+            {
+                y[i] = std::exp(x[i] - maxV);
+                sumExp += y[i];
+            }
+
+            for (size_t i = 0; i < n; ++i)
+                y[i] /= sumExp;
+        }
+    }
+
+    const Backend& referenceBackend()
+    {
+        static const Backend instance =
+        {
+            BackendKind::Reference, "reference",
+            referenceGemm, referenceGemmBatched,
+            referenceAdd, referenceAddRow, referenceAccumulate, referenceAccumulateRows,
+            referenceRelu, referenceReluBackward, referenceLeakyRelu, referenceLeakyReluBackward,
+            referenceSigmoid, referenceSigmoidBackward, referenceTanh, referenceTanhBackward,
+            referenceSoftmax
+        };
+
+        return instance;
+    }
+
+    #pragma endregion
+
+    #pragma region Backend Selection
+
+    namespace
+    {
+        const Backend* lookup(BackendKind kind)
+        {
+            switch (kind)
+            {
+                case BackendKind::Reference: return &referenceBackend();
+                case BackendKind::Simd:      return &simdBackend();
+                case BackendKind::Blas:      return blasBackend();
+            }
+
+            return nullptr;
+        }
+
+        const Backend* initialBackend()
+        {
+            BackendKind kind;
+            const char* requested = std::getenv("SUSHIAI_BACKEND");
+            if (requested && parseBackend(requested, kind) && lookup(kind))
+                return lookup(kind);
+
+            if (blasBackend())
+                return blasBackend();
+
+            return &simdBackend();
+        }
+
+        std::atomic<const Backend*>& active()
+        {
+            static std::atomic<const Backend*> current{ initialBackend() };
+            return current;
+        }
+    }
+
+    const Backend& backend()
+    {
+        return *active().load(std::memory_order_relaxed);
+    }
+
+    bool setBackend(BackendKind kind)
+    {
+        const Backend* selected = lookup(kind);
+        if (!selected)
+            return false;
+
+        active().store(selected, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    bool backendAvailable(BackendKind kind)
+    {
+        return lookup(kind) != nullptr;
+    }
+
+    const char* backendName(BackendKind kind)
+    {
+        switch (kind)
+        {
+            case BackendKind::Reference: return "reference";
+            case BackendKind::Simd:      return "simd";
+            case BackendKind::Blas:      return "blas";
+        }
+
+        return "?";
+    }
+
+    bool parseBackend(const char* text, BackendKind& kind)
+    {
+        for (BackendKind k : { BackendKind::Reference, BackendKind::Simd, BackendKind::Blas })
+        {
+            if (std::strcmp(text, backendName(k)) == 0)
+            {
+                kind = k;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    BackendGuard::BackendGuard(BackendKind kind) : previous(backend().kind)
+    {
+        setBackend(kind);
+    }
+
+    BackendGuard::~BackendGuard()
+    {
+        setBackend(previous);
+    }
+
+    #pragma endregion
+
+    #pragma region External BLAS
+
+    #ifdef SUSHIAI_USE_BLAS
+
+    namespace
+    {
+        void blasGemm(bool transA, bool transB, int m, int n, int k, const float* A, int lda, const float* B, int ldb, float* C, int ldc)
+        {
+            if (m <= 0 || n <= 0 || k <= 0)
+                return;
+
+            // beta = 1: sgemm accumulates into C like every other backend
+            cblas_sgemm(CblasRowMajor, transA ? CblasTrans : CblasNoTrans, transB ? CblasTrans : CblasNoTrans,
+                m, n, k, 1.0f, A, lda, B, ldb, 1.0f, C, ldc);
+        }
+
+        void blasGemmBatched(bool transA, bool transB, int m, int n, int k, const float* A, size_t strideA,
+            const float* B, size_t strideB, float* C, size_t strideC, int batch)
+        {
+            if (m <= 0 || n <= 0 || k <= 0 || batch <= 0)
+                return;
+
+            int lda = transA ? m : k, ldb = transB ? k : n;
+
+            #if defined(INTEL_MKL_VERSION) && INTEL_MKL_VERSION >= 20210000
+            cblas_sgemm_batch_strided(CblasRowMajor, transA ? CblasTrans : CblasNoTrans, transB ? CblasTrans : CblasNoTrans,
+                m, n, k, 1.0f, A, lda, (MKL_INT)strideA, B, ldb, (MKL_INT)strideB, 1.0f, C, n, (MKL_INT)strideC, batch);
+            #else
+            for (int b = 0; b < batch; ++b)
+                blasGemm(transA, transB, m, n, k, A + b * strideA, lda, B + b * strideB, ldb, C + b * strideC, n);
+            #endif
+        }
+    }
+
+    const Backend* blasBackend()
+    {
+        // Vendor sgemm for the GEMMs; the elementwise kernels are the SIMD ones.
+        static const Backend instance = []()
+        {
+            Backend b = simdBackend();
+            b.kind = BackendKind::Blas;
+            b.name = "blas";
+            b.gemm = blasGemm;
+            b.gemmBatched = blasGemmBatched;
+
+            return b;
+        }();
+
+        return &instance;
+    }
+
+    #else
+
+    const Backend* blasBackend()
+    {
+        return nullptr;
+    }
+
+    #endif
+
+    #pragma endregion
+}
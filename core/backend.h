@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+
+namespace SushiAI
+{
+    enum class BackendKind
+    {
+        Reference,  // plain loops, the accumulation order the ops were written with
+        Simd,       // packed, register-blocked GEMM and vectorized elementwise kernels
+        Blas        // external sgemm for the GEMMs, SIMD kernels for the rest (needs SUSHIAI_USE_BLAS)
+    };
+
+    /// Kernel table the ops dispatch through. All matrices are row-major; `ld*` is the row stride in floats.
+    /// Backward kernels accumulate into their output (dx += ...), like the gradient functions do.
+    struct Backend
+    {
+        BackendKind kind;
+        const char* name;
+
+        #pragma region GEMM
+
+        /// C[m, n] += op(A) · op(B) where op(A) is [m, k] and op(B) is [k, n].
+        /// transA: A is stored as [k, m]; transB: B is stored as [n, k].
+        void (*gemm)(bool transA, bool transB, int m, int n, int k, const float* A, int lda, const float* B, int ldb, float* C, int ldc);
+        /// `batch` independent contiguous GEMMs whose operands lie strideA / strideB / strideC floats apart.
+        void (*gemmBatched)(bool transA, bool transB, int m, int n, int k, const float* A, size_t strideA,
+            const float* B, size_t strideB, float* C, size_t strideC, int batch);
+
+        #pragma endregion
+
+        #pragma region Elementwise
+
+        /// y = a + b
+        void (*add)(const float* a, const float* b, float* y, size_t n);
+        /// y[r, c] = a[r, c] + row[c]
+        void (*addRow)(const float* a, const float* row, float* y, int rows, int cols);
+        /// y += x
+        void (*accumulate)(const float* x, float* y, size_t n);
+        /// y[c] += Σ_r x[r, c]
+        void (*accumulateRows)(const float* x, float* y, int rows, int cols);
+
+        void (*relu)(const float* x, float* y, size_t n);
+        /// dx += (y > 0) · dy
+        void (*reluBackward)(const float* y, const float* dy, float* dx, size_t n);
+        void (*leakyRelu)(const float* x, float* y, size_t n, float alpha);
+        /// dx += (x > 0 ? 1 : alpha) · dy
+        void (*leakyReluBackward)(const float* x, const float* dy, float* dx, size_t n, float alpha);
+        void (*sigmoid)(const float* x, float* y, size_t n);
+        /// dx += y (1 - y) · dy
+        void (*sigmoidBackward)(const float* y, const float* dy, float* dx, size_t n);
+        void (*tanh)(const float* x, float* y, size_t n);
+        /// dx += (1 - y²) · dy
+        void (*tanhBackward)(const float* y, const float* dy, float* dx, size_t n);
+        /// Numerically stable softmax over all n values.
+        void (*softmax)(const float* x, float* y, size_t n);
+
+        #pragma endregion
+    };
+
+    #pragma region Backend Selection
+
+    /// The active backend. Initially the one named by the SUSHIAI_BACKEND environment variable
+    /// ("reference", "simd", "blas"), otherwise the fastest one compiled in.
+    const Backend& backend();
+    /// Switches every op to the given backend. Returns false (and keeps the current one) if it is not compiled in.
+    bool setBackend(BackendKind kind);
+    bool backendAvailable(BackendKind kind);
+    const char* backendName(BackendKind kind);
+    /// Parses "reference" / "simd" / "blas". Returns false for anything else.
+    bool parseBackend(const char* text, BackendKind& kind);
+
+    /// Uses a backend for the lifetime of the guard, restoring the previous one afterwards.
+    class BackendGuard
+    {
+        private:
+            BackendKind previous;
+
+        public:
+            explicit BackendGuard(BackendKind kind);
+            ~BackendGuard();
+
+            BackendGuard(const BackendGuard&) = delete;
+            BackendGuard& operator=(const BackendGuard&) = delete;
+    };
+
+    #pragma endregion
+
+    #pragma region Backend Implementations
+
+    const Backend& referenceBackend();
+    const Backend& simdBackend();
+    /// nullptr unless built with SUSHIAI_USE_BLAS.
+    const Backend* blasBackend();
+
+    #pragma endregion
+}
@@ -0,0 +1,367 @@
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "tensor.h"
+#include "ops.h"
+#include "opsdetail.h"
+#include "profiler.h"
+#include "backend.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using namespace detail;
+
+        struct ConvGeometry
+        {
+            int batch, channels, height, width;
+            int outChannels, kernelH, kernelW;
+            int stride, padding, dilation, groups;
+            int outH, outW;
+
+            int groupChannels() const { return channels / groups; }
+            int groupOutChannels() const { return outChannels / groups; }
+            /// Rows of the im2col matrix of one group: (channel, kernel row, kernel column).
+            int patchSize() const { return groupChannels() * kernelH * kernelW; }
+            int outPlane() const { return outH * outW; }
+            int inPlane() const { return height * width; }
+
+            /// 1×1, stride 1, no padding: the input plane already is the im2col matrix.
+            bool pointwise() const { return kernelH == 1 && kernelW == 1 && stride == 1 && padding == 0; }
+            /// One input channel per group (depthwise, optionally with a channel multiplier).
+            bool depthwise() const { return groupChannels() == 1 && groups > 1; }
+
+            /// Output columns [begin, end) whose tap at kernel offset `offset` lands inside [0, size).
+            void validRange(int offset, int size, int outSize, int& begin, int& end) const
+            {
+                detail::validRange(offset * dilation - padding, stride, size, outSize, begin, end);
+            }
+        };
+
+        ConvGeometry geometry(const std::vector<int>& x, const std::vector<int>& w, int stride, int padding, int dilation, int groups)
+        {
+            if (x.size() != 4 || w.size() != 4)
+                throw std::invalid_argument("conv2d: expected input [N, C, H, W] and weight [C_out, C_in / groups, kH, kW]");
+            if (stride < 1 || dilation < 1 || padding < 0 || groups < 1)
+                throw std::invalid_argument("conv2d: stride and dilation must be >= 1, padding >= 0, groups >= 1");
+            if (x[1] % groups != 0 || w[0] % groups != 0 || w[1] != x[1] / groups)
+                throw std::invalid_argument("conv2d: " + std::to_string(x[1]) + " input channels and " + std::to_string(w[0])
+                    + " output channels do not split into " + std::to_string(groups) + " groups of the weight's " + std::to_string(w[1]) + " channels");
+
+            ConvGeometry g{ x[0], x[1], x[2], x[3], w[0], w[2], w[3], stride, padding, dilation, groups, 0, 0 };
+            g.outH = (g.height + 2 * padding - dilation * (g.kernelH - 1) - 1) / stride + 1;
+            g.outW = (g.width + 2 * padding - dilation * (g.kernelW - 1) - 1) / stride + 1;
+
+            if (g.outH <= 0 || g.outW <= 0)
+                throw std::invalid_argument("conv2d: kernel larger than the padded input");
+
+            return g;
+        }
+
+        #pragma region im2col
+
+        /// col[(c, ki, kj), (oh, ow)] = x[c, oh * stride + ki * dilation - padding, ...], zero outside the input.
+        void im2col(const ConvGeometry& g, const float* x, float* col)
+        {
+            const int outPlane = g.outPlane();
+
+            for (int c = 0; c < g.groupChannels(); ++c)
+                for (int ki = 0; ki < g.kernelH; ++ki)
+                    for (int kj = 0; kj < g.kernelW; ++kj)
+                    {
+                        const float* xc = x + (size_t)c * g.inPlane();
+                        float* row = col + ((size_t)(c * g.kernelH + ki) * g.kernelW + kj) * outPlane;
+
+                        int ohBegin, ohEnd, owBegin, owEnd;
+                        g.validRange(ki, g.height, g.outH, ohBegin, ohEnd);
+                        g.validRange(kj, g.width, g.outW, owBegin, owEnd);
+                        int shiftW = kj * g.dilation - g.padding;
+
+                        std::fill(row, row + (size_t)ohBegin * g.outW, 0.0f);
+                        for (int oh = ohBegin; oh < ohEnd; ++oh)
+                        {
+                            const float* xRow = xc + (size_t)(oh * g.stride + ki * g.dilation - g.padding) * g.width;
+                            float* out = row + (size_t)oh * g.outW;
+
+                            std::fill(out, out + owBegin, 0.0f);
+                            if (g.stride == 1)
+                                std::copy(xRow + owBegin + shiftW, xRow + owEnd + shiftW, out + owBegin);
+                            else
+                                for (int ow = owBegin; ow < owEnd; ++ow)
+                                    out[ow] = xRow[ow * g.stride + shiftW];
+                            std::fill(out + owEnd, out + g.outW, 0.0f);
+                        }
+                        std::fill(row + (size_t)ohEnd * g.outW, row + outPlane, 0.0f);
+                    }
+        }
+
+        /// Transpose of im2col: dx[c, ih, iw] += every dcol entry that was read from it.
+        void col2im(const ConvGeometry& g, const float* col, float* dx)
+        {
+            const int outPlane = g.outPlane();
+
+            for (int c = 0; c < g.groupChannels(); ++c)
+                for (int ki = 0; ki < g.kernelH; ++ki)
+                    for (int kj = 0; kj < g.kernelW; ++kj)
+                    {
+                        float* dxc = dx + (size_t)c * g.inPlane();
+                        const float* row = col + ((size_t)(c * g.kernelH + ki) * g.kernelW + kj) * outPlane;
+
+                        int ohBegin, ohEnd, owBegin, owEnd;
+                        g.validRange(ki, g.height, g.outH, ohBegin, ohEnd);
+                        g.validRange(kj, g.width, g.outW, owBegin, owEnd);
+                        int shiftW = kj * g.dilation - g.padding;
+
+                        for (int oh = ohBegin; oh < ohEnd; ++oh)
+                        {
+                            float* dxRow = dxc + (size_t)(oh * g.stride + ki * g.dilation - g.padding) * g.width;
+                            const float* in = row + (size_t)oh * g.outW;
+
+                            for (int ow = owBegin; ow < owEnd; ++ow)
+                                dxRow[ow * g.stride + shiftW] += in[ow];
+                        }
+                    }
+        }
+
+        #pragma endregion
+
+        #pragma region Depthwise
+
+        // With one input channel per group the GEMM degenerates to kH·kW scaled row additions per output
+        // channel; doing them directly skips the im2col copy, which would be as large as the work itself.
+
+        void depthwiseForward(const ConvGeometry& g, const float* x, const float* w, float* y)
+        {
+            const int multiplier = g.groupOutChannels();
+
+            for (int n = 0; n < g.batch; ++n)
+                for (int k = 0; k < g.outChannels; ++k)
+                {
+                    const float* xc = x + ((size_t)n * g.channels + k / multiplier) * g.inPlane();
+                    const float* wk = w + (size_t)k * g.kernelH * g.kernelW;
+                    float* yk = y + ((size_t)n * g.outChannels + k) * g.outPlane();
+
+                    for (int ki = 0; ki < g.kernelH; ++ki)
+                        for (int kj = 0; kj < g.kernelW; ++kj)
+                        {
+                            const float weight = wk[ki * g.kernelW + kj];
+                            int ohBegin, ohEnd, owBegin, owEnd;
+                            g.validRange(ki, g.height, g.outH, ohBegin, ohEnd);
+                            g.validRange(kj, g.width, g.outW, owBegin, owEnd);
+                            int shiftW = kj * g.dilation - g.padding;
+
+                            for (int oh = ohBegin; oh < ohEnd; ++oh)
+                            {
+                                const float* xRow = xc + (size_t)(oh * g.stride + ki * g.dilation - g.padding) * g.width + shiftW;
+                                float* yRow = yk + (size_t)oh * g.outW;
+
+                                if (g.stride == 1)
+                                    for (int ow = owBegin; ow < owEnd; ++ow)
+                                        yRow[ow] += weight * xRow[ow];
+                                else
+                                    for (int ow = owBegin; ow < owEnd; ++ow)
+                                        yRow[ow] += weight * xRow[ow * g.stride];
+                            }
+                        }
+                }
+        }
+
+        /// dx and dw may be null when the corresponding tensor needs no gradient.
+        void depthwiseBackward(const ConvGeometry& g, const float* x, const float* w, const float* dy, float* dx, float* dw)
+        {
+            const int multiplier = g.groupOutChannels();
+
+            for (int n = 0; n < g.batch; ++n)
+                for (int k = 0; k < g.outChannels; ++k)
+                {
+                    size_t inOffset = ((size_t)n * g.channels + k / multiplier) * g.inPlane();
+                    const float* dyk = dy + ((size_t)n * g.outChannels + k) * g.outPlane();
+
+                    for (int ki = 0; ki < g.kernelH; ++ki)
+                        for (int kj = 0; kj < g.kernelW; ++kj)
+                        {
+                            const int tap = (k * g.kernelH + ki) * g.kernelW + kj;
+                            const float weight = w[tap];
+                            float weightGrad = 0.0f;
+
+                            int ohBegin, ohEnd, owBegin, owEnd;
+                            g.validRange(ki, g.height, g.outH, ohBegin, ohEnd);
+                            g.validRange(kj, g.width, g.outW, owBegin, owEnd);
+                            int shiftW = kj * g.dilation - g.padding;
+
+                            for (int oh = ohBegin; oh < ohEnd; ++oh)
+                            {
+                                size_t rowOffset = inOffset + (size_t)(oh * g.stride + ki * g.dilation - g.padding) * g.width + shiftW;
+                                const float* dyRow = dyk + (size_t)oh * g.outW;
+
+                                if (dw)
+                                {
+                                    const float* xRow = x + rowOffset;
+                                    for (int ow = owBegin; ow < owEnd; ++ow)
+                                        weightGrad += dyRow[ow] * xRow[ow * g.stride];
+                                }
+
+                                if (dx)
+                                {
+                                    float* dxRow = dx + rowOffset;
+                                    for (int ow = owBegin; ow < owEnd; ++ow)
+                                        dxRow[ow * g.stride] += weight * dyRow[ow];
+                                }
+                            }
+
+                            if (dw)
+                                dw[tap] += weightGrad;
+                        }
+                }
+        }
+
+        #pragma endregion
+    }
+
+    #pragma region Convolution
+
+    std::shared_ptr<Tensor> conv2d(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& weight, const std::shared_ptr<Tensor>& bias,
+        int stride, int padding, int dilation, int groups)
+    {
+        ProfileScope scope("conv2d", "forward");
+
+        const ConvGeometry g = geometry(input -> getShape(), weight -> getShape(), stride, padding, dilation, groups);
+        if (bias && bias -> getTotalSize() != g.outChannels)
+            throw std::invalid_argument("conv2d: bias must have " + std::to_string(g.outChannels) + " elements");
+
+        bool requiresGrad = input -> requiresGradient || weight -> requiresGradient || (bias && bias -> requiresGradient);
+        auto result = std::make_shared<Tensor>(std::vector<int>{ g.batch, g.outChannels, g.outH, g.outW }, 0.0f, requiresGrad);
+
+        const float* X = input -> getData().data();
+        const float* Wt = weight -> getData().data();
+        float* Y = result -> getData().data();
+
+        const int Kg = g.groupOutChannels(), P = g.patchSize(), O = g.outPlane();
+
+        if (g.depthwise())
+            depthwiseForward(g, X, Wt, Y);
+        else
+        {
+            const Backend& be = backend();
+            std::vector<float> col(g.pointwise() ? 0 : (size_t)P * O);
+
+            for (int n = 0; n < g.batch; ++n)
+                for (int gr = 0; gr < g.groups; ++gr)
+                {
+                    const float* xg = X + ((size_t)n * g.channels + gr * g.groupChannels()) * g.inPlane();
+                    float* yg = Y + ((size_t)n * g.outChannels + gr * Kg) * O;
+
+                    if (!g.pointwise())
+                        im2col(g, xg, col.data());
+
+                    // y_g[Kg, OH·OW] += W_g[Kg, C/groups·kH·kW] · col[C/groups·kH·kW, OH·OW]
+                    be.gemm(false, false, Kg, O, P, Wt + (size_t)gr * Kg * P, P, g.pointwise() ? xg : col.data(), O, yg, O);
+                }
+        }
+
+        if (bias)
+        {
+            const float* B = bias -> getData().data();
+            for (int n = 0; n < g.batch; ++n)
+                for (int k = 0; k < g.outChannels; ++k)
+                {
+                    float* yk = Y + ((size_t)n * g.outChannels + k) * O;
+                    for (int i = 0; i < O; ++i)
+                        yk[i] += B[k];
+                }
+        }
+
+        applyAutocast(result);
+
+        double flops = 2.0 * g.batch * g.outChannels * O * P;
+
+        if (requiresGrad)
+        {
+            auto input_ptr = input;
+            auto weight_ptr = weight;
+            auto bias_ptr = bias;
+            auto result_ptr = result;
+
+            std::vector<std::shared_ptr<Tensor>> parents = { input_ptr, weight_ptr };
+            if (bias_ptr)
+                parents.push_back(bias_ptr);
+
+            result -> setGradientFunction([input_ptr, weight_ptr, bias_ptr, result_ptr, g, flops, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("conv2d", "backward", layer);
+                scope.setCost(2.0 * flops, (double)(input_ptr -> getTotalSize() * 2 + weight_ptr -> getTotalSize() * 2 + result_ptr -> getTotalSize()) * sizeof(float));
+
+                const int Kg = g.groupOutChannels(), P = g.patchSize(), O = g.outPlane();
+                const float* X = input_ptr -> getData().data();
+                const float* Wt = weight_ptr -> getData().data();
+                const float* dY = result_ptr -> gradient.data();
+                float* dX = input_ptr -> requiresGradient ? input_ptr -> gradient.data() : nullptr;
+                float* dW = weight_ptr -> requiresGradient ? weight_ptr -> gradient.data() : nullptr;
+
+                if (g.depthwise())
+                    depthwiseBackward(g, X, Wt, dY, dX, dW);
+                else if (dX || dW)
+                {
+                    const Backend& be = backend();
+                    std::vector<float> col(g.pointwise() ? 0 : (size_t)P * O);
+
+                    for (int n = 0; n < g.batch; ++n)
+                        for (int gr = 0; gr < g.groups; ++gr)
+                        {
+                            size_t inOffset = ((size_t)n * g.channels + gr * g.groupChannels()) * g.inPlane();
+                            const float* dyg = dY + ((size_t)n * g.outChannels + gr * Kg) * O;
+                            const float* wg = Wt + (size_t)gr * Kg * P;
+
+                            if (dW)
+                            {
+                                // dW_g += dy_g · col^T (col is rebuilt rather than kept from the forward pass)
+                                if (!g.pointwise())
+                                    im2col(g, X + inOffset, col.data());
+                                be.gemm(false, true, Kg, P, O, dyg, O, g.pointwise() ? X + inOffset : col.data(), O, dW + (size_t)gr * Kg * P, P);
+                            }
+
+                            if (dX)
+                            {
+                                // dcol = W_g^T · dy_g, scattered back onto the input by col2im
+                                if (g.pointwise())
+                                    be.gemm(true, false, P, O, Kg, wg, P, dyg, O, dX + inOffset, O);
+                                else
+                                {
+                                    std::fill(col.begin(), col.end(), 0.0f);
+                                    be.gemm(true, false, P, O, Kg, wg, P, dyg, O, col.data(), O);
+                                    col2im(g, col.data(), dX + inOffset);
+                                }
+                            }
+                        }
+                }
+
+                if (bias_ptr && bias_ptr -> requiresGradient)
+                {
+                    auto& dB = bias_ptr -> gradient;
+                    for (int n = 0; n < g.batch; ++n)
+                        for (int k = 0; k < g.outChannels; ++k)
+                        {
+                            const float* dyk = dY + ((size_t)n * g.outChannels + k) * O;
+                            float sum = 0.0f;
+                            for (int i = 0; i < O; ++i)
+                                sum += dyk[i];
+                            dB[k] += sum;
+                        }
+                }
+            }, parents);
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(flops, (double)(input -> getTotalSize() + weight -> getTotalSize() + result -> getTotalSize()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    #pragma endregion
+}
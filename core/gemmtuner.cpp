@@ -0,0 +1,343 @@
+#include <map>
+#include <set>
+#include <tuple>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include "gemmtuner.h"
+#include "machine.h"
+
+namespace SushiAI
+{
+    std::atomic<bool> GemmTuner::enabled{ std::getenv("SUSHIAI_GEMM_TUNE") != nullptr };
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct TunedEntry
+        {
+            GemmConfig config;
+            double gflops = 0.0;
+        };
+
+        struct TunerState
+        {
+            std::mutex mutex;
+            std::string path;
+            bool tuneMissing = true;
+            bool loaded = false;
+            std::map<std::string, TunedEntry> table;
+            /// Classes some thread is tuning right now; other threads use the defaults meanwhile.
+            std::set<std::string> tuning;
+        };
+
+        TunerState& state()
+        {
+            static TunerState instance;
+            return instance;
+        }
+
+        /// Bumped by enable() and reset(): per-thread copies of the table older than this are dropped.
+        std::atomic<unsigned> generation{ 0 };
+
+        /// Per-thread copy of the configurations this thread has already looked up, so the steady state
+        /// of select() is a hash lookup without locks or string keys.
+        struct LocalCache
+        {
+            unsigned generation = ~0u;
+            std::unordered_map<unsigned long long, GemmConfig> configs;
+        };
+
+        /// Cache section of this machine: tile sizes tuned for one CPU or instruction set don't carry over to another.
+        const std::string& sectionHeader()
+        {
+            static const std::string header = "[" + cpuModelName() + " | " + simdIsa() + "]";
+            return header;
+        }
+
+        int bucket(int x)
+        {
+            if (x <= 4)
+                return x;
+
+            int b = 8;
+            while (b < x && b < 4096)
+                b *= 2;
+
+            return b;
+        }
+
+        #pragma region Cache File
+
+        void load(TunerState& s)
+        {
+            std::ifstream file(s.path);
+            std::string line;
+            bool inSection = false;
+
+            while (std::getline(file, line))
+            {
+                if (line.empty() || line[0] == '#')
+                    continue;
+
+                if (line[0] == '[')
+                {
+                    inSection = line == sectionHeader();
+                    continue;
+                }
+
+                if (!inSection)
+                    continue;
+
+                std::istringstream in(line);
+                std::string key, kernel;
+                TunedEntry entry;
+                if (in >> key >> kernel >> entry.config.mc >> entry.config.kc >> entry.config.nc >> entry.gflops)
+                {
+                    entry.config.kernel = kernel == "direct" ? GemmKernel::Direct : GemmKernel::Packed;
+                    s.table[key] = entry;
+                }
+            }
+        }
+
+        /// Rewrites this machine's section, keeping every other machine's section as it was.
+        void save(const TunerState& s)
+        {
+            std::vector<std::string> kept;
+            {
+                std::ifstream file(s.path);
+                std::string line;
+                bool inSection = false;
+
+                while (std::getline(file, line))
+                {
+                    if (!line.empty() && line[0] == '[')
+                        inSection = line == sectionHeader();
+                    if (!inSection && !(line.empty() || line[0] == '#'))
+                        kept.push_back(line);
+                }
+            }
+
+            std::ofstream file(s.path);
+            if (!file)
+            {
+                std::cerr << "GemmTuner: cannot write " << s.path << "\n";
+                return;
+            }
+
+            file << "# SushiAI GEMM tuning cache: <trans/m/n/k class> <kernel> <mc> <kc> <nc> <GFLOP/s>\n";
+            for (auto& line : kept)
+                file << line << "\n";
+
+            file << sectionHeader() << "\n";
+            for (auto& [key, entry] : s.table)
+                file << key << " " << (entry.config.kernel == GemmKernel::Direct ? "direct" : "packed") << " "
+                    << entry.config.mc << " " << entry.config.kc << " " << entry.config.nc << " "
+                    << std::fixed << std::setprecision(2) << entry.gflops << "\n";
+        }
+
+        #pragma endregion
+
+        #pragma region Tuning
+
+        /// Best time per call over a few batches of calls, each batch long enough (~20 us) to time reliably.
+        double secondsPerCall(const GemmConfig& config, bool transA, bool transB, int m, int n, int k,
+            const float* A, const float* B, float* C)
+        {
+            int lda = transA ? m : k, ldb = transB ? k : n;
+            auto call = [&]() { simdGemmWith(config, transA, transB, m, n, k, A, lda, B, ldb, C, n); };
+
+            auto start = Clock::now();
+            call();
+            double once = std::max(1e-9, std::chrono::duration<double>(Clock::now() - start).count());
+            int reps = std::max(1, (int)(20e-6 / once));
+
+            double best = 1e30, total = 0.0;
+            for (int batch = 0; batch < 3 || (total < 2e-3 && batch < 20); ++batch)
+            {
+                start = Clock::now();
+                for (int r = 0; r < reps; ++r)
+                    call();
+                double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+                best = std::min(best, elapsed / reps);
+                total += elapsed;
+            }
+
+            return best;
+        }
+
+        TunedEntry tune(bool transA, bool transB, int m, int n, int k)
+        {
+            std::vector<float> A((size_t)m * k, 0.5f), B((size_t)k * n, 0.25f), C((size_t)m * n, 0.0f);
+
+            std::vector<GemmConfig> candidates;
+            candidates.push_back({ GemmKernel::Direct, 0, 0, 0 });
+
+            for (int mc : { 48, 96, 192 })
+                for (int kc : { 128, 256, 512 })
+                    for (int nc : { 512, 2048 })
+                    {
+                        // Tiles larger than the problem behave alike: time only the first of them.
+                        GemmConfig c{ GemmKernel::Packed, mc, kc, nc };
+                        auto clipped = [&](const GemmConfig& x) { return std::make_tuple(std::min(x.mc, m), std::min(x.kc, k), std::min(x.nc, n)); };
+                        bool duplicate = std::any_of(candidates.begin(), candidates.end(), [&](const GemmConfig& other)
+                        {
+                            return other.kernel == GemmKernel::Packed && clipped(other) == clipped(c);
+                        });
+
+                        if (!duplicate)
+                            candidates.push_back(c);
+                    }
+
+            TunedEntry best;
+            double bestSeconds = 1e30;
+            for (auto& candidate : candidates)
+            {
+                double seconds = secondsPerCall(candidate, transA, transB, m, n, k, A.data(), B.data(), C.data());
+                if (seconds < bestSeconds)
+                {
+                    bestSeconds = seconds;
+                    best.config = candidate;
+                }
+            }
+
+            best.gflops = 2.0 * m * n * k / bestSeconds * 1e-9;
+
+            return best;
+        }
+
+        #pragma endregion
+    }
+
+    void GemmTuner::enable(const std::string& cachePath, bool tuneMissing)
+    {
+        TunerState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        s.path = cachePath;
+        s.tuneMissing = tuneMissing;
+        s.loaded = false;
+        s.table.clear();
+        generation.fetch_add(1, std::memory_order_release);
+
+        enabled.store(true, std::memory_order_relaxed);
+    }
+
+    std::string GemmTuner::defaultCachePath()
+    {
+        const char* path = std::getenv("SUSHIAI_GEMM_CACHE");
+        return path ? path : "sushiai_gemm_tuning.txt";
+    }
+
+    std::string GemmTuner::shapeClass(bool transA, bool transB, int m, int n, int k)
+    {
+        return std::string(transA ? "T" : "N") + (transB ? "T" : "N")
+            + "/m" + std::to_string(bucket(m)) + "/n" + std::to_string(bucket(n)) + "/k" + std::to_string(bucket(k));
+    }
+
+    GemmConfig GemmTuner::select(bool transA, bool transB, int m, int n, int k)
+    {
+        thread_local LocalCache local;
+
+        unsigned current = generation.load(std::memory_order_acquire);
+        if (local.generation != current)
+        {
+            local.configs.clear();
+            local.generation = current;
+        }
+
+        // Buckets are at most 4096, so 16 bits each
+        unsigned long long id = ((unsigned long long)transA << 49) | ((unsigned long long)transB << 48)
+            | ((unsigned long long)bucket(m) << 32) | ((unsigned long long)bucket(n) << 16) | (unsigned long long)bucket(k);
+
+        auto cached = local.configs.find(id);
+        if (cached != local.configs.end())
+            return cached -> second;
+
+        std::string key = shapeClass(transA, transB, m, n, k);
+        TunerState& s = state();
+
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            if (!s.loaded)
+            {
+                if (s.path.empty())
+                    s.path = defaultCachePath();
+
+                load(s);
+                s.loaded = true;
+            }
+
+            auto it = s.table.find(key);
+            if (it != s.table.end())
+                return local.configs[id] = it -> second.config;
+
+            if (!s.tuneMissing)
+                return local.configs[id] = defaultGemmConfig(transA, transB, m, n, k);
+
+            // Another thread is tuning this class: don't wait for it, and don't cache the stand-in
+            if (!s.tuning.insert(key).second)
+                return defaultGemmConfig(transA, transB, m, n, k);
+        }
+
+        // Tuned on the shape that first hit the class; the rest of the class shares the result. Runs
+        // outside the lock so GEMMs of other classes (and other threads) are not held up by it.
+        TunedEntry entry = tune(transA, transB, m, n, k);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.tuning.erase(key);
+
+        // enable() or reset() ran meanwhile: the result belongs to a table that no longer exists
+        if (generation.load(std::memory_order_relaxed) != current)
+            return entry.config;
+
+        s.table[key] = entry;
+        save(s);
+
+        return local.configs[id] = entry.config;
+    }
+
+    void GemmTuner::reset()
+    {
+        TunerState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        s.table.clear();
+        s.loaded = false;
+        generation.fetch_add(1, std::memory_order_release);
+    }
+
+    void GemmTuner::printTable()
+    {
+        TunerState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+
+        std::cout << "=== GEMM tuning " << sectionHeader() << " (" << (s.path.empty() ? defaultCachePath() : s.path) << ") ===\n";
+        std::cout << std::left << std::setw(24) << "class" << std::setw(8) << "kernel" << std::right
+            << std::setw(6) << "mc" << std::setw(6) << "kc" << std::setw(6) << "nc" << std::setw(10) << "GFLOP/s" << "\n";
+
+        for (auto& [key, entry] : s.table)
+        {
+            bool direct = entry.config.kernel == GemmKernel::Direct;
+            std::cout << std::left << std::setw(24) << key << std::setw(8) << (direct ? "direct" : "packed") << std::right
+                << std::setw(6) << entry.config.mc << std::setw(6) << entry.config.kc << std::setw(6) << entry.config.nc
+                << std::setw(10) << std::fixed << std::setprecision(2) << entry.gflops << "\n";
+        }
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include "simd.h"
+
+namespace SushiAI
+{
+    /// Runtime autotuner for the SIMD GEMM. The first GEMM of each shape class (transposes plus M, N, K
+    /// rounded up to powers of two) times the Direct kernel and a grid of packed tile sizes on that shape
+    /// and keeps the fastest. Winners are stored in a text cache with one section per CPU model and
+    /// instruction set, so later runs on the same hardware reuse them without tuning.
+    ///
+    /// Disabled by default. Setting SUSHIAI_GEMM_TUNE enables it at startup with defaultCachePath().
+    class GemmTuner
+    {
+        public:
+            static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+            /// Loads this machine's section of cachePath (if any). With tuneMissing = false unseen classes use
+            /// the built-in defaults instead of being tuned, so a pre-tuned deployment never pays tuning cost.
+            static void enable(const std::string& cachePath = defaultCachePath(), bool tuneMissing = true);
+            static void disable() { enabled.store(false, std::memory_order_relaxed); }
+            /// SUSHIAI_GEMM_CACHE, else "sushiai_gemm_tuning.txt" in the working directory.
+            static std::string defaultCachePath();
+
+            /// Configuration for a GEMM, tuning its class first if it has not been seen on this machine.
+            static GemmConfig select(bool transA, bool transB, int m, int n, int k);
+            /// e.g. "NT/m64/n128/k16".
+            static std::string shapeClass(bool transA, bool transB, int m, int n, int k);
+            /// Forgets the in-memory table (the cache file is left alone).
+            static void reset();
+
+            static void printTable();
+
+        private:
+            static std::atomic<bool> enabled;
+    };
+}
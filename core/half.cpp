@@ -0,0 +1,214 @@
+#include <vector>
+#include <algorithm>
+#include "half.h"
+
+#if defined(__F16C__) || defined(__AVX512BF16__)
+#include <immintrin.h>
+#endif
+
+namespace SushiAI
+{
+    const char* dtypeName(DType dtype)
+    {
+        switch (dtype)
+        {
+            case DType::BFloat16: return "bf16";
+            case DType::Float16:  return "fp16";
+            default:              return "fp32";
+        }
+    }
+
+    size_t dtypeSize(DType dtype)
+    {
+        return dtype == DType::Float32 ? 4 : 2;
+    }
+
+    #pragma region Scalar Conversions
+
+    uint16_t floatToHalf(float value)
+    {
+        // Round-to-nearest-even conversion with subnormals, Inf and NaN (F. Giesen's float_to_half_fast3_rtne).
+        const uint32_t f16Max = (127u + 16u) << 23;
+        const uint32_t f32Infinity = 255u << 23;
+        const uint32_t denormMagicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        uint16_t result;
+        if (bits >= f16Max)
+            result = bits > f32Infinity ? 0x7e00 : 0x7c00;
+        else if (bits < (113u << 23))
+        {
+            // Subnormal or zero: let the FPU do the rounding by aligning against a magic number.
+            float f, magic;
+            std::memcpy(&f, &bits, sizeof(f));
+            std::memcpy(&magic, &denormMagicBits, sizeof(magic));
+
+            f += magic;
+            std::memcpy(&bits, &f, sizeof(bits));
+            result = (uint16_t)(bits - denormMagicBits);
+        }
+        else
+        {
+            uint32_t mantissaOdd = (bits >> 13) & 1u;
+            bits += ((uint32_t)(15 - 127) << 23) + 0xfffu + mantissaOdd;
+            result = (uint16_t)(bits >> 13);
+        }
+
+        return (uint16_t)(result | (sign >> 16));
+    }
+
+    float halfToFloat(uint16_t value)
+    {
+        const uint32_t shiftedExponent = 0x7c00u << 13;
+        const uint32_t magicBits = 113u << 23;
+
+        uint32_t bits = ((uint32_t)value & 0x7fffu) << 13;
+        uint32_t exponent = bits & shiftedExponent;
+        bits += (uint32_t)(127 - 15) << 23;
+
+        if (exponent == shiftedExponent)         // Inf / NaN
+            bits += (uint32_t)(128 - 16) << 23;
+        else if (exponent == 0)                  // zero / subnormal: renormalize
+        {
+            bits += 1u << 23;
+
+            float f, magic;
+            std::memcpy(&f, &bits, sizeof(f));
+            std::memcpy(&magic, &magicBits, sizeof(magic));
+            f -= magic;
+            std::memcpy(&bits, &f, sizeof(bits));
+        }
+
+        bits |= ((uint32_t)value & 0x8000u) << 16;
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+
+        return result;
+    }
+
+    #pragma endregion
+
+    #pragma region Bulk Conversions
+
+    void packReduced(DType dtype, const float* src, uint16_t* dst, size_t n)
+    {
+        size_t i = 0;
+
+        if (dtype == DType::Float16)
+        {
+            #if defined(__F16C__)
+            for (; i + 8 <= n; i += 8)
+                _mm_storeu_si128((__m128i*)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+            #endif
+            for (; i < n; ++i)
+                dst[i] = floatToHalf(src[i]);
+        }
+        else
+        {
+            #if defined(__AVX512BF16__) && defined(__AVX512F__)
+            for (; i + 16 <= n; i += 16)
+            {
+                __m256bh packed = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+                std::memcpy(dst + i, &packed, sizeof(packed));
+            }
+            #endif
+            for (; i < n; ++i)
+                dst[i] = floatToBFloat16(src[i]);
+        }
+    }
+
+    void unpackReduced(DType dtype, const uint16_t* src, float* dst, size_t n)
+    {
+        size_t i = 0;
+
+        if (dtype == DType::Float16)
+        {
+            #if defined(__F16C__)
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+            #endif
+            for (; i < n; ++i)
+                dst[i] = halfToFloat(src[i]);
+        }
+        else
+        {
+            // bf16 → fp32 is a 16-bit shift, which the compiler vectorizes on its own.
+            for (; i < n; ++i)
+                dst[i] = bfloat16ToFloat(src[i]);
+        }
+    }
+
+    void roundToDType(DType dtype, float* data, size_t n)
+    {
+        if (dtype == DType::Float32)
+            return;
+
+        uint16_t chunk[256];
+        for (size_t i = 0; i < n; i += 256)
+        {
+            size_t count = std::min<size_t>(256, n - i);
+            packReduced(dtype, data + i, chunk, count);
+            unpackReduced(dtype, chunk, data + i, count);
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region Reduced Precision GEMM
+
+    void gemmReduced(DType dtype, const uint16_t* A, const uint16_t* B, float* C, int m, int n, int k)
+    {
+        // B is expanded once; then i-l-j, so every row of C stays in cache while its k updates land.
+        thread_local std::vector<float> expanded;
+        if (expanded.size() < (size_t)k * n)
+            expanded.resize((size_t)k * n);
+        unpackReduced(dtype, B, expanded.data(), (size_t)k * n);
+
+        for (int i = 0; i < m; ++i)
+        {
+            float* c = C + (size_t)i * n;
+
+            for (int l = 0; l < k; ++l)
+            {
+                uint16_t packed = A[(size_t)i * k + l];
+                float a = dtype == DType::Float16 ? halfToFloat(packed) : bfloat16ToFloat(packed);
+                const float* row = expanded.data() + (size_t)l * n;
+
+                for (int j = 0; j < n; ++j)
+                    c[j] += a * row[j];
+            }
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region Autocast
+
+    namespace
+    {
+        thread_local DType currentAutocast = DType::Float32;
+    }
+
+    DType autocastDType()
+    {
+        return currentAutocast;
+    }
+
+    AutocastGuard::AutocastGuard(DType dtype) : previous(currentAutocast)
+    {
+        currentAutocast = dtype;
+    }
+
+    AutocastGuard::~AutocastGuard()
+    {
+        currentAutocast = previous;
+    }
+
+    #pragma endregion
+}
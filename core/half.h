@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace SushiAI
+{
+    /// Precision a tensor's values are rounded to. Storage is always fp32: a reduced dtype emulates bf16 / fp16
+    /// numerics (every value is representable in 16 bits), it does not shrink memory or bandwidth.
+    enum class DType
+    {
+        Float32,
+        BFloat16,   // 8-bit exponent, 7-bit mantissa: fp32 range, ~3 significant digits
+        Float16     // IEEE binary16: 5-bit exponent, 10-bit mantissa
+    };
+
+    const char* dtypeName(DType dtype);
+    size_t dtypeSize(DType dtype);
+
+    #pragma region Scalar Conversions
+
+    inline uint16_t floatToBFloat16(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        if ((bits & 0x7fffffffu) > 0x7f800000u)     // NaN: keep it quiet, don't round into Inf
+            return (uint16_t)((bits >> 16) | 0x0040u);
+
+        bits += 0x7fffu + ((bits >> 16) & 1u);      // round to nearest even
+        return (uint16_t)(bits >> 16);
+    }
+
+    inline float bfloat16ToFloat(uint16_t value)
+    {
+        uint32_t bits = (uint32_t)value << 16;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+
+        return result;
+    }
+
+    uint16_t floatToHalf(float value);
+    float halfToFloat(uint16_t value);
+
+    #pragma endregion
+
+    #pragma region Bulk Conversions
+
+    /// Packs n floats into 16-bit storage (Float16, otherwise BFloat16), using F16C / AVX-512 BF16 when the build enables them.
+    void packReduced(DType dtype, const float* src, uint16_t* dst, size_t n);
+    /// Expands n 16-bit values of the given dtype back to float.
+    void unpackReduced(DType dtype, const uint16_t* src, float* dst, size_t n);
+    /// Rounds n floats in place to the nearest value representable in dtype (no-op for Float32).
+    void roundToDType(DType dtype, float* data, size_t n);
+
+    #pragma endregion
+
+    #pragma region Reduced Precision GEMM
+
+    /// C[m, n] += A[m, k] · B[k, n] with A and B stored as 16-bit dtype values and fp32 accumulation.
+    /// Summation over k runs in ascending order for every element. Reference kernel for packed operands;
+    /// autocast matmul() rounds in fp32 and uses the backend GEMM instead.
+    void gemmReduced(DType dtype, const uint16_t* A, const uint16_t* B, float* C, int m, int n, int k);
+
+    #pragma endregion
+
+    #pragma region Autocast
+
+    /// Precision the ops round their outputs (and GEMM operands) to on this thread. Float32 = off.
+    DType autocastDType();
+
+    /// Enables autocast for the lifetime of the guard, restoring the previous setting afterwards.
+    class AutocastGuard
+    {
+        private:
+            DType previous;
+
+        public:
+            explicit AutocastGuard(DType dtype);
+            ~AutocastGuard();
+
+            AutocastGuard(const AutocastGuard&) = delete;
+            AutocastGuard& operator=(const AutocastGuard&) = delete;
+    };
+
+    #pragma endregion
+}
@@ -0,0 +1,217 @@
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <utility>
+#include <fstream>
+#include <algorithm>
+#include "machine.h"
+#include "parallel.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace SushiAI
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        /// Multiply-add chains x = x · a + b on sizeof...(K) independent accumulators, returns the flop count.
+        /// Every chain is a dependent multiply-add, so covering latency × ports takes 10+ chains with FMA and
+        /// more without (the multiply and add latencies add up). The accumulators start from distinct values:
+        /// identical chains are one chain to the optimizer, which then merges them and times a single one.
+        /// The fold over K unrolls them into separate variables that stay in registers.
+        template <typename V, typename Set, typename MulAdd, typename Sum, size_t... K>
+        double multiplyAddLoop(long iterations, V a, V b, Set set, MulAdd mulAdd, Sum sum, float* sink, std::index_sequence<K...>)
+        {
+            V x[] = { set(0.5f + 0.01f * K)... };
+
+            for (long i = 0; i < iterations; ++i)
+                ((x[K] = mulAdd(x[K], a, b)), ...);
+
+            *sink = (sum(x[K]) + ...);
+
+            return 2.0 * sizeof...(K) * (sizeof(V) / sizeof(float)) * iterations;
+        }
+
+        // x86-64 has 16 vector registers and the loop keeps a and b in two of them: 14 chains is as many as
+        // fit without spilling (a spilled chain adds a store-forwarding round trip and becomes the slowest)
+        #if defined(__FMA__)
+        using Chains = std::make_index_sequence<12>;
+        #else
+        using Chains = std::make_index_sequence<14>;
+        #endif
+
+        double fmaKernel(long iterations, float* sink)
+        {
+            #if defined(__AVX__)
+            auto mulAdd = [](__m256 x, __m256 a, __m256 b)
+            {
+                #if defined(__FMA__)
+                return _mm256_fmadd_ps(x, a, b);
+                #else
+                return _mm256_add_ps(_mm256_mul_ps(x, a), b);
+                #endif
+            };
+            auto set = [](float v) { return _mm256_set1_ps(v); };
+            auto sum = [](__m256 x) { return _mm256_cvtss_f32(x); };
+
+            return multiplyAddLoop(iterations, set(0.999f), set(0.001f), set, mulAdd, sum, sink, Chains{});
+            #elif defined(__SSE2__) || defined(_M_X64)
+            auto mulAdd = [](__m128 x, __m128 a, __m128 b) { return _mm_add_ps(_mm_mul_ps(x, a), b); };
+            auto set = [](float v) { return _mm_set1_ps(v); };
+            auto sum = [](__m128 x) { return _mm_cvtss_f32(x); };
+
+            return multiplyAddLoop(iterations, set(0.999f), set(0.001f), set, mulAdd, sum, sink, Chains{});
+            #else
+            auto mulAdd = [](float x, float a, float b) { return x * a + b; };
+            auto set = [](float v) { return v; };
+            auto sum = [](float x) { return x; };
+
+            return multiplyAddLoop(iterations, 0.999f, 0.001f, set, mulAdd, sum, sink, Chains{});
+            #endif
+        }
+
+        double seconds(Clock::time_point start)
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        /// Best-of-three GFLOP/s of fmaKernel on `threads` workers of the global pool (1 = calling thread only).
+        double measureFlops(int threads)
+        {
+            const long iterations = 4000000;
+            std::vector<float> sink(threads);
+            std::vector<double> flops(threads);
+            double best = 0.0;
+
+            for (int r = 0; r < 3; ++r)
+            {
+                auto start = Clock::now();
+
+                if (threads == 1)
+                    flops[0] = fmaKernel(iterations, &sink[0]);
+                else
+                    ThreadPool::global().run([&](int w) { flops[w] = fmaKernel(iterations, &sink[w]); });
+
+                double total = 0.0;
+                for (double f : flops)
+                    total += f;
+
+                best = std::max(best, total / seconds(start) * 1e-9);
+            }
+
+            return best;
+        }
+
+        /// Best-of-three stream triad a[i] = b[i] + s * c[i] over arrays far larger than the last-level cache.
+        double measureBandwidth(int threads)
+        {
+            const int n = 1 << 23;     // 32 MiB per array
+            std::vector<float> a, b, c;
+            a.resize(n); b.resize(n); c.resize(n);
+
+            auto triad = [&](int begin, int end)
+            {
+                for (int i = begin; i < end; ++i)
+                    a[i] = b[i] + 1.5f * c[i];
+            };
+
+            auto run = [&]()
+            {
+                if (threads == 1)
+                    triad(0, n);
+                else
+                    ThreadPool::global().parallelFor(0, n, triad);
+            };
+
+            if (threads == 1)
+            {
+                std::fill(b.begin(), b.end(), 1.0f);
+                std::fill(c.begin(), c.end(), 2.0f);
+            }
+            else
+                ThreadPool::global().parallelFor(0, n, [&](int begin, int end)
+                {
+                    std::fill(b.begin() + begin, b.begin() + end, 1.0f);
+                    std::fill(c.begin() + begin, c.begin() + end, 2.0f);
+                });
+
+            run();
+
+            double best = 0.0;
+            for (int r = 0; r < 3; ++r)
+            {
+                auto start = Clock::now();
+                run();
+                best = std::max(best, 3.0 * n * sizeof(float) / seconds(start) * 1e-9);
+            }
+
+            return best;
+        }
+    }
+
+    std::string cpuModelName()
+    {
+        #if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        unsigned int regs[12] = {};
+        #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0x80000000);
+        if ((unsigned int)info[0] < 0x80000004)
+            return "unknown";
+        for (int i = 0; i < 3; ++i)
+        {
+            __cpuid(info, 0x80000002 + i);
+            std::memcpy(regs + 4 * i, info, sizeof(info));
+        }
+        #else
+        if (__get_cpuid_max(0x80000000, nullptr) < 0x80000004)
+            return "unknown";
+        for (int i = 0; i < 3; ++i)
+            __get_cpuid(0x80000002 + i, &regs[4 * i], &regs[4 * i + 1], &regs[4 * i + 2], &regs[4 * i + 3]);
+        #endif
+
+        char brand[49] = {};
+        std::memcpy(brand, regs, 48);
+        std::string name(brand);
+        #else
+        std::string name;
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (name.empty() && std::getline(cpuinfo, line))
+            if (line.rfind("model name", 0) == 0 || line.rfind("CPU part", 0) == 0)
+                name = line.substr(line.find(':') + 1);
+        #endif
+
+        name.erase(0, name.find_first_not_of(' '));
+        name.erase(name.find_last_not_of(' ') + 1);
+
+        return name.empty() ? "unknown" : name;
+    }
+
+    const MachinePeak& machinePeak()
+    {
+        static const MachinePeak peak = []()
+        {
+            MachinePeak p;
+            p.cpuModel = cpuModelName();
+            p.threads = ThreadPool::global().size();
+            p.gflopsPerCore = measureFlops(1);
+            p.gflops = p.threads > 1 ? measureFlops(p.threads) : p.gflopsPerCore;
+            p.bandwidthPerCoreGBs = measureBandwidth(1);
+            p.bandwidthGBs = p.threads > 1 ? measureBandwidth(p.threads) : p.bandwidthPerCoreGBs;
+
+            return p;
+        }();
+
+        return peak;
+    }
+}
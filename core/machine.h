@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+
+namespace SushiAI
+{
+    /// Measured throughput limits of the machine, as reachable by code built with the current compiler flags.
+    struct MachinePeak
+    {
+        std::string cpuModel;
+        int threads = 1;
+        double gflopsPerCore = 0.0;     // fp32 multiply-add throughput of one core
+        double gflops = 0.0;            // all threads
+        double bandwidthGBs = 0.0;      // main-memory bandwidth (stream triad), all threads
+        double bandwidthPerCoreGBs = 0.0;
+    };
+
+    /// CPU brand string ("Intel(R) Xeon(R) ..."), or "unknown".
+    std::string cpuModelName();
+
+    /// Runs short FMA and stream-triad kernels (~0.5 s in total). The result is cached after the first call.
+    const MachinePeak& machinePeak();
+}
@@ -0,0 +1,276 @@
+#include <map>
+#include <mutex>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include "memorytracker.h"
+#include "profiler.h"
+#include "optimizer.h"
+#include "tensor.h"
+
+namespace SushiAI
+{
+    std::atomic<bool> MemoryTracker::enabled{ false };
+
+    namespace
+    {
+        struct Record
+        {
+            int layer;
+            bool parameter;
+            size_t dataBytes;
+            size_t gradientBytes;
+        };
+
+        struct LayerCounters
+        {
+            size_t activation = 0, gradient = 0;
+            size_t peakActivation = 0, peakGradient = 0;
+        };
+
+        struct State
+        {
+            std::mutex mutex;
+            std::unordered_map<const Tensor*, Record> records;
+            std::map<int, LayerCounters> layers;
+            size_t live[(int)MemoryCategory::Count] = {};
+            size_t peak[(int)MemoryCategory::Count] = {};
+            size_t peakTotal = 0;
+            size_t budget = 0;
+            bool warned = false;
+            const Optimizer* optimizer = nullptr;
+        };
+
+        State& state()
+        {
+            static State instance;
+            return instance;
+        }
+
+        /// Re-reads the optimizer's state size. stateBytes() walks the optimizer's maps, so this runs
+        /// from track(), beginStep(), report() and after each step(), never per allocation.
+        void refreshOptimizerBytes(State& s)
+        {
+            s.live[(int)MemoryCategory::OptimizerState] = s.optimizer ? s.optimizer -> stateBytes() : 0;
+        }
+
+        size_t liveTotal(const State& s)
+        {
+            size_t total = 0;
+            for (size_t bytes : s.live)
+                total += bytes;
+
+            return total;
+        }
+
+        void add(State& s, const Record& r)
+        {
+            s.live[(int)(r.parameter ? MemoryCategory::Parameter : MemoryCategory::Activation)] += r.dataBytes;
+            s.live[(int)MemoryCategory::Gradient] += r.gradientBytes;
+
+            if (r.layer >= 0 && !r.parameter)
+            {
+                auto& l = s.layers[r.layer];
+                l.activation += r.dataBytes;
+                l.gradient += r.gradientBytes;
+                l.peakActivation = std::max(l.peakActivation, l.activation);
+                l.peakGradient = std::max(l.peakGradient, l.gradient);
+            }
+        }
+
+        void remove(State& s, const Record& r)
+        {
+            s.live[(int)(r.parameter ? MemoryCategory::Parameter : MemoryCategory::Activation)] -= r.dataBytes;
+            s.live[(int)MemoryCategory::Gradient] -= r.gradientBytes;
+
+            if (r.layer >= 0 && !r.parameter)
+            {
+                auto& l = s.layers[r.layer];
+                l.activation -= r.dataBytes;
+                l.gradient -= r.gradientBytes;
+            }
+        }
+
+        void updatePeak(State& s)
+        {
+            size_t total = liveTotal(s);
+            if (total > s.peakTotal)
+            {
+                s.peakTotal = total;
+                std::copy(std::begin(s.live), std::end(s.live), std::begin(s.peak));
+            }
+
+            if (s.budget > 0 && total > s.budget && !s.warned)
+            {
+                s.warned = true;
+                std::cerr << "[MemoryTracker] live memory " << total << " bytes exceeds the budget of " << s.budget << " bytes"
+                    << " (activations " << s.live[(int)MemoryCategory::Activation]
+                    << ", gradients " << s.live[(int)MemoryCategory::Gradient]
+                    << ", parameters " << s.live[(int)MemoryCategory::Parameter]
+                    << ", optimizer " << s.live[(int)MemoryCategory::OptimizerState] << ")"
+                    << " while running " << Profiler::layerLabel(Profiler::currentLayer()) << "\n";
+            }
+        }
+    }
+
+    const char* memoryCategoryName(MemoryCategory category)
+    {
+        switch (category)
+        {
+            case MemoryCategory::Parameter:      return "parameters";
+            case MemoryCategory::Activation:     return "activations";
+            case MemoryCategory::Gradient:       return "gradients";
+            case MemoryCategory::OptimizerState: return "optimizer state";
+            default:                             return "?";
+        }
+    }
+
+    void MemoryTracker::onAllocate(Tensor* tensor)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        Record r{ Profiler::currentLayer(), false, tensor -> data.capacity() * sizeof(float), tensor -> gradient.capacity() * sizeof(float) };
+        s.records[tensor] = r;
+        add(s, r);
+        updatePeak(s);
+    }
+
+    void MemoryTracker::onRelease(Tensor* tensor)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        auto it = s.records.find(tensor);
+        if (it == s.records.end())
+            return;
+
+        remove(s, it -> second);
+        s.records.erase(it);
+    }
+
+    void MemoryTracker::track(const std::vector<std::shared_ptr<Tensor>>& parameters, const Optimizer* optimizer)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        for (auto& p : parameters)
+        {
+            auto it = s.records.find(p.get());
+            if (it != s.records.end())
+            {
+                remove(s, it -> second);
+                s.records.erase(it);
+            }
+
+            Record r{ -1, true, p -> data.capacity() * sizeof(float), p -> gradient.capacity() * sizeof(float) };
+            s.records[p.get()] = r;
+            p -> memoryTracked = true;
+            add(s, r);
+        }
+
+        s.optimizer = optimizer;
+        refreshOptimizerBytes(s);
+        updatePeak(s);
+    }
+
+    void MemoryTracker::onOptimizerStep(const Optimizer* optimizer)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        if (s.optimizer != optimizer)
+            return;
+
+        refreshOptimizerBytes(s);
+        updatePeak(s);
+    }
+
+    void MemoryTracker::onOptimizerDestroyed(const Optimizer* optimizer)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        if (s.optimizer != optimizer)
+            return;
+
+        s.optimizer = nullptr;
+        s.live[(int)MemoryCategory::OptimizerState] = 0;
+    }
+
+    void MemoryTracker::setBudget(size_t bytes)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        s.budget = bytes;
+        s.warned = false;
+    }
+
+    void MemoryTracker::beginStep()
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        refreshOptimizerBytes(s);
+        s.peakTotal = liveTotal(s);
+        std::copy(std::begin(s.live), std::end(s.live), std::begin(s.peak));
+        s.warned = false;
+
+        for (auto& [id, l] : s.layers)
+        {
+            l.peakActivation = l.activation;
+            l.peakGradient = l.gradient;
+        }
+    }
+
+    MemoryReport MemoryTracker::report()
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        // Optimizer state is allocated lazily inside step(), after the last tensor of the step.
+        refreshOptimizerBytes(s);
+        updatePeak(s);
+
+        MemoryReport r;
+        std::copy(std::begin(s.live), std::end(s.live), std::begin(r.live));
+        std::copy(std::begin(s.peak), std::end(s.peak), std::begin(r.peakByCategory));
+        r.liveTotal = liveTotal(s);
+        r.peakTotal = s.peakTotal;
+        r.budget = s.budget;
+        r.overBudget = s.budget > 0 && s.peakTotal > s.budget;
+
+        for (auto& [id, l] : s.layers)
+            r.layers.push_back({ Profiler::layerLabel(id), l.activation, l.gradient, l.peakActivation, l.peakGradient });
+
+        return r;
+    }
+
+    void MemoryReport::print() const
+    {
+        auto kb = [](size_t bytes) { return bytes / 1024.0; };
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+        std::cout << std::fixed << std::setprecision(1);
+
+        std::cout << "=== Memory (KiB) ===\n";
+        std::cout << std::left << std::setw(20) << "category" << std::right << std::setw(12) << "live" << std::setw(12) << "at peak" << "\n";
+        for (int c = 0; c < (int)MemoryCategory::Count; ++c)
+            std::cout << std::left << std::setw(20) << memoryCategoryName((MemoryCategory)c) << std::right
+                << std::setw(12) << kb(live[c]) << std::setw(12) << kb(peakByCategory[c]) << "\n";
+        std::cout << std::left << std::setw(20) << "total" << std::right << std::setw(12) << kb(liveTotal) << std::setw(12) << kb(peakTotal) << "\n";
+
+        if (budget > 0)
+            std::cout << "Budget " << kb(budget) << " KiB" << (overBudget ? " - EXCEEDED" : "") << "\n";
+
+        std::cout << std::left << std::setw(40) << "layer" << std::right << std::setw(14) << "peak act" << std::setw(14) << "peak grad" << "\n";
+        for (auto& l : layers)
+            std::cout << std::left << std::setw(40) << l.label << std::right
+                << std::setw(14) << kb(l.peakActivationBytes) << std::setw(14) << kb(l.peakGradientBytes) << "\n";
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace SushiAI
+{
+    class Tensor;
+    class Optimizer;
+
+    enum class MemoryCategory
+    {
+        Parameter,          // data of the registered model parameters
+        Activation,         // data of every other tensor: layer outputs, inputs, targets, losses
+        Gradient,           // gradient buffers (allocated eagerly for every tensor)
+        OptimizerState,     // SGD velocity, Adam moments
+        Count
+    };
+
+    const char* memoryCategoryName(MemoryCategory category);
+
+    struct LayerMemory
+    {
+        std::string label;              // "[i] Layer" as reported by Sequential::forward
+        size_t activationBytes = 0;     // live right now
+        size_t gradientBytes = 0;
+        size_t peakActivationBytes = 0; // since the last beginStep()
+        size_t peakGradientBytes = 0;
+    };
+
+    struct MemoryReport
+    {
+        size_t live[(int)MemoryCategory::Count] = {};
+        /// Category split at the moment the total peaked.
+        size_t peakByCategory[(int)MemoryCategory::Count] = {};
+        size_t liveTotal = 0;
+        size_t peakTotal = 0;
+        size_t budget = 0;
+        bool overBudget = false;
+        std::vector<LayerMemory> layers;
+
+        void print() const;
+    };
+
+    /// Accounts the bytes held by tensors created while it is enabled, split by category and by the
+    /// Sequential layer that created them. Disabled by default; while disabled a tensor pays one
+    /// relaxed atomic load on construction.
+    class MemoryTracker
+    {
+        public:
+            static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+            static void enable() { enabled.store(true, std::memory_order_relaxed); }
+            /// Stops tracking new tensors; those already tracked are still released when destroyed.
+            static void disable() { enabled.store(false, std::memory_order_relaxed); }
+
+            /// Marks the given tensors as parameters (tracking them if they predate enable()) and
+            /// reports the optimizer's state alongside them.
+            static void track(const std::vector<std::shared_ptr<Tensor>>& parameters, const Optimizer* optimizer = nullptr);
+            /// Warns on stderr, once per step, when the live total crosses this many bytes. 0 = no budget.
+            static void setBudget(size_t bytes);
+            /// Starts a new step: peaks restart from the current live bytes.
+            static void beginStep();
+            static MemoryReport report();
+
+            /// Called by Tensor's constructor and destructor.
+            static void onAllocate(Tensor* tensor);
+            static void onRelease(Tensor* tensor);
+            /// Called by Optimizer::step() and ~Optimizer(): refreshes the cached state size of the
+            /// tracked optimizer, or forgets it so the tracker never reads a destroyed one.
+            static void onOptimizerStep(const Optimizer* optimizer);
+            static void onOptimizerDestroyed(const Optimizer* optimizer);
+
+        private:
+            static std::atomic<bool> enabled;
+    };
+}
@@ -0,0 +1,314 @@
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "tensor.h"
+#include "ops.h"
+#include "opsdetail.h"
+#include "profiler.h"
+#include "parallel.h"
+#include "normalization.h"
+#include "vectormath.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using namespace simd;
+        using namespace detail;
+
+        /// Σ a[i]·b[i] and Σ a[i] in one pass.
+        void dotAndSum(const float* a, const float* b, int n, float& dot, float& sum)
+        {
+            vf vDot = vzero(), vSum = vzero();
+            int i = 0;
+            for (; i + Lanes <= n; i += Lanes)
+            {
+                vf va = vload(a + i);
+                vDot = vfma(va, vload(b + i), vDot);
+                vSum = vadd(vSum, va);
+            }
+
+            dot = vsum(vDot);
+            sum = vsum(vSum);
+            for (; i < n; ++i)
+            {
+                dot += a[i] * b[i];
+                sum += a[i];
+            }
+        }
+
+        /// LayerNorm (centered) or RMSNorm over the last axis. Forward saves one mean and one rstd per row;
+        /// backward rebuilds x̂ from them and needs nothing else.
+        std::shared_ptr<Tensor> normalize(const char* op, const std::shared_ptr<Tensor>& t, const std::shared_ptr<Tensor>& gamma,
+            const std::shared_ptr<Tensor>& beta, float eps, bool centered)
+        {
+            ProfileScope scope(op, "forward");
+
+            const auto& shape = t -> getShape();
+            if (shape.empty())
+                throw std::invalid_argument(std::string(op) + ": expected at least one axis");
+
+            const int cols = shape.back();
+            const int rows = t -> getTotalSize() / cols;
+
+            if (gamma && gamma -> getTotalSize() != cols)
+                throw std::invalid_argument(std::string(op) + ": gamma must have " + std::to_string(cols) + " entries");
+            if (beta && beta -> getTotalSize() != cols)
+                throw std::invalid_argument(std::string(op) + ": beta must have " + std::to_string(cols) + " entries");
+
+            bool requiresGrad = t -> requiresGradient || (gamma && gamma -> requiresGradient) || (beta && beta -> requiresGradient);
+            auto result = std::make_shared<Tensor>(shape, 0.0f, requiresGrad);
+
+            auto means = std::make_shared<std::vector<float>>(centered ? rows : 0);
+            auto rstds = std::make_shared<std::vector<float>>(rows);
+
+            const float* X = t -> getData().data();
+            float* Y = result -> getData().data();
+            const float* G = gamma ? gamma -> getData().data() : nullptr;
+            const float* Bt = beta ? beta -> getData().data() : nullptr;
+
+            double n = (double)rows * cols;
+
+            parallelRange(rows, n, [&](int begin, int end)
+            {
+                for (int r = begin; r < end; ++r)
+                {
+                    const float* x = X + (size_t)r * cols;
+                    float mean = 0.0f, rstd;
+
+                    if (centered)
+                    {
+                        layerNormStatistics(x, cols, eps, mean, rstd);
+                        (*means)[r] = mean;
+                    }
+                    else
+                        rstd = rmsNormStatistics(x, cols, eps);
+
+                    (*rstds)[r] = rstd;
+                    normalizeRow(x, Y + (size_t)r * cols, cols, mean, rstd, G, Bt);
+                }
+            });
+
+            applyAutocast(result);
+
+            if (requiresGrad)
+            {
+                auto t_ptr = t, gamma_ptr = gamma, beta_ptr = beta;
+                auto result_ptr = result;
+                const char* name = op;
+
+                std::vector<std::shared_ptr<Tensor>> parents = { t_ptr };
+                if (gamma) parents.push_back(gamma);
+                if (beta) parents.push_back(beta);
+
+                result -> setGradientFunction([t_ptr, gamma_ptr, beta_ptr, result_ptr, means, rstds, rows, cols, centered, name, n, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope(name, "backward", layer);
+                    scope.setCost(10.0 * n, 4.0 * n * sizeof(float));
+
+                    const float* X = t_ptr -> getData().data();
+                    const float* dY = result_ptr -> gradient.data();
+                    const float* G = gamma_ptr ? gamma_ptr -> getData().data() : nullptr;
+                    const float invCols = 1.0f / cols;
+
+                    auto meanOf = [&](int r) { return centered ? (*means)[r] : 0.0f; };
+
+                    // dx = rstd · (g - mean(g) - x̂ · mean(g ∘ x̂)) with g = dy ∘ gamma; RMSNorm drops the mean(g) term
+                    if (t_ptr -> requiresGradient)
+                    {
+                        float* dX = t_ptr -> gradient.data();
+
+                        parallelRange(rows, n, [&](int begin, int end)
+                        {
+                            std::vector<float> g(cols), xhat(cols);
+
+                            for (int r = begin; r < end; ++r)
+                            {
+                                const float* x = X + (size_t)r * cols;
+                                const float* dy = dY + (size_t)r * cols;
+                                float* dx = dX + (size_t)r * cols;
+                                float rstd = (*rstds)[r];
+
+                                normalizeRow(x, xhat.data(), cols, meanOf(r), rstd, nullptr, nullptr);
+                                if (G)
+                                    for (int j = 0; j < cols; ++j)
+                                        g[j] = dy[j] * G[j];
+                                else
+                                    std::copy(dy, dy + cols, g.begin());
+
+                                float dotGX, sumG;
+                                dotAndSum(g.data(), xhat.data(), cols, dotGX, sumG);
+
+                                float shift = centered ? sumG * invCols : 0.0f;
+                                float slope = dotGX * invCols;
+                                for (int j = 0; j < cols; ++j)
+                                    dx[j] += rstd * (g[j] - shift - xhat[j] * slope);
+                            }
+                        });
+                    }
+
+                    // dgamma = Σ_rows dy ∘ x̂, dbeta = Σ_rows dy; split over columns so no two tasks share an entry
+                    float* dGamma = gamma_ptr && gamma_ptr -> requiresGradient ? gamma_ptr -> gradient.data() : nullptr;
+                    float* dBeta = beta_ptr && beta_ptr -> requiresGradient ? beta_ptr -> gradient.data() : nullptr;
+
+                    if (dGamma || dBeta)
+                    {
+                        parallelRange(cols, n, [&](int begin, int end)
+                        {
+                            for (int r = 0; r < rows; ++r)
+                            {
+                                const float* x = X + (size_t)r * cols;
+                                const float* dy = dY + (size_t)r * cols;
+                                float mean = meanOf(r), rstd = (*rstds)[r];
+
+                                for (int j = begin; j < end; ++j)
+                                {
+                                    if (dGamma)
+                                        dGamma[j] += dy[j] * (x[j] - mean) * rstd;
+                                    if (dBeta)
+                                        dBeta[j] += dy[j];
+                                }
+                            }
+                        });
+                    }
+                }, parents);
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(shape);
+                scope.setCost(8.0 * n, 3.0 * n * sizeof(float));
+            }
+
+            return result;
+        }
+    }
+
+    #pragma region Row Kernels
+
+    void layerNormStatistics(const float* x, int n, float eps, float& mean, float& rstd)
+    {
+        // Every lane of two interleaved accumulators runs its own Welford recurrence over a strided
+        // subsequence; two chains hide the latency of the update.
+        vf meanA = vzero(), m2A = vzero(), meanB = vzero(), m2B = vzero();
+        int i = 0, countA = 0, countB = 0;
+
+        for (; i + 2 * Lanes <= n; i += 2 * Lanes)
+        {
+            vf scale = vset(1.0f / ++countA);
+            ++countB;
+
+            vf a = vload(x + i), b = vload(x + i + Lanes);
+            vf deltaA = vsub(a, meanA), deltaB = vsub(b, meanB);
+            meanA = vfma(deltaA, scale, meanA);
+            meanB = vfma(deltaB, scale, meanB);
+            m2A = vfma(deltaA, vsub(a, meanA), m2A);
+            m2B = vfma(deltaB, vsub(b, meanB), m2B);
+        }
+
+        if (i + Lanes <= n)
+        {
+            vf a = vload(x + i);
+            vf delta = vsub(a, meanA);
+            meanA = vfma(delta, vset(1.0f / ++countA), meanA);
+            m2A = vfma(delta, vsub(a, meanA), m2A);
+            i += Lanes;
+        }
+
+        // Chan's merge of the partial (count, mean, M2) triples, then the scalar tail
+        float laneMean[2 * Lanes], laneM2[2 * Lanes];
+        vstore(laneMean, meanA);
+        vstore(laneMean + Lanes, meanB);
+        vstore(laneM2, m2A);
+        vstore(laneM2 + Lanes, m2B);
+
+        float m = 0.0f, m2 = 0.0f;
+        int total = 0;
+
+        for (int l = 0; l < 2 * Lanes; ++l)
+        {
+            int count = l < Lanes ? countA : countB;
+            if (count == 0)
+                continue;
+
+            int merged = total + count;
+            float delta = laneMean[l] - m;
+            m += delta * count / merged;
+            m2 += laneM2[l] + delta * delta * ((float)total * count / merged);
+            total = merged;
+        }
+
+        for (; i < n; ++i)
+        {
+            ++total;
+            float delta = x[i] - m;
+            m += delta / total;
+            m2 += delta * (x[i] - m);
+        }
+
+        mean = m;
+        rstd = 1.0f / std::sqrt(m2 / n + eps);
+    }
+
+    float rmsNormStatistics(const float* x, int n, float eps)
+    {
+        vf vSquares = vzero();
+        int i = 0;
+        for (; i + Lanes <= n; i += Lanes)
+        {
+            vf v = vload(x + i);
+            vSquares = vfma(v, v, vSquares);
+        }
+
+        float squares = vsum(vSquares);
+        for (; i < n; ++i)
+            squares += x[i] * x[i];
+
+        return 1.0f / std::sqrt(squares / n + eps);
+    }
+
+    void normalizeRow(const float* x, float* y, int n, float mean, float rstd, const float* gamma, const float* beta)
+    {
+        const vf vMean = vset(mean), vRstd = vset(rstd);
+        int i = 0;
+
+        for (; i + Lanes <= n; i += Lanes)
+        {
+            vf v = vmul(vsub(vload(x + i), vMean), vRstd);
+            if (gamma)
+                v = vmul(v, vload(gamma + i));
+            if (beta)
+                v = vadd(v, vload(beta + i));
+            vstore(y + i, v);
+        }
+
+        for (; i < n; ++i)
+        {
+            float v = (x[i] - mean) * rstd;
+            if (gamma)
+                v *= gamma[i];
+            if (beta)
+                v += beta[i];
+            y[i] = v;
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region Normalization
+
+    std::shared_ptr<Tensor> layerNorm(const std::shared_ptr<Tensor>& t, const std::shared_ptr<Tensor>& gamma, const std::shared_ptr<Tensor>& beta, float eps)
+    {
+        return normalize("layerNorm", t, gamma, beta, eps, true);
+    }
+
+    std::shared_ptr<Tensor> rmsNorm(const std::shared_ptr<Tensor>& t, const std::shared_ptr<Tensor>& gamma, float eps)
+    {
+        return normalize("rmsNorm", t, gamma, nullptr, eps, false);
+    }
+
+    #pragma endregion
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace SushiAI
+{
+    /// Mean and 1 / sqrt(variance + eps) of one row, from a single read pass (lane-wise Welford, merged at the end).
+    void layerNormStatistics(const float* x, int n, float eps, float& mean, float& rstd);
+    /// 1 / sqrt(mean(x²) + eps) of one row.
+    float rmsNormStatistics(const float* x, int n, float eps);
+    /// y = (x - mean) · rstd · gamma + beta. gamma and beta may be null (no scale / no shift); y may alias x.
+    void normalizeRow(const float* x, float* y, int n, float mean, float rstd, const float* gamma, const float* beta);
+}
@@ -1,21 +1,29 @@
 ﻿#include <cmath>
 #include <vector>
 #include <memory>
+#include <string>
 #include <cassert>
 #include <numeric>
 #include <algorithm>
 #include <stdexcept>
 #include "tensor.h"
 #include "ops.h"
+#include "opsdetail.h"
+#include "profiler.h"
+#include "backend.h"
 
 namespace SushiAI
 {
+    using detail::applyAutocast;
+
     #pragma region Tensor Operations
 
     #pragma region Addition 
 	
     std::shared_ptr<Tensor> add(const std::shared_ptr<Tensor>& a, const std::shared_ptr<Tensor>& b)
     {
+        ProfileScope scope("add", "forward");
+
         // 1. Rank’leri eşitle
         auto sA = a -> getShape();
         auto sB = b -> getShape();
@@ -55,8 +63,22 @@ namespace SushiAI
         auto& dB = b -> data;
         auto& dR = result -> data;
 
+        // Same shape and bias-style row broadcasts go straight to the backend; anything else takes the index walk.
+        int cols = sResult[ndim - 1];
+        bool sameShape = sA == sB;
+        bool rowB = !sameShape && sA == sResult && sB.back() == cols && (int)b -> getTotalSize() == cols;
+        bool rowA = !sameShape && sB == sResult && sA.back() == cols && (int)a -> getTotalSize() == cols;
+
+        const Backend& be = backend();
+        if (sameShape)
+            be.add(dA.data(), dB.data(), dR.data(), N);
+        else if (rowB)
+            be.addRow(dA.data(), dB.data(), dR.data(), N / cols, cols);
+        else if (rowA)
+            be.addRow(dB.data(), dA.data(), dR.data(), N / cols, cols);
+
         std::vector<int> idx(ndim);
-        for (int flat = 0; flat < N; ++flat) 
+        for (int flat = (sameShape || rowA || rowB) ? N : 0; flat < N; ++flat) 
         {
             int tmp = flat, offA = 0, offB = 0;
             for (int d = ndim - 1; d >= 0; --d) 
@@ -75,6 +97,8 @@ namespace SushiAI
             dR[flat] = dA[offA] + dB[offB];
         }
 
+        applyAutocast(result);
+
         // 5. Backward
         if (result -> requiresGradient) 
         {
@@ -83,12 +107,38 @@ namespace SushiAI
             auto b_ptr = b -> shared_from_this();
             auto result_ptr = result;
 
-            result -> setGradientFunction([a_ptr, b_ptr, result_ptr, sA, sB, stA, stB, sResult]()
+            result -> setGradientFunction([a_ptr, b_ptr, result_ptr, sA, sB, stA, stB, sResult, sameShape, rowA, rowB, layer = scope.getLayer()]()
             {
+                ProfileScope scope("add", "backward", layer);
                 const auto& gradR = result_ptr -> getGradient();
                 auto& gradA = a_ptr -> getGradient();
                 auto& gradB = b_ptr -> getGradient();
                 int N = (int)gradR.size();
+                scope.setCost(N, 3.0 * N * sizeof(float));
+
+                if (sameShape || rowA || rowB)
+                {
+                    const Backend& be = backend();
+                    int cols = sResult.back();
+
+                    if (a_ptr -> requiresGradient)
+                    {
+                        if (rowA)
+                            be.accumulateRows(gradR.data(), gradA.data(), N / cols, cols);
+                        else
+                            be.accumulate(gradR.data(), gradA.data(), N);
+                    }
+                    if (b_ptr -> requiresGradient)
+                    {
+                        if (rowB)
+                            be.accumulateRows(gradR.data(), gradB.data(), N / cols, cols);
+                        else
+                            be.accumulate(gradR.data(), gradB.data(), N);
+                    }
+
+                    return;
+                }
+
                 std::vector<int> idx(sResult.size());
 
                 for (int flat = 0; flat < N; ++flat) 
@@ -115,6 +165,12 @@ namespace SushiAI
             }, { a_ptr, b_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(N, (a -> getTotalSize() + b -> getTotalSize() + N) * (double)sizeof(float));
+        }
+
         return result;
     }
 
@@ -138,6 +194,8 @@ namespace SushiAI
         // --- 2) 3D batch matmul [batch, M, K] × [batch, K, N] → [batch, M, N] ---
         else if (sA.size() == 3 && sB.size() == 3) 
         {
+            ProfileScope scope("mul", "forward");
+
             int batch = sA[0];
             int M = sA[1];
             int K = sA[2];
@@ -151,26 +209,10 @@ namespace SushiAI
             auto result = std::make_shared<Tensor>(std::vector<int>{batch, M, N}, 0.0f, a -> requiresGradient || b -> requiresGradient);
 
             // --- Forward ---
-            for (int bi = 0; bi < batch; ++bi) 
-            {
-                int offA = bi * (M * K);
-                int offB = bi * (K * N);
-                int offR = bi * (M * N);
+            backend().gemmBatched(false, false, M, N, K, a -> data.data(), (size_t)M * K, b -> data.data(), (size_t)K * N,
+                result -> data.data(), (size_t)M * N, batch);
 
-                for (int i = 0; i < M; ++i) 
-                {
-                    for (int kk = 0; kk < K; ++kk) 
-                    {
-                        float a_val = a -> data[offA + i * K + kk];
-
-                        for (int j = 0; j < N; ++j) 
-                        {
-                            result -> data[offR + i * N + j] +=
-                                a_val * b -> data[offB + kk * N + j];
-                        }
-                    }
-                }
-            }
+            applyAutocast(result);
 
             // --- Backward ---
             if (result -> requiresGradient) 
@@ -179,39 +221,30 @@ namespace SushiAI
                 auto b_ptr = b;
                 auto result_ptr = result;
 
-                result->setGradientFunction([a_ptr, b_ptr, result_ptr, batch, M, K, N]() 
+                result->setGradientFunction([a_ptr, b_ptr, result_ptr, batch, M, K, N, layer = scope.getLayer()]() 
                 {
+                    ProfileScope scope("mul", "backward", layer);
+                    scope.setCost(4.0 * batch * M * K * N, 2.0 * batch * ((double)M * K + (double)K * N + (double)M * N) * sizeof(float));
+
                     const auto& gR = result_ptr -> gradient;
                     auto& gA = a_ptr -> gradient;
                     auto& gB = b_ptr -> gradient;
+                    const Backend& be = backend();
 
-                    for (int bi = 0; bi < batch; ++bi) 
-                    {
-                        int offA = bi * (M * K);
-                        int offB = bi * (K * N);
-                        int offR = bi * (M * N);
-
-                        for (int i = 0; i < M; ++i) 
-                        {
-                            for (int kk = 0; kk < K; ++kk) 
-                            {
-                                float sumA = 0.0f;
-
-                                for (int j = 0; j < N; ++j) 
-                                {
-                                    float grad_out = gR[offR + i * N + j];
-                                    // dB = Aᵢₖ * grad_out
-                                    gB[offB + kk * N + j] += a_ptr -> data[offA + i * K + kk] * grad_out;
-                                    sumA += grad_out * b_ptr -> data[offB + kk * N + j];
-                                }
-                                // dA = Σ_j (grad_out * Bₖⱼ)
-                                gA[offA + i * K + kk] += sumA;
-                            }
-                        }
-                    }
+                    // dA = dR · Bᵀ, dB = Aᵀ · dR per batch, each only when that operand wants a gradient
+                    if (a_ptr -> requiresGradient)
+                        be.gemmBatched(false, true, M, K, N, gR.data(), (size_t)M * N, b_ptr -> data.data(), (size_t)K * N, gA.data(), (size_t)M * K, batch);
+                    if (b_ptr -> requiresGradient)
+                        be.gemmBatched(true, false, K, N, M, a_ptr -> data.data(), (size_t)M * K, gR.data(), (size_t)M * N, gB.data(), (size_t)K * N, batch);
                 }, { a_ptr, b_ptr });
             }
 
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost(2.0 * batch * M * K * N, (double)batch * ((double)M * K + (double)K * N + (double)M * N) * sizeof(float));
+            }
+
             return result;
         }
         else
@@ -220,30 +253,48 @@ namespace SushiAI
 
     std::shared_ptr<Tensor> matmul(const std::shared_ptr<Tensor>& a, const std::shared_ptr<Tensor>& b)
     {
+        ProfileScope scope("matmul", "forward");
+
         const auto& A = a -> getData();
         const auto& B = b -> getData();
-        int m = a -> getShape()[0];
-        int k = a -> getShape()[1];
+        const auto& shapeA = a -> getShape();
+
+        if (shapeA.size() < 2 || b -> getShape().size() != 2 || shapeA.back() != b -> getShape()[0])
+            throw std::invalid_argument("matmul: expects [..., K] · [K, N]");
+
+        // Leading axes of a are rows of one GEMM: [B, T, K] · [K, N] needs no reshape copy
+        int k = shapeA.back();
+        int m = a -> getTotalSize() / k;
         int n = b -> getShape()[1];
 
-        auto result = std::make_shared<Tensor>(std::vector<int>{ m, n }, 0.0f, a -> requiresGradient || b -> requiresGradient);
+        std::vector<int> shapeR(shapeA.begin(), shapeA.end() - 1);
+        shapeR.push_back(n);
+
+        auto result = std::make_shared<Tensor>(shapeR, 0.0f, a -> requiresGradient || b -> requiresGradient);
         auto& R = result -> getData();
 
-        // Forward: for cache-friendly access, accumulate over k
-        for (int i = 0; i < m; ++i)
-        {
-            int rowA = i * k;
-            int rowR = i * n;
+        DType autocast = autocastDType();
 
-            for (int l = 0; l < k; ++l)
+        if (autocast != DType::Float32)
+        {
+            // Mixed precision emulation: operands rounded to the autocast dtype, products accumulate in fp32.
+            // Operands already at that dtype (weights kept rounded, autocast activations) are read in place.
+            thread_local std::vector<float> roundedA, roundedB;
+            auto operand = [autocast](const Tensor& t, std::vector<float>& scratch)
             {
-                float a_val = A[rowA + l];
-                int rowB = l * n;
+                if (t.dtype == autocast)
+                    return t.data.data();
 
-                for (int j = 0; j < n; ++j)
-                    R[rowR + j] += a_val * B[rowB + j];
-            }
+                scratch.assign(t.data.begin(), t.data.end());
+                roundToDType(autocast, scratch.data(), scratch.size());
+                return (const float*)scratch.data();
+            };
+
+            backend().gemm(false, false, m, n, k, operand(*a, roundedA), k, operand(*b, roundedB), n, R.data(), n);
+            result -> toDType(autocast);
         }
+        else
+            backend().gemm(false, false, m, n, k, A.data(), k, B.data(), n, R.data(), n);
 
         if (result -> requiresGradient)
         {
@@ -251,8 +302,11 @@ namespace SushiAI
             auto b_ptr = b;
             auto result_ptr = result;
 
-            result -> setGradientFunction([a_ptr, b_ptr, result_ptr, m, k, n]()
+            result -> setGradientFunction([a_ptr, b_ptr, result_ptr, m, k, n, layer = scope.getLayer()]()
             {
+                ProfileScope scope("matmul", "backward", layer);
+                scope.setCost(4.0 * m * k * n, (2.0 * m * k + 2.0 * k * n + (double)m * n) * sizeof(float));
+
                 const auto& A = a_ptr -> getData();
                 const auto& B = b_ptr -> getData();
 
@@ -260,48 +314,32 @@ namespace SushiAI
                 auto& dA = a_ptr -> gradient;
                 auto& dB = b_ptr -> gradient;
 
-                // dA = dR · B^T
-                for (int i = 0; i < m; ++i)
-                {
-                    int rowA = i * k;
-                    int rowR = i * n;
-
-                    for (int l = 0; l < k; ++l)
-                    {
-                        float sum = 0.0f;
-                        int rowB = l * n;
+                const Backend& be = backend();
 
-                        for (int j = 0; j < n; ++j)
-                            sum += dR[rowR + j] * B[rowB + j];
-
-                        dA[rowA + l] += sum;
-                    }
-                }
+                // dA = dR · B^T (skipped for inputs and frozen weights)
+                if (a_ptr -> requiresGradient)
+                    be.gemm(false, true, m, k, n, dR.data(), n, B.data(), n, dA.data(), k);
 
                 // dB = A^T · dR
-                for (int l = 0; l < k; ++l)
-                {
-                    int rowB = l * n;
-
-                    for (int j = 0; j < n; ++j)
-                    {
-                        float sum = 0.0f;
-
-                        for (int i = 0; i < m; ++i)
-                            sum += A[i * k + l] * dR[i * n + j];
-
-                        dB[rowB + j] += sum;
-                    }
-                }
+                if (b_ptr -> requiresGradient)
+                    be.gemm(true, false, k, n, m, A.data(), k, dR.data(), n, dB.data(), n);
             }, { a_ptr, b_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(2.0 * m * k * n, ((double)m * k + (double)k * n + (double)m * n) * sizeof(float));
+        }
+
         return result;
     }
 
 
     std::shared_ptr<Tensor> slice(const std::shared_ptr<Tensor>& t, int batchIdx)
     {
+        ProfileScope scope("slice", "forward");
+
         const auto& shape = t->getShape();
         int D = shape.size();
         assert((D == 2 || D == 3) && "slice: only 2D or 3D tensors supported");
@@ -331,8 +369,11 @@ namespace SushiAI
             auto t_ptr = t;
             auto view_ptr = view;
             view->setGradientFunction(
-                [t_ptr, view_ptr, offset, subSize]()
+                [t_ptr, view_ptr, offset, subSize, layer = scope.getLayer()]()
             {
+                ProfileScope scope("slice", "backward", layer);
+                scope.setCost(subSize, 3.0 * subSize * sizeof(float));
+
                 const auto& gV = view_ptr->getGradient();
                 auto& gT = t_ptr->getGradient();
                 for (int i = 0; i < subSize; ++i)
@@ -342,9 +383,88 @@ namespace SushiAI
             );
         }
 
+        if (scope.active())
+        {
+            scope.setShape(view -> getShape());
+            scope.setCost(0.0, 2.0 * subSize * sizeof(float));
+        }
+
         return view;
     }
 
+    std::shared_ptr<Tensor> embedding(const std::shared_ptr<Tensor>& weight, const std::shared_ptr<Tensor>& indices)
+    {
+        ProfileScope scope("embedding", "forward");
+
+        if (weight -> getShape().size() != 2)
+            throw std::invalid_argument("embedding: weight must be [vocab, dim]");
+
+        const int vocab = weight -> getShape()[0], dim = weight -> getShape()[1];
+        const int count = indices -> getTotalSize();
+
+        std::vector<int> rows(count);
+        for (int i = 0; i < count; ++i)
+        {
+            float v = indices -> getData()[i];
+            if (!(v >= 0.0f && v < (float)vocab))
+                throw std::invalid_argument("embedding: index " + std::to_string(v) + " outside [0, " + std::to_string(vocab) + ")");
+            rows[i] = (int)v;
+        }
+
+        std::vector<int> shape = indices -> getShape();
+        shape.push_back(dim);
+
+        auto result = std::make_shared<Tensor>(shape, 0.0f, weight -> requiresGradient);
+        const float* W = weight -> getData().data();
+        float* R = result -> getData().data();
+
+        for (int i = 0; i < count; ++i)
+            std::copy(W + (size_t)rows[i] * dim, W + (size_t)(rows[i] + 1) * dim, R + (size_t)i * dim);
+
+        applyAutocast(result);
+
+        if (weight -> requiresGradient)
+        {
+            auto weight_ptr = weight;
+            auto result_ptr = result;
+
+            result -> setGradientFunction([weight_ptr, result_ptr, rows, dim, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("embedding", "backward", layer);
+                scope.setCost((double)rows.size() * dim, 3.0 * rows.size() * dim * sizeof(float));
+
+                const float* dR = result_ptr -> gradient.data();
+
+                // Sparse unless another op gave the table a dense fallback gradient (tied weights)
+                if (weight_ptr -> gradientIsSparse && weight_ptr -> gradient.empty())
+                {
+                    // One gradient row per lookup; the optimizer coalesces repeated indices.
+                    SparseGradient& sparse = weight_ptr -> sparseGradient;
+                    for (size_t i = 0; i < rows.size(); ++i)
+                    {
+                        float* row = sparse.addRow(rows[i]);
+                        std::copy(dR + i * dim, dR + (i + 1) * dim, row);
+                    }
+                }
+                else
+                {
+                    float* dW = weight_ptr -> gradient.data();
+                    for (size_t i = 0; i < rows.size(); ++i)
+                        for (int j = 0; j < dim; ++j)
+                            dW[(size_t)rows[i] * dim + j] += dR[i * dim + j];
+                }
+            }, { weight_ptr }, true);
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(0.0, 2.0 * count * dim * sizeof(float));
+        }
+
+        return result;
+    }
+
     #pragma endregion 
 
     #pragma endregion
@@ -353,112 +473,147 @@ namespace SushiAI
 
     std::shared_ptr<Tensor> relu(const std::shared_ptr<Tensor>& t)
     {
+        ProfileScope scope("relu", "forward");
+
         auto result = std::make_shared<Tensor>(t->getShape(), 0.0f, t->requiresGradient);
 
         const auto& data = t->getData();
         auto& resultData = result->getData();
 
-        for (size_t i = 0; i < data.size(); ++i)
-            resultData[i] = std::max(0.0f, data[i]);
+        backend().relu(data.data(), resultData.data(), data.size());
+
+        applyAutocast(result);
 
         if (t->requiresGradient)
         {
             auto t_ptr = t;
             auto result_ptr = result;
-            result->setGradientFunction([t_ptr, result_ptr]()
+            result->setGradientFunction([t_ptr, result_ptr, layer = scope.getLayer()]()
             {
-                for (size_t i = 0; i < result_ptr->gradient.size(); ++i)
-                    t_ptr->gradient[i] += (result_ptr->data[i] > 0 ? 1.0f : 0.0f) * result_ptr->gradient[i];
+                ProfileScope scope("relu", "backward", layer);
+                scope.setCost(2.0 * result_ptr -> getTotalSize(), 3.0 * result_ptr -> getTotalSize() * sizeof(float));
+
+                backend().reluBackward(result_ptr->data.data(), result_ptr->gradient.data(), t_ptr->gradient.data(), result_ptr->gradient.size());
             }, { t_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost((double)data.size(), 2.0 * data.size() * sizeof(float));
+        }
+
         return result;
     }
 
     std::shared_ptr<Tensor> leakyRelu(const std::shared_ptr<Tensor>& t, float alpha)
     {
+        ProfileScope scope("leakyRelu", "forward");
+
         auto result = std::make_shared<Tensor>(t -> getShape(), 0.0f, t -> requiresGradient);
 
         const auto& data = t -> getData();
         auto& resultData = result -> getData();
 
-        for (size_t i = 0; i < data.size(); ++i)
-            resultData[i] = (data[i] > 0.0f ? data[i] : alpha * data[i]);
+        backend().leakyRelu(data.data(), resultData.data(), data.size(), alpha);
+
+        applyAutocast(result);
 
         if (t -> requiresGradient)
         {
             auto t_ptr = t -> shared_from_this();
             auto result_ptr = result;
 
-            result -> setGradientFunction([t_ptr, result_ptr, alpha]()
+            result -> setGradientFunction([t_ptr, result_ptr, alpha, layer = scope.getLayer()]()
             {
+                ProfileScope scope("leakyRelu", "backward", layer);
+                scope.setCost(2.0 * result_ptr -> getTotalSize(), 3.0 * result_ptr -> getTotalSize() * sizeof(float));
+
                 const auto& outGrad = result_ptr -> getGradient();
                 auto& inGrad = t_ptr -> getGradient();
                 const auto& x = t_ptr -> getData();
 
-                for (size_t i = 0; i < x.size(); ++i)
-                {
-                    float grad_coeff = (x[i] > 0.0f ? 1.0f : alpha);
-                    inGrad[i] += grad_coeff * outGrad[i];
-                }
+                backend().leakyReluBackward(x.data(), outGrad.data(), inGrad.data(), x.size(), alpha);
             }, { t_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost((double)data.size(), 2.0 * data.size() * sizeof(float));
+        }
+
         return result;
     }
 
     std::shared_ptr<Tensor> sigmoid(const std::shared_ptr<Tensor>& t)
     {
+        ProfileScope scope("sigmoid", "forward");
+
         auto result = std::make_shared<Tensor>(t -> getShape(), 0.0f, t -> requiresGradient);
 
         const auto& data = t -> getData();
         auto& resultData = result -> getData();
 
-        for (size_t i = 0; i < data.size(); ++i)
-            resultData[i] = 1.0f / (1.0f + std::exp(-data[i]));
+        backend().sigmoid(data.data(), resultData.data(), data.size());
+
+        applyAutocast(result);
 
         if (t -> requiresGradient)
         {
             auto t_ptr = t -> shared_from_this();
 
             auto result_ptr = result;
-            result -> setGradientFunction([t_ptr, result_ptr]()
+            result -> setGradientFunction([t_ptr, result_ptr, layer = scope.getLayer()]()
             {
-                for (size_t i = 0; i < result_ptr -> gradient.size(); ++i)
-                {
-                    float sig = result_ptr -> data[i];
-                    t_ptr -> gradient[i] += sig * (1 - sig) * result_ptr -> gradient[i];
-                }
+                ProfileScope scope("sigmoid", "backward", layer);
+                scope.setCost(3.0 * result_ptr -> getTotalSize(), 3.0 * result_ptr -> getTotalSize() * sizeof(float));
+
+                backend().sigmoidBackward(result_ptr -> data.data(), result_ptr -> gradient.data(), t_ptr -> gradient.data(), result_ptr -> gradient.size());
             }, { t_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(4.0 * data.size(), 2.0 * data.size() * sizeof(float));
+        }
+
         return result;
     }
 
     std::shared_ptr<Tensor> tanh(const std::shared_ptr<Tensor>& t)
     {
+        ProfileScope scope("tanh", "forward");
+
         auto result = std::make_shared<Tensor>(t -> getShape(), 0.0f, t -> requiresGradient);
         const auto& data = t -> getData();
         auto& resultData = result -> getData();
 
-        for (size_t i = 0; i < data.size(); ++i)
-            resultData[i] = std::tanh(data[i]);
+        backend().tanh(data.data(), resultData.data(), data.size());
+
+        applyAutocast(result);
 
         if (t -> requiresGradient)
         {
             auto t_ptr = t -> shared_from_this();
 
             auto result_ptr = result;
-            result -> setGradientFunction([t_ptr, result_ptr]()
+            result -> setGradientFunction([t_ptr, result_ptr, layer = scope.getLayer()]()
             {
-                for (size_t i = 0; i < result_ptr -> gradient.size(); ++i)
-                {
-                    float tanhval = result_ptr -> data[i];
-                    t_ptr -> gradient[i] += (1.0f - tanhval * tanhval) * result_ptr -> gradient[i];
-                }
+                ProfileScope scope("tanh", "backward", layer);
+                scope.setCost(3.0 * result_ptr -> getTotalSize(), 3.0 * result_ptr -> getTotalSize() * sizeof(float));
+
+                backend().tanhBackward(result_ptr -> data.data(), result_ptr -> gradient.data(), t_ptr -> gradient.data(), result_ptr -> gradient.size());
             }, { t_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(4.0 * data.size(), 2.0 * data.size() * sizeof(float));
+        }
+
         return result;
     }
 
@@ -470,30 +625,28 @@ namespace SushiAI
 
     std::shared_ptr<Tensor> softmax(const std::shared_ptr<Tensor>& t)
     {
+        ProfileScope scope("softmax", "forward");
+
         auto result = std::make_shared<Tensor>(t -> getShape(), 0.0f, t -> requiresGradient);
 
         const auto& x = t -> getData();
         auto& s = result -> getData();
 
         // Numerically stable softmax
-        float maxV = *std::max_element(x.begin(), x.end());
-        float sumExp = 0.0f;
-        for (size_t i = 0; i < x.size(); ++i)
-        {
-            s[i] = std::exp(x[i] - maxV);
-            sumExp += s[i];
-        }
+        backend().softmax(x.data(), s.data(), x.size());
 
-        for (size_t i = 0; i < s.size(); ++i)
-            s[i] /= sumExp;
+        applyAutocast(result);
 
         if (t -> requiresGradient)
         {
             auto t_ptr = t -> shared_from_this();
             auto result_ptr = result;
 
-            result -> setGradientFunction([t_ptr, result_ptr]()
+            result -> setGradientFunction([t_ptr, result_ptr, layer = scope.getLayer()]()
             {
+                ProfileScope scope("softmax", "backward", layer);
+                scope.setCost(4.0 * result_ptr -> getTotalSize(), 3.0 * result_ptr -> getTotalSize() * sizeof(float));
+
                 const auto& s = result_ptr -> data;
                 const auto& gradOut = result_ptr -> gradient;
                 auto& gradIn = t_ptr -> gradient;
@@ -510,6 +663,12 @@ namespace SushiAI
             }, { t_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(4.0 * x.size(), 2.0 * x.size() * sizeof(float));
+        }
+
         return result;
     }
 
@@ -542,6 +701,8 @@ namespace SushiAI
 
     std::shared_ptr<Tensor> crossEntropyLoss(const std::shared_ptr<Tensor>& logits, const std::shared_ptr<Tensor>& targets)
     {
+        ProfileScope scope("crossEntropyLoss", "forward");
+
         assert(logits -> getShape() == targets -> getShape());
 
         const auto& x = logits -> getData();
@@ -580,8 +741,14 @@ namespace SushiAI
             auto tgt_ptr = targets -> shared_from_this();
             auto res_ptr = result;
 
-            result -> setGradientFunction([log_ptr, tgt_ptr, res_ptr, s, N]() mutable
+            result -> setGradientFunction([log_ptr, tgt_ptr, res_ptr, s, N, layer = scope.getLayer()]() mutable
             {
+                ProfileScope scope("crossEntropyLoss", "backward", layer);
+                scope.setCost(3.0 * N, 3.0 * N * sizeof(float));
+
+                if (!log_ptr -> requiresGradient)
+                    return;
+
                 float gradOut = res_ptr -> gradient[0] / static_cast<float>(N);
                 auto& gradX = log_ptr -> gradient;
                 const auto& yv = tgt_ptr -> getData();
@@ -592,6 +759,12 @@ namespace SushiAI
             }, { log_ptr, tgt_ptr });
         }
 
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(6.0 * N, 2.0 * N * sizeof(float));
+        }
+
         return result;
     }
 
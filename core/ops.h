@@ -10,9 +10,70 @@ namespace SushiAI
 
 
 	std::shared_ptr<Tensor> mul(const std::shared_ptr<Tensor>& a, const std::shared_ptr<Tensor>& b);
-	/// Matrix Multiplication
+	/// Matrix Multiplication: [..., K] · [K, N] → [..., N], the leading axes of a folded into the rows of one GEMM.
 	std::shared_ptr<Tensor> matmul(const std::shared_ptr<Tensor>& a, const std::shared_ptr<Tensor>& b);
 	std::shared_ptr<Tensor> slice(const std::shared_ptr<Tensor>& t, int index);
+	/// Gathers rows of weight [vocab, dim] at the (integer-valued) entries of indices: shape [..., dim].
+	/// Backward appends one row per lookup to weight's sparse gradient when it has one, else scatters densely.
+	std::shared_ptr<Tensor> embedding(const std::shared_ptr<Tensor>& weight, const std::shared_ptr<Tensor>& indices);
+
+	#pragma endregion
+
+	#pragma region Convolution
+
+	/// 2-D convolution of an NCHW input [N, C, H, W] with weight [C_out, C / groups, kH, kW] and an optional bias [C_out]
+	/// (nullptr for none). Output is [N, C_out, (H + 2p - d(kH - 1) - 1) / s + 1, ...]. Lowered onto the backend GEMM
+	/// through im2col; 1×1 stride-1 convolutions skip the im2col copy and depthwise ones use a direct kernel.
+	std::shared_ptr<Tensor> conv2d(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& weight, const std::shared_ptr<Tensor>& bias,
+		int stride = 1, int padding = 0, int dilation = 1, int groups = 1);
+
+	#pragma endregion
+
+	#pragma region Pooling
+
+	/// Max over kernel × kernel windows of an NCHW input; padding counts as -inf. Backward scatters through
+	/// the saved argmax of each window (a 2-byte tap index per output).
+	std::shared_ptr<Tensor> maxPool2d(const std::shared_ptr<Tensor>& t, int kernel, int stride, int padding = 0);
+	/// Mean over kernel × kernel windows; padded positions count as zeros in the mean.
+	std::shared_ptr<Tensor> avgPool2d(const std::shared_ptr<Tensor>& t, int kernel, int stride, int padding = 0);
+	/// Mean over outH × outW bins covering the whole input, whatever its size: [N, C, H, W] → [N, C, outH, outW].
+	std::shared_ptr<Tensor> adaptiveAvgPool2d(const std::shared_ptr<Tensor>& t, int outH, int outW);
+	/// Mean of every channel plane: [N, C, H, W] → [N, C], ready for a Linear head.
+	std::shared_ptr<Tensor> globalAvgPool2d(const std::shared_ptr<Tensor>& t);
+
+	#pragma endregion
+
+	#pragma region Attention
+
+	/// softmax(Q K^T / sqrt(D)) V for q [B, Tq, E] and k, v [B, Tk, E] split into heads of D = E / heads columns.
+	/// Tiled online softmax: never holds more than one block of scores, and backward recomputes them from the
+	/// saved per-row log-sum-exp. causal hides key j from query i when j > i. Parallel over batch × heads.
+	std::shared_ptr<Tensor> scaledDotProductAttention(const std::shared_ptr<Tensor>& q, const std::shared_ptr<Tensor>& k, const std::shared_ptr<Tensor>& v,
+		int heads, bool causal = false);
+
+	#pragma endregion
+
+	#pragma region Recurrent
+
+	/// LSTM over batch-first sequences [B, T, I] from zero initial state, returning every hidden state [B, T, H].
+	/// Gate blocks are [input, forget, candidate, output]: inputWeights [I, 4H], recurrentWeights [H, 4H], bias [4H].
+	/// The input projection of all steps is one GEMM; backward through time is a single node.
+	std::shared_ptr<Tensor> lstm(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& inputWeights,
+		const std::shared_ptr<Tensor>& recurrentWeights, const std::shared_ptr<Tensor>& bias);
+	/// GRU with the same layout and gate blocks [reset, update, candidate]: n = tanh(x Wn + bn + r ∘ (h Whn + bhn)),
+	/// h' = (1 - z) ∘ n + z ∘ h. The recurrent bias is separate because the reset gate scales it.
+	std::shared_ptr<Tensor> gru(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& inputWeights,
+		const std::shared_ptr<Tensor>& recurrentWeights, const std::shared_ptr<Tensor>& inputBias, const std::shared_ptr<Tensor>& recurrentBias);
+
+	#pragma endregion
+
+	#pragma region Normalization
+
+	/// (x - mean) / sqrt(var + eps) · gamma + beta over the last axis of t. gamma and beta may be nullptr.
+	/// Statistics come from one Welford pass; backward needs only the saved per-row mean and rstd.
+	std::shared_ptr<Tensor> layerNorm(const std::shared_ptr<Tensor>& t, const std::shared_ptr<Tensor>& gamma, const std::shared_ptr<Tensor>& beta, float eps = 1e-5f);
+	/// x / sqrt(mean(x²) + eps) · gamma over the last axis of t. gamma may be nullptr.
+	std::shared_ptr<Tensor> rmsNorm(const std::shared_ptr<Tensor>& t, const std::shared_ptr<Tensor>& gamma, float eps = 1e-5f);
 
 	#pragma endregion
 
@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <algorithm>
+#include "tensor.h"
+#include "half.h"
+
+/// Helpers shared by the op translation units (ops, conv, pooling, attention, recurrent, normalization).
+/// Not part of the public op API: include it from .cpp files only.
+namespace SushiAI
+{
+    namespace detail
+    {
+        /// Under autocast, rounds an op's output to the autocast precision and tags it.
+        inline void applyAutocast(const std::shared_ptr<Tensor>& t)
+        {
+            DType dtype = autocastDType();
+            if (dtype != DType::Float32)
+                t -> toDType(dtype);
+        }
+
+        /// Output positions [begin, end) of a strided window whose tap at input index o * stride + shift
+        /// lands inside [0, size), clamped to [0, outSize).
+        inline void validRange(int shift, int stride, int size, int outSize, int& begin, int& end)
+        {
+            begin = shift >= 0 ? 0 : (-shift + stride - 1) / stride;
+            end = size - shift <= 0 ? 0 : std::min(outSize, (size - shift + stride - 1) / stride);
+            begin = std::min(begin, end);
+        }
+    }
+}
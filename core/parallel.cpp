@@ -0,0 +1,214 @@
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "parallel.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace SushiAI
+{
+    #pragma region NUMA Topology
+
+    namespace
+    {
+        /// Pool whose worker is running on this thread, used to keep nested run() calls from deadlocking.
+        thread_local const ThreadPool* currentPool = nullptr;
+
+        /// Parses a sysfs cpulist such as "0-3,8-11".
+        std::vector<int> parseCpuList(const std::string& text)
+        {
+            std::vector<int> cpus;
+            std::stringstream ss(text);
+            std::string range;
+
+            while (std::getline(ss, range, ','))
+            {
+                if (range.empty())
+                    continue;
+
+                size_t dash = range.find('-');
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+                for (int c = first; c <= last; ++c)
+                    cpus.push_back(c);
+            }
+
+            return cpus;
+        }
+    }
+
+    std::vector<std::vector<int>> numaNodeCpus()
+    {
+        std::vector<std::vector<int>> nodes;
+
+        #ifdef __linux__
+        for (int node = 0; ; ++node)
+        {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!file)
+                break;
+
+            std::string line;
+            std::getline(file, line);
+
+            auto cpus = parseCpuList(line);
+            if (!cpus.empty())
+                nodes.push_back(std::move(cpus));
+        }
+        #endif
+
+        if (nodes.empty())
+        {
+            std::vector<int> all(std::max(1u, std::thread::hardware_concurrency()));
+            for (size_t i = 0; i < all.size(); ++i)
+                all[i] = (int)i;
+
+            nodes.push_back(std::move(all));
+        }
+
+        return nodes;
+    }
+
+    bool pinCurrentThread(const std::vector<int>& cpus)
+    {
+        #ifdef __linux__
+        if (cpus.empty())
+            return false;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus)
+            CPU_SET(c, &set);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        #else
+        (void)cpus;
+        return false;
+        #endif
+    }
+
+    #pragma endregion
+
+    #pragma region Thread Pool
+
+    ThreadPool::ThreadPool(int threads, const std::vector<std::vector<int>>& cpuSets)
+    {
+        threads = std::max(1, threads);
+
+        for (int i = 0; i < threads; ++i)
+        {
+            std::vector<int> cpus = i < (int)cpuSets.size() ? cpuSets[i] : std::vector<int>{};
+            workers.emplace_back(&ThreadPool::workerLoop, this, i, std::move(cpus));
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (auto& w : workers)
+            w.join();
+    }
+
+    void ThreadPool::workerLoop(int index, std::vector<int> cpus)
+    {
+        if (!cpus.empty())
+            pinCurrentThread(cpus);
+
+        currentPool = this;
+
+        size_t seen = 0;
+        while (true)
+        {
+            std::function<void(int)> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+
+                if (stopping)
+                    return;
+
+                seen = generation;
+                job = task;
+            }
+
+            job(index);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0)
+                done.notify_all();
+        }
+    }
+
+    void ThreadPool::run(const std::function<void(int)>& fn)
+    {
+        if (currentPool == this)
+        {
+            for (int i = 0; i < size(); ++i)
+                fn(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> serial(runMutex);
+        std::unique_lock<std::mutex> lock(mutex);
+        task = fn;
+        pending = (int)workers.size();
+        ++generation;
+        wake.notify_all();
+
+        done.wait(lock, [this]() { return pending == 0; });
+        task = nullptr;
+    }
+
+    void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& body)
+    {
+        int count = end - begin;
+        if (count <= 0)
+            return;
+
+        int chunks = std::min(size(), count);
+        if (chunks == 1)
+        {
+            body(begin, end);
+            return;
+        }
+
+        run([&](int worker)
+        {
+            if (worker >= chunks)
+                return;
+
+            int chunkBegin = begin + (int)((long long)count * worker / chunks);
+            int chunkEnd = begin + (int)((long long)count * (worker + 1) / chunks);
+            body(chunkBegin, chunkEnd);
+        });
+    }
+
+    ThreadPool& ThreadPool::global()
+    {
+        static ThreadPool pool((int)std::max(1u, std::thread::hardware_concurrency()));
+        return pool;
+    }
+
+    void parallelRange(int count, double work, const std::function<void(int, int)>& body)
+    {
+        const double minParallelWork = 1 << 16;
+        ThreadPool& pool = ThreadPool::global();
+
+        if (pool.size() <= 1 || count < 2 || work < minParallelWork)
+            body(0, count);
+        else
+            pool.parallelFor(0, count, body);
+    }
+
+    #pragma endregion
+}
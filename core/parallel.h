@@ -0,0 +1,131 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+
+namespace SushiAI
+{
+    #pragma region Bounded Queue
+
+    /// Thrown by push() / pop() of a BoundedQueue that was closed.
+    struct QueueClosed : std::runtime_error
+    {
+        QueueClosed() : std::runtime_error("BoundedQueue: closed") {}
+    };
+
+    /// Blocking FIFO with a fixed capacity, used to hand work between threads.
+    /// push() waits while the queue is full, pop() waits while it is empty.
+    template <typename T>
+    class BoundedQueue
+    {
+        private:
+            std::deque<T> items;
+            size_t capacity;
+            bool closed = false;
+            std::mutex mutex;
+            std::condition_variable notFull;
+            std::condition_variable notEmpty;
+
+        public:
+            explicit BoundedQueue(size_t capacity = 1) : capacity(capacity == 0 ? 1 : capacity) {}
+
+            void push(T item)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+                if (closed)
+                    throw QueueClosed();
+
+                items.push_back(std::move(item));
+                notEmpty.notify_one();
+            }
+
+            T pop()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+                if (closed)
+                    throw QueueClosed();
+
+                T item = std::move(items.front());
+                items.pop_front();
+                notFull.notify_one();
+
+                return item;
+            }
+
+            size_t size()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                return items.size();
+            }
+
+            /// Wakes every waiting push() and pop() and makes them, and all later calls, throw QueueClosed.
+            /// Lets the threads on the other side unwind when one side fails.
+            void close()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closed = true;
+                notFull.notify_all();
+                notEmpty.notify_all();
+            }
+    };
+
+    #pragma endregion
+
+    #pragma region Thread Pool
+
+    /// CPU ids of every NUMA node (Linux sysfs). Falls back to a single node holding all CPUs.
+    std::vector<std::vector<int>> numaNodeCpus();
+
+    /// Restricts the calling thread to the given CPUs. Returns false when pinning is not supported.
+    bool pinCurrentThread(const std::vector<int>& cpus);
+
+    /// Fixed set of persistent worker threads. run() executes a task once on every worker and waits for all of them.
+    /// Worker i can be pinned to a CPU set, so memory it first touches stays on that NUMA node.
+    class ThreadPool
+    {
+        private:
+            std::vector<std::thread> workers;
+            std::function<void(int)> task;
+            std::mutex mutex;
+            std::mutex runMutex;
+            std::condition_variable wake;
+            std::condition_variable done;
+            size_t generation = 0;
+            int pending = 0;
+            bool stopping = false;
+
+            void workerLoop(int index, std::vector<int> cpus);
+
+        public:
+            /// cpuSets[i] (if given) is the CPU set worker i is pinned to.
+            explicit ThreadPool(int threads, const std::vector<std::vector<int>>& cpuSets = {});
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /// Calls fn(workerIndex) on every worker in parallel. Calls from inside a worker run inline, serially.
+            void run(const std::function<void(int)>& fn);
+            /// Splits [begin, end) into one contiguous chunk per worker and calls body(chunkBegin, chunkEnd).
+            void parallelFor(int begin, int end, const std::function<void(int, int)>& body);
+
+            int size() const { return (int)workers.size(); }
+
+            /// Process-wide pool with one worker per hardware thread.
+            static ThreadPool& global();
+    };
+
+    /// Runs body(begin, end) over [0, count), split across the global pool when `work` (scalar operations,
+    /// roughly) is enough to pay for the hand-off, else inline. Chunks must be independent of each other.
+    void parallelRange(int count, double work, const std::function<void(int, int)>& body);
+
+    #pragma endregion
+}
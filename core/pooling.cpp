@@ -0,0 +1,545 @@
+#include <limits>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "tensor.h"
+#include "ops.h"
+#include "opsdetail.h"
+#include "profiler.h"
+#include "parallel.h"
+#include "vectormath.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using namespace simd;
+        using namespace detail;
+
+        struct PoolGeometry
+        {
+            int batch, channels, height, width;
+            int kernel, stride, padding;
+            int outH, outW;
+
+            int planes() const { return batch * channels; }
+            int inPlane() const { return height * width; }
+            int outPlane() const { return outH * outW; }
+
+            /// Output columns [begin, end) whose tap at kernel offset `offset` lands inside [0, size).
+            void validRange(int offset, int size, int outSize, int& begin, int& end) const
+            {
+                detail::validRange(offset - padding, stride, size, outSize, begin, end);
+            }
+
+            /// Kernel rows [begin, end) of output row oh that fall inside the input.
+            void validRows(int oh, int& begin, int& end) const
+            {
+                begin = std::max(0, padding - oh * stride);
+                end = std::min(kernel, height + padding - oh * stride);
+            }
+
+            /// Output columns [begin, end) that run vectorized: every tap of the Lanes windows starting at a
+            /// column is inside the input row, including the extra float a stride-2 load reads.
+            void vectorColumns(int& begin, int& end) const
+            {
+                int unused, last;
+                validRange(0, width, outW, begin, unused);
+                validRange(kernel - 1, width, outW, unused, last);
+
+                int overread = stride == 2 ? 1 : 0;
+                end = begin;
+                while (end + Lanes <= last && (end + Lanes - 1) * stride + overread + kernel - 1 - padding < width)
+                    end += Lanes;
+            }
+        };
+
+        PoolGeometry poolGeometry(const std::string& op, const std::vector<int>& shape, int kernel, int stride, int padding)
+        {
+            if (shape.size() != 4)
+                throw std::invalid_argument(op + ": expected an input [N, C, H, W]");
+            if (kernel < 1 || stride < 1 || padding < 0 || padding > kernel / 2)
+                throw std::invalid_argument(op + ": needs kernel >= 1, stride >= 1 and 0 <= padding <= kernel / 2");
+
+            PoolGeometry g{ shape[0], shape[1], shape[2], shape[3], kernel, stride, padding, 0, 0 };
+            g.outH = (g.height + 2 * padding - kernel) / stride + 1;
+            g.outW = (g.width + 2 * padding - kernel) / stride + 1;
+
+            if (g.outH <= 0 || g.outW <= 0)
+                throw std::invalid_argument(op + ": kernel larger than the padded input");
+
+            return g;
+        }
+
+        /// One kernel tap for Lanes consecutive outputs: p[0], p[stride], p[2·stride], ...
+        vf loadTap(const float* p, int stride)
+        {
+            if (stride == 1)
+                return vload(p);
+            if (stride == 2)
+                return vloadEven(p);
+
+            float lanes[Lanes];
+            for (int l = 0; l < Lanes; ++l)
+                lanes[l] = p[l * stride];
+
+            return vload(lanes);
+        }
+
+        float sumRange(const float* x, int n)
+        {
+            vf acc = vzero();
+            int i = 0;
+            for (; i + Lanes <= n; i += Lanes)
+                acc = vadd(acc, vload(x + i));
+
+            float sum = vsum(acc);
+            for (; i < n; ++i)
+                sum += x[i];
+
+            return sum;
+        }
+
+        /// Adaptive pooling bin i of n over a length-size axis: [floor(i·size/n), ceil((i+1)·size/n)).
+        void adaptiveBin(int i, int n, int size, int& begin, int& end)
+        {
+            begin = (int)((long long)i * size / n);
+            end = (int)(((long long)(i + 1) * size + n - 1) / n);
+        }
+
+        #pragma region Row Kernels
+
+        // One output row at a time: the columns whose windows are fully inside the input keep a register of
+        // Lanes outputs across the whole window, the few border columns take the bounds-checked scalar path.
+
+        template <bool TrackArgmax>
+        void maxPoolRow(const PoolGeometry& g, const float* xp, int oh, float* y, uint16_t* taps)
+        {
+            int kiBegin, kiEnd, vectorBegin, vectorEnd;
+            g.validRows(oh, kiBegin, kiEnd);
+            g.vectorColumns(vectorBegin, vectorEnd);
+
+            auto scalar = [&](int ow)
+            {
+                float best = -std::numeric_limits<float>::infinity();
+                int bestTap = 0;
+
+                for (int ki = kiBegin; ki < kiEnd; ++ki)
+                {
+                    const float* row = xp + (size_t)(oh * g.stride + ki - g.padding) * g.width;
+                    for (int kj = 0; kj < g.kernel; ++kj)
+                    {
+                        int iw = ow * g.stride + kj - g.padding;
+                        if (iw >= 0 && iw < g.width && row[iw] > best)
+                        {
+                            best = row[iw];
+                            bestTap = ki * g.kernel + kj;
+                        }
+                    }
+                }
+
+                y[ow] = best;
+                if (TrackArgmax)
+                    taps[ow] = (uint16_t)bestTap;
+            };
+
+            int ow = 0;
+            for (; ow < vectorBegin; ++ow)
+                scalar(ow);
+
+            for (; ow < vectorEnd; ow += Lanes)
+            {
+                vf best = vset(-std::numeric_limits<float>::infinity()), tap = vzero();
+
+                for (int ki = kiBegin; ki < kiEnd; ++ki)
+                {
+                    const float* row = xp + (size_t)(oh * g.stride + ki - g.padding) * g.width + ow * g.stride - g.padding;
+                    for (int kj = 0; kj < g.kernel; ++kj)
+                    {
+                        vf v = loadTap(row + kj, g.stride);
+
+                        if constexpr (TrackArgmax)
+                        {
+                            // Strictly greater keeps the first maximum of the window, like the scalar path.
+                            vf larger = vgreater(v, best);
+                            best = vselect(larger, v, best);
+                            tap = vselect(larger, vset((float)(ki * g.kernel + kj)), tap);
+                        }
+                        else
+                            best = vmax(best, v);
+                    }
+                }
+
+                vstore(y + ow, best);
+
+                if constexpr (TrackArgmax)
+                {
+                    float lanes[Lanes];
+                    vstore(lanes, tap);
+                    for (int l = 0; l < Lanes; ++l)
+                        taps[ow + l] = (uint16_t)lanes[l];
+                }
+            }
+
+            for (; ow < g.outW; ++ow)
+                scalar(ow);
+        }
+
+        void avgPoolRow(const PoolGeometry& g, const float* xp, int oh, float scale, float* y)
+        {
+            int kiBegin, kiEnd, vectorBegin, vectorEnd;
+            g.validRows(oh, kiBegin, kiEnd);
+            g.vectorColumns(vectorBegin, vectorEnd);
+
+            auto scalar = [&](int ow)
+            {
+                float sum = 0.0f;
+                for (int ki = kiBegin; ki < kiEnd; ++ki)
+                {
+                    const float* row = xp + (size_t)(oh * g.stride + ki - g.padding) * g.width;
+                    for (int kj = 0; kj < g.kernel; ++kj)
+                    {
+                        int iw = ow * g.stride + kj - g.padding;
+                        if (iw >= 0 && iw < g.width)
+                            sum += row[iw];
+                    }
+                }
+
+                y[ow] = sum * scale;
+            };
+
+            int ow = 0;
+            for (; ow < vectorBegin; ++ow)
+                scalar(ow);
+
+            for (; ow < vectorEnd; ow += Lanes)
+            {
+                vf sum = vzero();
+                for (int ki = kiBegin; ki < kiEnd; ++ki)
+                {
+                    const float* row = xp + (size_t)(oh * g.stride + ki - g.padding) * g.width + ow * g.stride - g.padding;
+                    for (int kj = 0; kj < g.kernel; ++kj)
+                        sum = vadd(sum, loadTap(row + kj, g.stride));
+                }
+
+                vstore(y + ow, vmul(sum, vset(scale)));
+            }
+
+            for (; ow < g.outW; ++ow)
+                scalar(ow);
+        }
+
+        #pragma endregion
+    }
+
+    #pragma region Pooling
+
+    std::shared_ptr<Tensor> maxPool2d(const std::shared_ptr<Tensor>& t, int kernel, int stride, int padding)
+    {
+        ProfileScope scope("maxPool2d", "forward");
+
+        const PoolGeometry g = poolGeometry("maxPool2d", t -> getShape(), kernel, stride, padding);
+        auto result = std::make_shared<Tensor>(std::vector<int>{ g.batch, g.channels, g.outH, g.outW }, 0.0f, t -> requiresGradient);
+
+        // Winning tap (ki·kernel + kj) per output, only when backward will need it: 2 bytes per output
+        // instead of a float mask over the input.
+        std::shared_ptr<std::vector<uint16_t>> argmax;
+        if (t -> requiresGradient)
+        {
+            if (kernel * kernel > 65536)
+                throw std::invalid_argument("maxPool2d: kernel too large to record argmax taps");
+            argmax = std::make_shared<std::vector<uint16_t>>((size_t)g.planes() * g.outPlane());
+        }
+
+        const float* X = t -> getData().data();
+        float* Y = result -> getData().data();
+
+        parallelRange(g.planes(), (double)g.planes() * g.outPlane() * kernel * kernel, [&](int planeBegin, int planeEnd)
+        {
+            for (int p = planeBegin; p < planeEnd; ++p)
+                for (int oh = 0; oh < g.outH; ++oh)
+                {
+                    const float* xp = X + (size_t)p * g.inPlane();
+                    size_t rowOffset = (size_t)p * g.outPlane() + (size_t)oh * g.outW;
+
+                    if (argmax)
+                        maxPoolRow<true>(g, xp, oh, Y + rowOffset, argmax -> data() + rowOffset);
+                    else
+                        maxPoolRow<false>(g, xp, oh, Y + rowOffset, nullptr);
+                }
+        });
+
+        applyAutocast(result);
+
+        if (t -> requiresGradient)
+        {
+            auto t_ptr = t;
+            auto result_ptr = result;
+            result -> setGradientFunction([t_ptr, result_ptr, argmax, g, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("maxPool2d", "backward", layer);
+                scope.setCost((double)result_ptr -> getTotalSize(), (3.0 * result_ptr -> getTotalSize() * sizeof(float)) + argmax -> size() * sizeof(uint16_t));
+
+                const float* dY = result_ptr -> gradient.data();
+                float* dX = t_ptr -> gradient.data();
+                const uint16_t* taps = argmax -> data();
+
+                parallelRange(g.planes(), (double)g.planes() * g.outPlane(), [&](int planeBegin, int planeEnd)
+                {
+                    for (int p = planeBegin; p < planeEnd; ++p)
+                    {
+                        float* dxp = dX + (size_t)p * g.inPlane();
+                        size_t offset = (size_t)p * g.outPlane();
+
+                        for (int oh = 0; oh < g.outH; ++oh)
+                            for (int ow = 0; ow < g.outW; ++ow, ++offset)
+                            {
+                                int ih = oh * g.stride + taps[offset] / g.kernel - g.padding;
+                                int iw = ow * g.stride + taps[offset] % g.kernel - g.padding;
+
+                                // A window made only of -inf (or padding) keeps tap 0, which can point into the padding.
+                                if (ih >= 0 && ih < g.height && iw >= 0 && iw < g.width)
+                                    dxp[(size_t)ih * g.width + iw] += dY[offset];
+                            }
+                    }
+                });
+            }, { t_ptr });
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost((double)result -> getTotalSize() * kernel * kernel, (double)(t -> getTotalSize() + result -> getTotalSize()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<Tensor> avgPool2d(const std::shared_ptr<Tensor>& t, int kernel, int stride, int padding)
+    {
+        ProfileScope scope("avgPool2d", "forward");
+
+        const PoolGeometry g = poolGeometry("avgPool2d", t -> getShape(), kernel, stride, padding);
+        auto result = std::make_shared<Tensor>(std::vector<int>{ g.batch, g.channels, g.outH, g.outW }, 0.0f, t -> requiresGradient);
+
+        const float* X = t -> getData().data();
+        float* Y = result -> getData().data();
+        const float scale = 1.0f / (kernel * kernel);
+
+        parallelRange(g.planes(), (double)g.planes() * g.outPlane() * kernel * kernel, [&](int planeBegin, int planeEnd)
+        {
+            for (int p = planeBegin; p < planeEnd; ++p)
+                for (int oh = 0; oh < g.outH; ++oh)
+                    avgPoolRow(g, X + (size_t)p * g.inPlane(), oh, scale, Y + (size_t)p * g.outPlane() + (size_t)oh * g.outW);
+        });
+
+        applyAutocast(result);
+
+        if (t -> requiresGradient)
+        {
+            auto t_ptr = t;
+            auto result_ptr = result;
+            result -> setGradientFunction([t_ptr, result_ptr, g, scale, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("avgPool2d", "backward", layer);
+                scope.setCost((double)result_ptr -> getTotalSize() * g.kernel * g.kernel, 3.0 * t_ptr -> getTotalSize() * sizeof(float));
+
+                const float* dY = result_ptr -> gradient.data();
+                float* dX = t_ptr -> gradient.data();
+
+                parallelRange(g.planes(), (double)g.planes() * g.outPlane() * g.kernel * g.kernel, [&](int planeBegin, int planeEnd)
+                {
+                    for (int p = planeBegin; p < planeEnd; ++p)
+                    {
+                        float* dxp = dX + (size_t)p * g.inPlane();
+
+                        for (int oh = 0; oh < g.outH; ++oh)
+                        {
+                            const float* dyRow = dY + (size_t)p * g.outPlane() + (size_t)oh * g.outW;
+
+                            for (int ki = 0; ki < g.kernel; ++ki)
+                            {
+                                int ih = oh * g.stride + ki - g.padding;
+                                if (ih < 0 || ih >= g.height)
+                                    continue;
+
+                                for (int kj = 0; kj < g.kernel; ++kj)
+                                {
+                                    int owBegin, owEnd;
+                                    g.validRange(kj, g.width, g.outW, owBegin, owEnd);
+                                    float* dxRow = dxp + (size_t)ih * g.width + kj - g.padding;
+
+                                    for (int ow = owBegin; ow < owEnd; ++ow)
+                                        dxRow[ow * g.stride] += dyRow[ow] * scale;
+                                }
+                            }
+                        }
+                    }
+                });
+            }, { t_ptr });
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost((double)result -> getTotalSize() * kernel * kernel, (double)(t -> getTotalSize() + result -> getTotalSize()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<Tensor> adaptiveAvgPool2d(const std::shared_ptr<Tensor>& t, int outH, int outW)
+    {
+        ProfileScope scope("adaptiveAvgPool2d", "forward");
+
+        const auto& shape = t -> getShape();
+        if (shape.size() != 4)
+            throw std::invalid_argument("adaptiveAvgPool2d: expected an input [N, C, H, W]");
+        if (outH < 1 || outW < 1)
+            throw std::invalid_argument("adaptiveAvgPool2d: output size must be positive");
+
+        const int planes = shape[0] * shape[1], H = shape[2], W = shape[3];
+        auto result = std::make_shared<Tensor>(std::vector<int>{ shape[0], shape[1], outH, outW }, 0.0f, t -> requiresGradient);
+
+        const float* X = t -> getData().data();
+        float* Y = result -> getData().data();
+
+        parallelRange(planes, (double)t -> getTotalSize(), [&](int planeBegin, int planeEnd)
+        {
+            for (int p = planeBegin; p < planeEnd; ++p)
+            {
+                const float* xp = X + (size_t)p * H * W;
+                float* yp = Y + (size_t)p * outH * outW;
+
+                for (int oh = 0; oh < outH; ++oh)
+                {
+                    int hBegin, hEnd;
+                    adaptiveBin(oh, outH, H, hBegin, hEnd);
+
+                    for (int ow = 0; ow < outW; ++ow)
+                    {
+                        int wBegin, wEnd;
+                        adaptiveBin(ow, outW, W, wBegin, wEnd);
+
+                        float sum = 0.0f;
+                        for (int ih = hBegin; ih < hEnd; ++ih)
+                            sum += sumRange(xp + (size_t)ih * W + wBegin, wEnd - wBegin);
+
+                        yp[oh * outW + ow] = sum / ((hEnd - hBegin) * (wEnd - wBegin));
+                    }
+                }
+            }
+        });
+
+        applyAutocast(result);
+
+        if (t -> requiresGradient)
+        {
+            auto t_ptr = t;
+            auto result_ptr = result;
+            result -> setGradientFunction([t_ptr, result_ptr, planes, H, W, outH, outW, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("adaptiveAvgPool2d", "backward", layer);
+                scope.setCost((double)t_ptr -> getTotalSize(), 2.0 * t_ptr -> getTotalSize() * sizeof(float));
+
+                const float* dY = result_ptr -> gradient.data();
+                float* dX = t_ptr -> gradient.data();
+
+                parallelRange(planes, (double)t_ptr -> getTotalSize(), [&](int planeBegin, int planeEnd)
+                {
+                    for (int p = planeBegin; p < planeEnd; ++p)
+                    {
+                        float* dxp = dX + (size_t)p * H * W;
+                        const float* dyp = dY + (size_t)p * outH * outW;
+
+                        for (int oh = 0; oh < outH; ++oh)
+                        {
+                            int hBegin, hEnd;
+                            adaptiveBin(oh, outH, H, hBegin, hEnd);
+
+                            for (int ow = 0; ow < outW; ++ow)
+                            {
+                                int wBegin, wEnd;
+                                adaptiveBin(ow, outW, W, wBegin, wEnd);
+                                float share = dyp[oh * outW + ow] / ((hEnd - hBegin) * (wEnd - wBegin));
+
+                                for (int ih = hBegin; ih < hEnd; ++ih)
+                                    for (int iw = wBegin; iw < wEnd; ++iw)
+                                        dxp[(size_t)ih * W + iw] += share;
+                            }
+                        }
+                    }
+                });
+            }, { t_ptr });
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost((double)t -> getTotalSize(), (double)(t -> getTotalSize() + result -> getTotalSize()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<Tensor> globalAvgPool2d(const std::shared_ptr<Tensor>& t)
+    {
+        ProfileScope scope("globalAvgPool2d", "forward");
+
+        const auto& shape = t -> getShape();
+        if (shape.size() != 4)
+            throw std::invalid_argument("globalAvgPool2d: expected an input [N, C, H, W]");
+
+        const int planes = shape[0] * shape[1], plane = shape[2] * shape[3];
+        auto result = std::make_shared<Tensor>(std::vector<int>{ shape[0], shape[1] }, 0.0f, t -> requiresGradient);
+
+        const float* X = t -> getData().data();
+        float* Y = result -> getData().data();
+
+        parallelRange(planes, (double)t -> getTotalSize(), [&](int planeBegin, int planeEnd)
+        {
+            for (int p = planeBegin; p < planeEnd; ++p)
+                Y[p] = sumRange(X + (size_t)p * plane, plane) / plane;
+        });
+
+        applyAutocast(result);
+
+        if (t -> requiresGradient)
+        {
+            auto t_ptr = t;
+            auto result_ptr = result;
+            result -> setGradientFunction([t_ptr, result_ptr, planes, plane, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("globalAvgPool2d", "backward", layer);
+                scope.setCost((double)t_ptr -> getTotalSize(), 2.0 * t_ptr -> getTotalSize() * sizeof(float));
+
+                const float* dY = result_ptr -> gradient.data();
+                float* dX = t_ptr -> gradient.data();
+
+                parallelRange(planes, (double)t_ptr -> getTotalSize(), [&](int planeBegin, int planeEnd)
+                {
+                    for (int p = planeBegin; p < planeEnd; ++p)
+                    {
+                        float share = dY[p] / plane;
+                        float* dxp = dX + (size_t)p * plane;
+                        for (int i = 0; i < plane; ++i)
+                            dxp[i] += share;
+                    }
+                });
+            }, { t_ptr });
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost((double)t -> getTotalSize(), (double)(t -> getTotalSize() + result -> getTotalSize()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    #pragma endregion
+}
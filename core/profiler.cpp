@@ -0,0 +1,254 @@
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include "profiler.h"
+
+namespace SushiAI
+{
+    std::atomic<bool> Profiler::enabled{ false };
+
+    namespace
+    {
+        struct ThreadBuffer
+        {
+            std::mutex mutex;
+            std::vector<ProfileEvent> events;
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+            std::deque<std::string> layerLabels;
+            std::unordered_map<std::string, int> layerIds;
+            std::atomic<int> nextThreadId{ 0 };
+        };
+
+        Registry& registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        ThreadBuffer& localBuffer()
+        {
+            thread_local std::shared_ptr<ThreadBuffer> buffer = []()
+            {
+                auto b = std::make_shared<ThreadBuffer>();
+                std::lock_guard<std::mutex> lock(registry().mutex);
+                registry().buffers.push_back(b);
+                return b;
+            }();
+
+            return *buffer;
+        }
+
+        thread_local int currentLayerId = -1;
+
+        std::string escapeJson(const std::string& text)
+        {
+            std::string out;
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                    out += '\\';
+                out += c;
+            }
+            return out;
+        }
+
+        std::string shapeString(const std::vector<int>& shape)
+        {
+            std::string s = "[";
+            for (size_t i = 0; i < shape.size(); ++i)
+                s += std::to_string(shape[i]) + (i + 1 < shape.size() ? ", " : "");
+            return s + "]";
+        }
+    }
+
+    void Profiler::reset()
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        for (auto& b : reg.buffers)
+        {
+            std::lock_guard<std::mutex> bufferLock(b -> mutex);
+            b -> events.clear();
+        }
+    }
+
+    void Profiler::record(ProfileEvent&& event)
+    {
+        auto& buffer = localBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.events.push_back(std::move(event));
+    }
+
+    std::vector<ProfileEvent> Profiler::events()
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        std::vector<ProfileEvent> all;
+        for (auto& b : reg.buffers)
+        {
+            std::lock_guard<std::mutex> bufferLock(b -> mutex);
+            all.insert(all.end(), b -> events.begin(), b -> events.end());
+        }
+
+        std::sort(all.begin(), all.end(), [](const ProfileEvent& a, const ProfileEvent& b) { return a.startNs < b.startNs; });
+
+        return all;
+    }
+
+    int Profiler::internLayer(const std::string& label)
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        auto it = reg.layerIds.find(label);
+        if (it != reg.layerIds.end())
+            return it -> second;
+
+        int id = (int)reg.layerLabels.size();
+        reg.layerLabels.push_back(label);
+        reg.layerIds[label] = id;
+
+        return id;
+    }
+
+    const std::string& Profiler::layerLabel(int layer)
+    {
+        static const std::string none = "(no layer)";
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        if (layer < 0 || layer >= (int)reg.layerLabels.size())
+            return none;
+
+        return reg.layerLabels[layer];  // deque: references stay valid as labels are added
+    }
+
+    int Profiler::currentLayer()
+    {
+        return currentLayerId;
+    }
+
+    void Profiler::setCurrentLayer(int layer)
+    {
+        currentLayerId = layer;
+    }
+
+    int Profiler::threadId()
+    {
+        thread_local int id = registry().nextThreadId++;
+        return id;
+    }
+
+    void Profiler::printSummary()
+    {
+        struct Totals
+        {
+            int count = 0;
+            double ns = 0.0, flops = 0.0, bytes = 0.0;
+        };
+
+        auto all = events();
+        std::map<std::string, Totals> byOp;
+        std::map<int, Totals> layerForward, layerBackward;
+
+        for (auto& e : all)
+        {
+            if (std::string(e.category) == "layer")
+            {
+                auto& t = layerForward[e.layer];
+                t.count++;
+                t.ns += e.durationNs;
+                continue;
+            }
+
+            auto& op = byOp[std::string(e.name) + " (" + e.category + ")"];
+            op.count++;
+            op.ns += e.durationNs;
+            op.flops += e.flops;
+            op.bytes += e.bytes;
+
+            if (e.layer >= 0)
+            {
+                auto& t = (std::string(e.category) == "backward") ? layerBackward[e.layer] : layerForward[e.layer];
+                t.flops += e.flops;
+                t.bytes += e.bytes;
+                if (std::string(e.category) == "backward")
+                {
+                    t.count++;
+                    t.ns += e.durationNs;
+                }
+            }
+        }
+
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+        std::cout << std::fixed << std::setprecision(3);
+
+        std::cout << "=== Profile: by op ===\n";
+        std::cout << std::left << std::setw(28) << "op" << std::right << std::setw(8) << "calls" << std::setw(12) << "total ms"
+            << std::setw(12) << "GFLOP/s" << std::setw(10) << "GB/s" << "\n";
+        for (auto& [name, t] : byOp)
+        {
+            double seconds = t.ns * 1e-9;
+            std::cout << std::left << std::setw(28) << name << std::right << std::setw(8) << t.count << std::setw(12) << t.ns * 1e-6
+                << std::setw(12) << (seconds > 0 ? t.flops / seconds * 1e-9 : 0.0)
+                << std::setw(10) << (seconds > 0 ? t.bytes / seconds * 1e-9 : 0.0) << "\n";
+        }
+
+        std::cout << "=== Profile: by layer ===\n";
+        std::cout << std::left << std::setw(40) << "layer" << std::right << std::setw(12) << "fwd ms" << std::setw(12) << "bwd ms"
+            << std::setw(14) << "fwd MFLOP" << std::setw(14) << "bwd MFLOP" << "\n";
+        std::map<int, bool> layers;
+        for (auto& [id, t] : layerForward) layers[id] = true;
+        for (auto& [id, t] : layerBackward) layers[id] = true;
+        for (auto& [id, unused] : layers)
+        {
+            std::cout << std::left << std::setw(40) << layerLabel(id) << std::right
+                << std::setw(12) << layerForward[id].ns * 1e-6 << std::setw(12) << layerBackward[id].ns * 1e-6
+                << std::setw(14) << layerForward[id].flops * 1e-6 << std::setw(14) << layerBackward[id].flops * 1e-6 << "\n";
+        }
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    bool Profiler::writeChromeTrace(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+
+        auto all = events();
+        int64_t origin = all.empty() ? 0 : all.front().startNs;
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        for (size_t i = 0; i < all.size(); ++i)
+        {
+            const auto& e = all[i];
+            file << "{\"name\":\"" << escapeJson(e.name) << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\""
+                << ",\"ts\":" << std::fixed << std::setprecision(3) << (e.startNs - origin) / 1000.0
+                << ",\"dur\":" << e.durationNs / 1000.0
+                << ",\"pid\":1,\"tid\":" << e.threadId
+                << ",\"args\":{\"layer\":\"" << escapeJson(layerLabel(e.layer)) << "\""
+                << ",\"shape\":\"" << shapeString(e.shape) << "\""
+                << std::setprecision(0) << ",\"flops\":" << e.flops << ",\"bytes\":" << e.bytes << "}}"
+                << (i + 1 < all.size() ? ",\n" : "\n");
+        }
+        file << "]}\n";
+
+        return (bool)file;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace SushiAI
+{
+    struct ProfileEvent
+    {
+        const char* name;               // op name, or the layer label for "layer" events
+        const char* category;           // "forward", "backward", "layer", "step"
+        int threadId;
+        int layer;                      // interned layer label, -1 outside Sequential::forward
+        int64_t startNs;
+        int64_t durationNs;
+        std::vector<int> shape;         // output shape of forward ops
+        double flops;
+        double bytes;
+    };
+
+    /// Process-wide op profiler. Disabled by default; while disabled every ProfileScope costs a single
+    /// relaxed atomic load and a predictable branch. Events are buffered per thread.
+    class Profiler
+    {
+        public:
+            static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+            static void enable() { enabled.store(true, std::memory_order_relaxed); }
+            static void disable() { enabled.store(false, std::memory_order_relaxed); }
+            /// Drops all recorded events.
+            static void reset();
+
+            static void record(ProfileEvent&& event);
+            static std::vector<ProfileEvent> events();
+
+            /// Returns a stable id for a layer label such as "#1/[2] Linear" (owning model path, index, name).
+            static int internLayer(const std::string& label);
+            static const std::string& layerLabel(int layer);
+            /// Layer whose forward is running on this thread, -1 if none.
+            static int currentLayer();
+            static void setCurrentLayer(int layer);
+
+            static int threadId();
+            static int64_t nowNs()
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            /// Time, FLOPs and bytes aggregated per op (forward / backward) and per layer.
+            static void printSummary();
+            /// Writes the events in Chrome trace format (chrome://tracing, ui.perfetto.dev).
+            static bool writeChromeTrace(const std::string& path);
+
+        private:
+            static std::atomic<bool> enabled;
+    };
+
+    /// Makes `layer` the current layer of this thread for its lifetime and restores the previous one, also
+    /// when the layer's forward throws.
+    class CurrentLayerGuard
+    {
+        private:
+            int previous;
+
+        public:
+            explicit CurrentLayerGuard(int layer) : previous(Profiler::currentLayer()) { Profiler::setCurrentLayer(layer); }
+            ~CurrentLayerGuard() { Profiler::setCurrentLayer(previous); }
+
+            CurrentLayerGuard(const CurrentLayerGuard&) = delete;
+            CurrentLayerGuard& operator=(const CurrentLayerGuard&) = delete;
+    };
+
+    /// Times the enclosing block as one profiler event. Costs are only worth computing when active().
+    class ProfileScope
+    {
+        private:
+            bool isActive;
+            const char* name;
+            const char* category;
+            int layer;
+            int64_t start = 0;
+            std::vector<int> shape;
+            double flops = 0.0;
+            double bytes = 0.0;
+
+        public:
+            ProfileScope(const char* name, const char* category) : ProfileScope(name, category, -2) {}
+
+            /// layer = -2 uses the layer currently running on this thread.
+            ProfileScope(const char* name, const char* category, int layer) : isActive(Profiler::isEnabled()), name(name), category(category), layer(layer)
+            {
+                if (isActive)
+                {
+                    if (this -> layer == -2)
+                        this -> layer = Profiler::currentLayer();
+                    start = Profiler::nowNs();
+                }
+            }
+
+            ~ProfileScope()
+            {
+                if (isActive)
+                    Profiler::record({ name, category, Profiler::threadId(), layer, start, Profiler::nowNs() - start, std::move(shape), flops, bytes });
+            }
+
+            ProfileScope(const ProfileScope&) = delete;
+            ProfileScope& operator=(const ProfileScope&) = delete;
+
+            bool active() const { return isActive; }
+            /// Layer to hand to the matching backward scope (-2 when inactive).
+            int getLayer() const { return layer; }
+
+            void setShape(const std::vector<int>& s)
+            {
+                if (isActive)
+                    shape = s;
+            }
+
+            void setCost(double flopCount, double byteCount)
+            {
+                flops = flopCount;
+                bytes = byteCount;
+            }
+    };
+}
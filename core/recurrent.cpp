@@ -0,0 +1,384 @@
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "tensor.h"
+#include "ops.h"
+#include "opsdetail.h"
+#include "profiler.h"
+#include "backend.h"
+#include "vectormath.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using namespace simd;
+        using namespace detail;
+
+        /// Batch-first sequences [B, T, I] → hidden states [B, T, H] through `gates` stacked gate blocks of H columns.
+        /// Row (b, t) of every [B·T, ·] buffer sits at b·T + t, so the rows of one timestep are T rows apart and a
+        /// per-step GEMM reads and writes them in place with a leading dimension of T times the row width.
+        struct RecurrentGeometry
+        {
+            int batch, steps, input, hidden, gates;
+
+            int rows() const { return batch * steps; }
+            int width() const { return gates * hidden; }
+        };
+
+        RecurrentGeometry recurrentGeometry(const char* op, const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& inputWeights,
+            const std::shared_ptr<Tensor>& recurrentWeights, int gates)
+        {
+            const auto& shape = input -> getShape();
+            const auto& wx = inputWeights -> getShape();
+            const auto& wh = recurrentWeights -> getShape();
+
+            if (shape.size() != 3 || shape[1] < 1)
+                throw std::invalid_argument(std::string(op) + ": expected input [batch, steps, features]");
+            if (wh.size() != 2 || wh[1] != gates * wh[0])
+                throw std::invalid_argument(std::string(op) + ": recurrent weights must be [hidden, " + std::to_string(gates) + " * hidden]");
+            if (wx.size() != 2 || wx[0] != shape[2] || wx[1] != wh[1])
+                throw std::invalid_argument(std::string(op) + ": input weights must be [" + std::to_string(shape[2]) + ", " + std::to_string(wh[1]) + "]");
+
+            return { shape[0], shape[1], shape[2], wh[0], gates };
+        }
+
+        void checkBias(const char* op, const std::shared_ptr<Tensor>& bias, const RecurrentGeometry& g)
+        {
+            if (bias -> getTotalSize() != g.width())
+                throw std::invalid_argument(std::string(op) + ": bias must have " + std::to_string(g.width()) + " entries");
+        }
+
+        /// out[r] = bias for every row: the GEMMs then accumulate on top.
+        void broadcastRows(const float* bias, float* out, int rows, int width)
+        {
+            for (int r = 0; r < rows; ++r)
+                std::copy(bias, bias + width, out + (size_t)r * width);
+        }
+
+        /// Input projection of the whole sequence in one GEMM: out = X · Wx + b, [B·T, G·H].
+        void projectInputs(const RecurrentGeometry& g, const float* X, const float* Wx, const float* bias, float* out)
+        {
+            broadcastRows(bias, out, g.rows(), g.width());
+            backend().gemm(false, false, g.rows(), g.width(), g.input, X, g.input, Wx, g.width(), out, g.width());
+        }
+
+        /// Gradients of the input projection from the pre-activation gate gradients dG [B·T, G·H], each a single GEMM.
+        void projectInputsBackward(const RecurrentGeometry& g, const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& Wx,
+            const std::shared_ptr<Tensor>& bias, const float* dG)
+        {
+            const Backend& be = backend();
+
+            if (Wx -> requiresGradient)
+                be.gemm(true, false, g.input, g.width(), g.rows(), input -> getData().data(), g.input, dG, g.width(), Wx -> gradient.data(), g.width());
+            if (input -> requiresGradient)
+                be.gemm(false, true, g.rows(), g.input, g.width(), dG, g.width(), Wx -> getData().data(), g.width(), input -> gradient.data(), g.input);
+
+            if (bias -> requiresGradient)
+            {
+                float* db = bias -> gradient.data();
+                for (int r = 0; r < g.rows(); ++r)
+                    for (int j = 0; j < g.width(); ++j)
+                        db[j] += dG[(size_t)r * g.width() + j];
+            }
+        }
+
+        /// dWh += Σ_t h_{t-1}^T · dG_t, one GEMM per sequence pairing hidden state t - 1 with gate row t (h_{-1} = 0).
+        void recurrentWeightsBackward(const RecurrentGeometry& g, const float* Y, const float* dG, float* dWh)
+        {
+            if (g.steps < 2)
+                return;
+
+            for (int b = 0; b < g.batch; ++b)
+                backend().gemm(true, false, g.hidden, g.width(), g.steps - 1, Y + (size_t)b * g.steps * g.hidden, g.hidden,
+                    dG + ((size_t)b * g.steps + 1) * g.width(), g.width(), dWh, g.width());
+        }
+    }
+
+    #pragma region Recurrent
+
+    std::shared_ptr<Tensor> lstm(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& inputWeights,
+        const std::shared_ptr<Tensor>& recurrentWeights, const std::shared_ptr<Tensor>& bias)
+    {
+        ProfileScope scope("lstm", "forward");
+
+        const RecurrentGeometry g = recurrentGeometry("lstm", input, inputWeights, recurrentWeights, 4);
+        checkBias("lstm", bias, g);
+
+        const int B = g.batch, T = g.steps, H = g.hidden, G = g.width();
+        const Backend& be = backend();
+
+        bool requiresGrad = input -> requiresGradient || inputWeights -> requiresGradient || recurrentWeights -> requiresGradient || bias -> requiresGradient;
+        auto result = std::make_shared<Tensor>(std::vector<int>{ B, T, H }, 0.0f, requiresGrad);
+
+        // Workspaces kept for backward: activated gates [i, f, g, o] and cell states of every step
+        auto gates = std::make_shared<std::vector<float>>((size_t)g.rows() * G);
+        auto cells = std::make_shared<std::vector<float>>((size_t)g.rows() * H);
+
+        projectInputs(g, input -> getData().data(), inputWeights -> getData().data(), bias -> getData().data(), gates -> data());
+
+        const float* Wh = recurrentWeights -> getData().data();
+        float* Y = result -> getData().data();
+        std::vector<float> tanhCell(H);
+
+        for (int t = 0; t < T; ++t)
+        {
+            // gates_t += h_{t-1} · Wh for all sequences at once
+            if (t > 0)
+                be.gemm(false, false, B, G, H, Y + (size_t)(t - 1) * H, T * H, Wh, G, gates -> data() + (size_t)t * G, T * G);
+
+            for (int b = 0; b < B; ++b)
+            {
+                const size_t row = (size_t)b * T + t;
+                float* gt = gates -> data() + row * G;
+                float* c = cells -> data() + row * H;
+                float* h = Y + row * H;
+
+                mapUnary(gt, gt, 2 * H, [](vf x) { return vsigmoid(x); });
+                mapUnary(gt + 2 * H, gt + 2 * H, H, [](vf x) { return vtanh(x); });
+                mapUnary(gt + 3 * H, gt + 3 * H, H, [](vf x) { return vsigmoid(x); });
+
+                const float* i = gt;
+                const float* f = gt + H;
+                const float* cand = gt + 2 * H;
+                const float* o = gt + 3 * H;
+
+                if (t > 0)
+                    for (int j = 0; j < H; ++j)
+                        c[j] = f[j] * c[j - H] + i[j] * cand[j];
+                else
+                    for (int j = 0; j < H; ++j)
+                        c[j] = i[j] * cand[j];
+
+                mapUnary(c, tanhCell.data(), H, [](vf x) { return vtanh(x); });
+                for (int j = 0; j < H; ++j)
+                    h[j] = o[j] * tanhCell[j];
+            }
+        }
+
+        applyAutocast(result);
+
+        double flops = 2.0 * g.rows() * G * (g.input + H);
+
+        if (requiresGrad)
+        {
+            auto input_ptr = input, wx_ptr = inputWeights, wh_ptr = recurrentWeights, bias_ptr = bias;
+            auto result_ptr = result;
+
+            // Backward through time as one node: per-step work is elementwise plus dh_{t-1} = dG_t · Wh^T, and
+            // every weight gradient is accumulated afterwards from the full dG buffer.
+            result -> setGradientFunction([input_ptr, wx_ptr, wh_ptr, bias_ptr, result_ptr, gates, cells, g, flops, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("lstm", "backward", layer);
+                scope.setCost(2.0 * flops, (double)(2 * gates -> size() + 3 * cells -> size()) * sizeof(float));
+
+                const int B = g.batch, T = g.steps, H = g.hidden, G = g.width();
+                const Backend& be = backend();
+
+                const float* Wh = wh_ptr -> getData().data();
+                const float* Y = result_ptr -> getData().data();
+                const float* dY = result_ptr -> gradient.data();
+
+                std::vector<float> dG((size_t)g.rows() * G), dh((size_t)B * H, 0.0f), dc((size_t)B * H, 0.0f), tanhCell(H);
+
+                for (int t = T - 1; t >= 0; --t)
+                {
+                    for (int b = 0; b < B; ++b)
+                    {
+                        const size_t row = (size_t)b * T + t;
+                        const float* gt = gates -> data() + row * G;
+                        const float* c = cells -> data() + row * H;
+                        const float* dy = dY + row * H;
+                        float* dg = dG.data() + row * G;
+                        float* dhb = dh.data() + (size_t)b * H;
+                        float* dcb = dc.data() + (size_t)b * H;
+
+                        mapUnary(c, tanhCell.data(), H, [](vf x) { return vtanh(x); });
+
+                        for (int j = 0; j < H; ++j)
+                        {
+                            float i = gt[j], f = gt[H + j], cand = gt[2 * H + j], o = gt[3 * H + j], tc = tanhCell[j];
+                            float dhj = dhb[j] + dy[j];
+                            float dcj = dcb[j] + dhj * o * (1.0f - tc * tc);
+                            float cPrev = t > 0 ? c[j - H] : 0.0f;
+
+                            dg[j] = dcj * cand * i * (1.0f - i);
+                            dg[H + j] = dcj * cPrev * f * (1.0f - f);
+                            dg[2 * H + j] = dcj * i * (1.0f - cand * cand);
+                            dg[3 * H + j] = dhj * tc * o * (1.0f - o);
+                            dcb[j] = dcj * f;
+                        }
+                    }
+
+                    // dh_{t-1} = dG_t · Wh^T
+                    if (t > 0)
+                    {
+                        std::fill(dh.begin(), dh.end(), 0.0f);
+                        be.gemm(false, true, B, H, G, dG.data() + (size_t)t * G, T * G, Wh, G, dh.data(), H);
+                    }
+                }
+
+                if (wh_ptr -> requiresGradient)
+                    recurrentWeightsBackward(g, Y, dG.data(), wh_ptr -> gradient.data());
+
+                projectInputsBackward(g, input_ptr, wx_ptr, bias_ptr, dG.data());
+            }, { input_ptr, wx_ptr, wh_ptr, bias_ptr });
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(flops, (double)(input -> getTotalSize() + inputWeights -> getTotalSize() + recurrentWeights -> getTotalSize() + gates -> size() + 2 * cells -> size()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<Tensor> gru(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& inputWeights,
+        const std::shared_ptr<Tensor>& recurrentWeights, const std::shared_ptr<Tensor>& inputBias, const std::shared_ptr<Tensor>& recurrentBias)
+    {
+        ProfileScope scope("gru", "forward");
+
+        const RecurrentGeometry g = recurrentGeometry("gru", input, inputWeights, recurrentWeights, 3);
+        checkBias("gru", inputBias, g);
+        checkBias("gru", recurrentBias, g);
+
+        const int B = g.batch, T = g.steps, H = g.hidden, G = g.width();
+        const Backend& be = backend();
+
+        bool requiresGrad = input -> requiresGradient || inputWeights -> requiresGradient || recurrentWeights -> requiresGradient
+            || inputBias -> requiresGradient || recurrentBias -> requiresGradient;
+        auto result = std::make_shared<Tensor>(std::vector<int>{ B, T, H }, 0.0f, requiresGrad);
+
+        // Workspaces kept for backward: activated gates [r, z, n] and the recurrent projections h_{t-1} · Wh + bh,
+        // whose candidate block is needed again because r gates it.
+        auto gates = std::make_shared<std::vector<float>>((size_t)g.rows() * G);
+        auto recurrent = std::make_shared<std::vector<float>>((size_t)g.rows() * G);
+
+        projectInputs(g, input -> getData().data(), inputWeights -> getData().data(), inputBias -> getData().data(), gates -> data());
+        broadcastRows(recurrentBias -> getData().data(), recurrent -> data(), g.rows(), G);
+
+        const float* Wh = recurrentWeights -> getData().data();
+        float* Y = result -> getData().data();
+
+        for (int t = 0; t < T; ++t)
+        {
+            if (t > 0)
+                be.gemm(false, false, B, G, H, Y + (size_t)(t - 1) * H, T * H, Wh, G, recurrent -> data() + (size_t)t * G, T * G);
+
+            for (int b = 0; b < B; ++b)
+            {
+                const size_t row = (size_t)b * T + t;
+                float* gt = gates -> data() + row * G;
+                const float* ht = recurrent -> data() + row * G;
+                float* h = Y + row * H;
+
+                for (int j = 0; j < 2 * H; ++j)
+                    gt[j] += ht[j];
+                mapUnary(gt, gt, 2 * H, [](vf x) { return vsigmoid(x); });
+
+                const float* r = gt;
+                const float* z = gt + H;
+                float* n = gt + 2 * H;
+
+                for (int j = 0; j < H; ++j)
+                    n[j] += r[j] * ht[2 * H + j];
+                mapUnary(n, n, H, [](vf x) { return vtanh(x); });
+
+                if (t > 0)
+                    for (int j = 0; j < H; ++j)
+                        h[j] = n[j] + z[j] * (h[j - H] - n[j]);
+                else
+                    for (int j = 0; j < H; ++j)
+                        h[j] = (1.0f - z[j]) * n[j];
+            }
+        }
+
+        applyAutocast(result);
+
+        double flops = 2.0 * g.rows() * G * (g.input + H);
+
+        if (requiresGrad)
+        {
+            auto input_ptr = input, wx_ptr = inputWeights, wh_ptr = recurrentWeights, bx_ptr = inputBias, bh_ptr = recurrentBias;
+            auto result_ptr = result;
+
+            result -> setGradientFunction([input_ptr, wx_ptr, wh_ptr, bx_ptr, bh_ptr, result_ptr, gates, recurrent, g, flops, layer = scope.getLayer()]()
+            {
+                ProfileScope scope("gru", "backward", layer);
+                scope.setCost(2.0 * flops, (double)(4 * gates -> size()) * sizeof(float));
+
+                const int B = g.batch, T = g.steps, H = g.hidden, G = g.width();
+                const Backend& be = backend();
+
+                const float* Wh = wh_ptr -> getData().data();
+                const float* Y = result_ptr -> getData().data();
+                const float* dY = result_ptr -> gradient.data();
+
+                // Pre-activation gradients of the input and recurrent projections; they differ only in the candidate block
+                std::vector<float> dGx((size_t)g.rows() * G), dGh((size_t)g.rows() * G), dh((size_t)B * H, 0.0f);
+
+                for (int t = T - 1; t >= 0; --t)
+                {
+                    for (int b = 0; b < B; ++b)
+                    {
+                        const size_t row = (size_t)b * T + t;
+                        const float* gt = gates -> data() + row * G;
+                        const float* ht = recurrent -> data() + row * G;
+                        const float* hPrev = t > 0 ? Y + (row - 1) * H : nullptr;
+                        const float* dy = dY + row * H;
+                        float* dgx = dGx.data() + row * G;
+                        float* dgh = dGh.data() + row * G;
+                        float* dhb = dh.data() + (size_t)b * H;
+
+                        for (int j = 0; j < H; ++j)
+                        {
+                            float r = gt[j], z = gt[H + j], n = gt[2 * H + j];
+                            float previous = t > 0 ? hPrev[j] : 0.0f;
+                            float dhj = dhb[j] + dy[j];
+
+                            float dn = dhj * (1.0f - z) * (1.0f - n * n);
+                            float dr = dn * ht[2 * H + j] * r * (1.0f - r);
+                            float dz = dhj * (previous - n) * z * (1.0f - z);
+
+                            dgx[j] = dgh[j] = dr;
+                            dgx[H + j] = dgh[H + j] = dz;
+                            dgx[2 * H + j] = dn;
+                            dgh[2 * H + j] = dn * r;
+                            dhb[j] = dhj * z;
+                        }
+                    }
+
+                    // dh_{t-1} = dh_t ∘ z + dGh_t · Wh^T
+                    if (t > 0)
+                        be.gemm(false, true, B, H, G, dGh.data() + (size_t)t * G, T * G, Wh, G, dh.data(), H);
+                }
+
+                if (wh_ptr -> requiresGradient)
+                    recurrentWeightsBackward(g, Y, dGh.data(), wh_ptr -> gradient.data());
+
+                if (bh_ptr -> requiresGradient)
+                {
+                    float* db = bh_ptr -> gradient.data();
+                    for (int r = 0; r < g.rows(); ++r)
+                        for (int j = 0; j < G; ++j)
+                            db[j] += dGh[(size_t)r * G + j];
+                }
+
+                projectInputsBackward(g, input_ptr, wx_ptr, bx_ptr, dGx.data());
+            }, { input_ptr, wx_ptr, wh_ptr, bx_ptr, bh_ptr });
+        }
+
+        if (scope.active())
+        {
+            scope.setShape(result -> getShape());
+            scope.setCost(flops, (double)(input -> getTotalSize() + inputWeights -> getTotalSize() + recurrentWeights -> getTotalSize() + 2 * gates -> size()) * sizeof(float));
+        }
+
+        return result;
+    }
+
+    #pragma endregion
+}
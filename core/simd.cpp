@@ -0,0 +1,406 @@
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include "backend.h"
+#include "simd.h"
+#include "gemmtuner.h"
+#include "vectormath.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using namespace simd;
+
+        #pragma region Micro-tile
+
+        // GEMM micro-tile: 6 rows × 2 registers keeps 12 accumulators in the 16 vector registers (AVX2 / SSE2).
+        #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+        constexpr int MR = 6;
+        #else
+        constexpr int MR = 4;
+        #endif
+
+        #if defined(__GNUC__)
+        #define SUSHIAI_UNROLL _Pragma("GCC unroll 8")
+        #else
+        #define SUSHIAI_UNROLL
+        #endif
+
+        /// Columns of a GEMM micro-tile: two registers wide.
+        constexpr int NR = 2 * Lanes;
+
+        #pragma endregion
+
+        #pragma region GEMM
+
+        // Goto-style blocking: a kc × nc panel of op(B) and an mc × kc panel of op(A) are packed into
+        // micro-panels (NR columns / MR rows, k-major, zero padded) and multiplied MR × NR tiles at a time.
+        // The panel sizes come from a GemmConfig (defaultGemmConfig() or the tuner).
+
+        struct Operand
+        {
+            const float* data;
+            int ld;
+            bool trans;
+
+            float at(int row, int col) const { return trans ? data[(size_t)col * ld + row] : data[(size_t)row * ld + col]; }
+        };
+
+        void packA(const Operand& A, int i0, int l0, int mc, int kc, float* dst)
+        {
+            for (int ir = 0; ir < mc; ir += MR)
+            {
+                int rows = std::min(MR, mc - ir);
+                for (int p = 0; p < kc; ++p)
+                {
+                    for (int r = 0; r < rows; ++r)
+                        dst[r] = A.at(i0 + ir + r, l0 + p);
+                    for (int r = rows; r < MR; ++r)
+                        dst[r] = 0.0f;
+                    dst += MR;
+                }
+            }
+        }
+
+        void packB(const Operand& B, int l0, int j0, int kc, int nc, float* dst)
+        {
+            for (int jr = 0; jr < nc; jr += NR)
+            {
+                int cols = std::min(NR, nc - jr);
+                for (int p = 0; p < kc; ++p)
+                {
+                    if (!B.trans && cols == NR)
+                        std::memcpy(dst, B.data + (size_t)(l0 + p) * B.ld + j0 + jr, NR * sizeof(float));
+                    else
+                    {
+                        for (int c = 0; c < cols; ++c)
+                            dst[c] = B.at(l0 + p, j0 + jr + c);
+                        for (int c = cols; c < NR; ++c)
+                            dst[c] = 0.0f;
+                    }
+                    dst += NR;
+                }
+            }
+        }
+
+        /// C[rows, cols] += Ap · Bp for one MR × NR tile (rows ≤ MR, cols ≤ NR).
+        void microKernel(int kc, const float* Ap, const float* Bp, float* C, int ldc, int rows, int cols)
+        {
+            // Fully unrolled so the accumulators stay in registers.
+            vf acc[MR][2];
+            SUSHIAI_UNROLL
+            for (int r = 0; r < MR; ++r)
+                acc[r][0] = acc[r][1] = vzero();
+
+            for (int p = 0; p < kc; ++p)
+            {
+                vf b0 = vload(Bp), b1 = vload(Bp + Lanes);
+                SUSHIAI_UNROLL
+                for (int r = 0; r < MR; ++r)
+                {
+                    vf a = vset(Ap[r]);
+                    acc[r][0] = vfma(a, b0, acc[r][0]);
+                    acc[r][1] = vfma(a, b1, acc[r][1]);
+                }
+                Ap += MR;
+                Bp += NR;
+            }
+
+            if (rows == MR && cols == NR)
+            {
+                SUSHIAI_UNROLL
+                for (int r = 0; r < MR; ++r)
+                {
+                    float* c = C + (size_t)r * ldc;
+                    vstore(c, vadd(vload(c), acc[r][0]));
+                    vstore(c + Lanes, vadd(vload(c + Lanes), acc[r][1]));
+                }
+                return;
+            }
+
+            float tile[MR * NR];
+            SUSHIAI_UNROLL
+            for (int r = 0; r < MR; ++r)
+            {
+                vstore(tile + r * NR, acc[r][0]);
+                vstore(tile + r * NR + Lanes, acc[r][1]);
+            }
+            for (int r = 0; r < rows; ++r)
+                for (int c = 0; c < cols; ++c)
+                    C[(size_t)r * ldc + c] += tile[r * NR + c];
+        }
+
+        void packedGemm(const GemmConfig& config, const Operand& A, const Operand& B, int m, int n, int k, float* C, int ldc)
+        {
+            const int MC = std::max(MR, config.mc), KC = std::max(1, config.kc), NC = std::max(NR, config.nc);
+
+            // Per-thread scratch, only ever grown: steady-state GEMMs don't allocate.
+            thread_local std::vector<float> packedA, packedB;
+            if (packedA.size() < (size_t)(MC + MR) * KC)
+                packedA.resize((size_t)(MC + MR) * KC);
+            if (packedB.size() < (size_t)(NC + NR) * KC)
+                packedB.resize((size_t)(NC + NR) * KC);
+
+            for (int jc = 0; jc < n; jc += NC)
+            {
+                int nc = std::min(NC, n - jc);
+                for (int pc = 0; pc < k; pc += KC)
+                {
+                    int kc = std::min(KC, k - pc);
+                    packB(B, pc, jc, kc, nc, packedB.data());
+
+                    for (int ic = 0; ic < m; ic += MC)
+                    {
+                        int mc = std::min(MC, m - ic);
+                        packA(A, ic, pc, mc, kc, packedA.data());
+
+                        for (int jr = 0; jr < nc; jr += NR)
+                            for (int ir = 0; ir < mc; ir += MR)
+                                microKernel(kc, packedA.data() + (size_t)ir * kc, packedB.data() + (size_t)jr * kc,
+                                    C + (size_t)(ic + ir) * ldc + jc + jr, ldc, std::min(MR, mc - ir), std::min(NR, nc - jr));
+                    }
+                }
+            }
+        }
+
+        /// Unpacked kernels for shapes too small or too skinny to amortize packing.
+        void directGemm(const Operand& A, const Operand& B, int m, int n, int k, float* C, int ldc)
+        {
+            if (!B.trans)
+            {
+                // Rows of C accumulate scaled rows of B (contiguous, vectorized over n).
+                for (int i = 0; i < m; ++i)
+                {
+                    float* c = C + (size_t)i * ldc;
+                    for (int l = 0; l < k; ++l)
+                    {
+                        vf a = vset(A.at(i, l));
+                        const float* b = B.data + (size_t)l * B.ld;
+                        int j = 0;
+                        for (; j + Lanes <= n; j += Lanes)
+                            vstore(c + j, vfma(a, vload(b + j), vload(c + j)));
+                        for (; j < n; ++j)
+                            c[j] += A.at(i, l) * b[j];
+                    }
+                }
+                return;
+            }
+
+            // op(B) = B^T: every C element is a dot product of a row of op(A) and a row of B.
+            for (int i = 0; i < m; ++i)
+                for (int j = 0; j < n; ++j)
+                {
+                    const float* b = B.data + (size_t)j * B.ld;
+                    float sum;
+                    if (!A.trans)
+                    {
+                        const float* a = A.data + (size_t)i * A.ld;
+                        vf acc = vzero();
+                        int l = 0;
+                        for (; l + Lanes <= k; l += Lanes)
+                            acc = vfma(vload(a + l), vload(b + l), acc);
+                        sum = vsum(acc);
+                        for (; l < k; ++l)
+                            sum += a[l] * b[l];
+                    }
+                    else
+                    {
+                        sum = 0.0f;
+                        for (int l = 0; l < k; ++l)
+                            sum += A.at(i, l) * b[l];
+                    }
+                    C[(size_t)i * ldc + j] += sum;
+                }
+        }
+
+        void simdGemm(bool transA, bool transB, int m, int n, int k, const float* A, int lda, const float* B, int ldb, float* C, int ldc)
+        {
+            if (m <= 0 || n <= 0 || k <= 0)
+                return;
+
+            GemmConfig config = GemmTuner::isEnabled() ? GemmTuner::select(transA, transB, m, n, k) : defaultGemmConfig(transA, transB, m, n, k);
+            simdGemmWith(config, transA, transB, m, n, k, A, lda, B, ldb, C, ldc);
+        }
+
+        void simdGemmBatched(bool transA, bool transB, int m, int n, int k, const float* A, size_t strideA,
+            const float* B, size_t strideB, float* C, size_t strideC, int batch)
+        {
+            int lda = transA ? m : k, ldb = transB ? k : n;
+            for (int i = 0; i < batch; ++i)
+                simdGemm(transA, transB, m, n, k, A + i * strideA, lda, B + i * strideB, ldb, C + i * strideC, n);
+        }
+
+        #pragma endregion
+
+        #pragma region Elementwise Kernels
+
+        void simdAdd(const float* a, const float* b, float* y, size_t n)
+        {
+            size_t i = 0;
+            for (; i + Lanes <= n; i += Lanes)
+                vstore(y + i, vadd(vload(a + i), vload(b + i)));
+            for (; i < n; ++i)
+                y[i] = a[i] + b[i];
+        }
+
+        void simdAddRow(const float* a, const float* row, float* y, int rows, int cols)
+        {
+            for (int r = 0; r < rows; ++r)
+                simdAdd(a + (size_t)r * cols, row, y + (size_t)r * cols, cols);
+        }
+
+        void simdAccumulate(const float* x, float* y, size_t n)
+        {
+            simdAdd(y, x, y, n);
+        }
+
+        void simdAccumulateRows(const float* x, float* y, int rows, int cols)
+        {
+            for (int r = 0; r < rows; ++r)
+                simdAdd(y, x + (size_t)r * cols, y, cols);
+        }
+
+        void simdRelu(const float* x, float* y, size_t n)
+        {
+            mapUnary(x, y, n, [](vf v) { return vmax(v, vzero()); });
+        }
+
+        void simdReluBackward(const float* y, const float* dy, float* dx, size_t n)
+        {
+            #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+            mapBackward(y, dy, dx, n, [](vf out, vf g) { return vand(vgreater(out, vzero()), g); });
+            #else
+            for (size_t i = 0; i < n; ++i)
+                dx[i] += (y[i] > 0 ? 1.0f : 0.0f) * dy[i];
+            #endif
+        }
+
+        void simdLeakyRelu(const float* x, float* y, size_t n, float alpha)
+        {
+            #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+            vf a = vset(alpha);
+            mapUnary(x, y, n, [a](vf v) { return vselect(vgreater(v, vzero()), v, vmul(a, v)); });
+            #else
+            for (size_t i = 0; i < n; ++i)
+                y[i] = (x[i] > 0.0f ? x[i] : alpha * x[i]);
+            #endif
+        }
+
+        void simdLeakyReluBackward(const float* x, const float* dy, float* dx, size_t n, float alpha)
+        {
+            #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+            vf a = vset(alpha), one = vset(1.0f);
+            mapBackward(x, dy, dx, n, [a, one](vf in, vf g) { return vmul(vselect(vgreater(in, vzero()), one, a), g); });
+            #else
+            for (size_t i = 0; i < n; ++i)
+                dx[i] += (x[i] > 0.0f ? 1.0f : alpha) * dy[i];
+            #endif
+        }
+
+        void simdSigmoid(const float* x, float* y, size_t n)
+        {
+            mapUnary(x, y, n, [](vf v) { return vsigmoid(v); });
+        }
+
+        void simdSigmoidBackward(const float* y, const float* dy, float* dx, size_t n)
+        {
+            mapBackward(y, dy, dx, n, [](vf out, vf g) { return vmul(vmul(out, vsub(vset(1.0f), out)), g); });
+        }
+
+        void simdTanh(const float* x, float* y, size_t n)
+        {
+            mapUnary(x, y, n, [](vf v) { return vtanh(v); });
+        }
+
+        void simdTanhBackward(const float* y, const float* dy, float* dx, size_t n)
+        {
+            mapBackward(y, dy, dx, n, [](vf out, vf g) { return vmul(vsub(vset(1.0f), vmul(out, out)), g); });
+        }
+
+        void simdSoftmax(const float* x, float* y, size_t n)
+        {
+            if (n == 0)
+                return;
+
+            size_t i = 0;
+            float maxV = x[0];
+            if (n >= (size_t)Lanes)
+            {
+                vf m = vload(x);
+                for (i = Lanes; i + Lanes <= n; i += Lanes)
+                    m = vmax(m, vload(x + i));
+                maxV = vmaxAcross(m);
+            }
+            for (; i < n; ++i)
+                maxV = std::max(maxV, x[i]);
+
+            vf shift = vset(maxV);
+            mapUnary(x, y, n, [shift](vf v) { return vexp(vsub(v, shift)); });
+
+            vf acc = vzero();
+            for (i = 0; i + Lanes <= n; i += Lanes)
+                acc = vadd(acc, vload(y + i));
+            float sumExp = vsum(acc);
+            for (; i < n; ++i)
+                sumExp += y[i];
+
+            vf scale = vset(1.0f / sumExp);
+            mapUnary(y, y, n, [scale](vf v) { return vmul(v, scale); });
+        }
+
+        #pragma endregion
+    }
+
+    GemmConfig defaultGemmConfig([[maybe_unused]] bool transA, [[maybe_unused]] bool transB, int m, int n, int k)
+    {
+        GemmConfig config;
+
+        // Packing costs O(mk + kn); it pays off once every packed value is reused across enough of the tile.
+        bool tiny = (double)m * n * k < 32.0 * 32 * 32;
+        bool skinny = n < NR || m < MR;
+        if (tiny || skinny)
+            config.kernel = GemmKernel::Direct;
+
+        return config;
+    }
+
+    void simdGemmWith(const GemmConfig& config, bool transA, bool transB, int m, int n, int k,
+        const float* A, int lda, const float* B, int ldb, float* C, int ldc)
+    {
+        if (m <= 0 || n <= 0 || k <= 0)
+            return;
+
+        Operand a{ A, lda, transA }, b{ B, ldb, transB };
+
+        // A contiguous [k, 1] column is also a [1, k] row: matrix-vector products become row dot products.
+        if (n == 1 && !transB && ldb == 1)
+            b = { B, k, true };
+
+        if (config.kernel == GemmKernel::Direct)
+            directGemm(a, b, m, n, k, C, ldc);
+        else
+            packedGemm(config, a, b, m, n, k, C, ldc);
+    }
+
+    const char* simdIsa()
+    {
+        return Isa;
+    }
+
+    const Backend& simdBackend()
+    {
+        static const Backend instance =
+        {
+            BackendKind::Simd, HasVectors ? "simd" : "simd (scalar build)",
+            simdGemm, simdGemmBatched,
+            simdAdd, simdAddRow, simdAccumulate, simdAccumulateRows,
+            simdRelu, simdReluBackward, simdLeakyRelu, simdLeakyReluBackward,
+            simdSigmoid, simdSigmoidBackward, simdTanh, simdTanhBackward,
+            simdSoftmax
+        };
+
+        return instance;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace SushiAI
+{
+    enum class GemmKernel
+    {
+        Direct,     // unpacked loops, no setup cost: tiny and skinny shapes
+        Packed      // packed panels and a register-blocked micro-kernel
+    };
+
+    /// Kernel and cache blocking of one SIMD GEMM. The packed kernel works on mc × kc panels of op(A)
+    /// and kc × nc panels of op(B); Direct ignores the tile sizes.
+    struct GemmConfig
+    {
+        GemmKernel kernel = GemmKernel::Packed;
+        int mc = 96;
+        int kc = 256;
+        int nc = 2048;
+    };
+
+    /// Built-in choice for shapes the tuner has not seen (or when it is disabled).
+    GemmConfig defaultGemmConfig(bool transA, bool transB, int m, int n, int k);
+    /// The SIMD backend's gemm with an explicit configuration. Same contract as Backend::gemm.
+    void simdGemmWith(const GemmConfig& config, bool transA, bool transB, int m, int n, int k,
+        const float* A, int lda, const float* B, int ldb, float* C, int ldc);
+    /// Instruction set the SIMD kernels were compiled for: "avx2", "sse2" or "scalar".
+    const char* simdIsa();
+}
@@ -5,6 +5,8 @@
 #include <functional>
 #include <unordered_set>
 #include "tensor.h"
+#include "profiler.h"
+#include "memorytracker.h"
 
 namespace SushiAI
 {
@@ -19,6 +21,18 @@ namespace SushiAI
         gradient.resize(totalSize, 0.0f);
 
         calculateStrides();
+
+        if (MemoryTracker::isEnabled())
+        {
+            memoryTracked = true;
+            MemoryTracker::onAllocate(this);
+        }
+    }
+
+    Tensor::~Tensor()
+    {
+        if (memoryTracked)
+            MemoryTracker::onRelease(this);
     }
 
     std::shared_ptr<Tensor> Tensor::Zeros(const std::vector<int>& shape, bool requiresGrad)
@@ -82,6 +96,34 @@ namespace SushiAI
         calculateStrides();
     }
     
+    void Tensor::toDType(DType newDType)
+    {
+        roundToDType(newDType, data.data(), data.size());
+        dtype = newDType;
+    }
+
+    void Tensor::useSparseGradient(bool sparse)
+    {
+        assert(!sparse || shape.size() == 2);
+
+        gradientIsSparse = sparse;
+        sparseGradient.clear();
+        sparseGradient.cols = sparse ? shape[1] : 0;
+
+        if (sparse)
+            std::vector<float>().swap(gradient);
+        else
+            gradient.assign(totalSize, 0.0f);
+    }
+
+    std::vector<uint16_t> Tensor::packData() const
+    {
+        std::vector<uint16_t> packed(data.size());
+        packReduced(dtype, data.data(), packed.data(), data.size());
+
+        return packed;
+    }
+
     void Tensor::print(const std::string& name) const
     {
         std::cout << "====== Tensor Debug ======\n";
@@ -163,6 +205,81 @@ namespace SushiAI
 
     #pragma endregion
 
+    #pragma region Sparse Gradients
+
+    void SparseGradient::coalesce()
+    {
+        if (indices.size() < 2)
+            return;
+
+        std::vector<size_t> order(indices.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return indices[a] < indices[b]; });
+
+        std::vector<int> mergedIndices;
+        std::vector<float> mergedValues;
+        mergedIndices.reserve(indices.size());
+        mergedValues.reserve(values.size());
+
+        for (size_t r : order)
+        {
+            const float* row = values.data() + r * cols;
+
+            if (!mergedIndices.empty() && mergedIndices.back() == indices[r])
+            {
+                float* target = mergedValues.data() + mergedValues.size() - cols;
+                for (int j = 0; j < cols; ++j)
+                    target[j] += row[j];
+            }
+            else
+            {
+                mergedIndices.push_back(indices[r]);
+                mergedValues.insert(mergedValues.end(), row, row + cols);
+            }
+        }
+
+        indices = std::move(mergedIndices);
+        values = std::move(mergedValues);
+    }
+
+    void SparseGradient::addTo(std::vector<float>& dense) const
+    {
+        for (size_t r = 0; r < indices.size(); ++r)
+        {
+            float* target = dense.data() + (size_t)indices[r] * cols;
+            const float* row = values.data() + r * cols;
+
+            for (int j = 0; j < cols; ++j)
+                target[j] += row[j];
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region Gradient Mode
+
+    namespace
+    {
+        thread_local bool recordGraph = true;
+    }
+
+    bool gradientsEnabled()
+    {
+        return recordGraph;
+    }
+
+    NoGradGuard::NoGradGuard() : previous(recordGraph)
+    {
+        recordGraph = false;
+    }
+
+    NoGradGuard::~NoGradGuard()
+    {
+        recordGraph = previous;
+    }
+
+    #pragma endregion
+
     #pragma region Computation Graph
 
     std::vector<Tensor*> Tensor::topologicalSort() const
@@ -202,12 +319,67 @@ namespace SushiAI
     // Gerçek propagation logic’i buraya:
     void Tensor::backward(const std::vector<float>& seed, bool retainGraph, bool clearExisting)
     {
+        propagate(seed, retainGraph, clearExisting, nullptr);
+    }
+
+    void Tensor::backwardTo(const std::vector<std::shared_ptr<Tensor>>& inputs, bool retainGraph, bool clearExisting)
+    {
+        std::vector<float> seed(totalSize, 0.0f);
+        seed[0] = 1.0f;
+
+        propagate(seed, retainGraph, clearExisting, &inputs);
+    }
+
+    void Tensor::backwardTo(const std::vector<float>& seed, const std::vector<std::shared_ptr<Tensor>>& inputs, bool retainGraph, bool clearExisting)
+    {
+        propagate(seed, retainGraph, clearExisting, &inputs);
+    }
+
+    void Tensor::propagate(const std::vector<float>& seed, bool retainGraph, bool clearExisting, const std::vector<std::shared_ptr<Tensor>>* inputs)
+    {
+        ProfileScope scope("backward", "step", -1);
+
         auto topo = topologicalSort();
 
+        // 2.0) Which nodes lead to a leaf that wants a gradient: leaves keep their flag (narrowed to the
+        //      requested inputs, restored afterwards), inner nodes inherit it from their parents. Ops read the
+        //      parents' flags to skip the operand gradients (whole GEMMs) nobody needs.
+        std::vector<std::pair<Tensor*, bool>> narrowed;
+        std::unordered_set<const Tensor*> requested;
+        if (inputs)
+            for (auto& t : *inputs)
+                requested.insert(t.get());
+
+        for (auto* n : topo)
+        {
+            if (n -> parents.empty())
+            {
+                if (inputs && n -> requiresGradient && !requested.count(n))
+                {
+                    narrowed.push_back({ n, true });
+                    n -> requiresGradient = false;
+                }
+                continue;
+            }
+
+            bool needed = false;
+            for (auto& p : n -> parents)
+                needed = needed || p -> requiresGradient;
+            n -> requiresGradient = needed;
+        }
+
         // 2.1) Önceki gradient kalıntılarını sil
         if (clearExisting)
             for (auto* n : topo)
-                n->gradient.assign(n->totalSize, 0.0f);
+            {
+                if (!n -> requiresGradient)
+                    continue;
+
+                if (n->gradientIsSparse)
+                    n->sparseGradient.clear();
+                if (!n->gradientIsSparse || !n->gradient.empty())
+                    n->gradient.assign(n->totalSize, 0.0f);
+            }
 
         // 2.2) Root tensöre seed’i koy
         assert((int)seed.size() == this->totalSize);
@@ -217,10 +389,19 @@ namespace SushiAI
         // 2.3) Ters topo’da propagate
         for (auto it = topo.rbegin(); it != topo.rend(); ++it)
         {
-            if ((*it)->gradientFunction)
+            if ((*it)->gradientFunction && (*it)->requiresGradient)
+            {
+                // Reduced-precision activations propagate reduced-precision gradients
+                if ((*it)->dtype != DType::Float32)
+                    roundToDType((*it)->dtype, (*it)->gradient.data(), (*it)->gradient.size());
+
                 (*it)->gradientFunction();
+            }
         }
 
+        for (auto& [n, flag] : narrowed)
+            n -> requiresGradient = flag;
+
         // 2.4) Graph cleanup (yeniden kullanılmayacaksa)
         if (!retainGraph)
         {
@@ -6,9 +6,55 @@
 #include <iostream>
 #include <functional>
 #include <initializer_list>
+#include "half.h"
 
 namespace SushiAI
 {
+    /// Row-sparse gradient of a [rows, cols] parameter: `values` holds one cols-wide row per entry of `indices`.
+    /// Indices may repeat until coalesce() merges them.
+    struct SparseGradient
+    {
+        std::vector<int> indices;
+        std::vector<float> values;
+        int cols = 0;
+
+        size_t rows() const { return indices.size(); }
+        bool empty() const { return indices.empty(); }
+        void clear() { indices.clear(); values.clear(); }
+
+        /// Appends a zeroed row for `index` and returns it.
+        float* addRow(int index)
+        {
+            indices.push_back(index);
+            values.resize(values.size() + cols, 0.0f);
+            return values.data() + values.size() - cols;
+        }
+
+        /// Sorts the rows by index and sums duplicates.
+        void coalesce();
+        /// dense[index, :] += row for every row; dense is the full [rows, cols] gradient.
+        void addTo(std::vector<float>& dense) const;
+    };
+
+    /// False while a NoGradGuard is alive on this thread: op results record no graph and don't require gradients.
+    /// Leaf tensors (parameters, inputs) keep the flag they are constructed with.
+    bool gradientsEnabled();
+
+    /// Disables graph recording for the lifetime of the guard (forward-only work such as recomputable
+    /// checkpoint segments), restoring the previous setting afterwards.
+    class NoGradGuard
+    {
+        private:
+            bool previous;
+
+        public:
+            NoGradGuard();
+            ~NoGradGuard();
+
+            NoGradGuard(const NoGradGuard&) = delete;
+            NoGradGuard& operator=(const NoGradGuard&) = delete;
+    };
+
     /// @class Tensor
     /// Represents a multi-dimensional array with autograd support.
     class Tensor : public std::enable_shared_from_this<Tensor>
@@ -16,6 +62,9 @@ namespace SushiAI
         private:
             std::vector<int> strides;
             int totalSize;
+            bool memoryTracked = false;
+
+            friend class MemoryTracker;
 
             #pragma region Private Methods 
 
@@ -25,14 +74,27 @@ namespace SushiAI
             /// Converts tensor to flat array of floats.
 			int getFlatIndex(std::initializer_list<int> indices) const;
 
+            /// Backpropagation shared by backward() and backwardTo(); inputs, when given, restricts the leaves.
+            void propagate(const std::vector<float>& seed, bool retainGraph, bool clearExisting, const std::vector<std::shared_ptr<Tensor>>* inputs);
+
             #pragma endregion
 
         public:
             std::vector<float> data;
             std::vector<int> shape;
 
+            /// Precision the values are rounded to. Storage is always float (see DType): reduced dtypes emulate
+            /// bf16 / fp16 numerics, every value is representable in 16 bits and packs losslessly with packData().
+            DType dtype = DType::Float32;
+
             bool requiresGradient = false;
             std::vector<float> gradient;
+            /// Set on parameters with row-sparse gradients (Embedding tables): backward fills sparseGradient
+            /// and the dense gradient stays empty. If any other op consumes the tensor (a table tied to an
+            /// output projection), setGradientFunction() allocates the dense gradient as a fallback; from then
+            /// on every op, embedding included, accumulates there and the optimizers take the dense path.
+            bool gradientIsSparse = false;
+            SparseGradient sparseGradient;
             std::function<void()> gradientFunction;
             std::vector<std::shared_ptr<Tensor>> parents;
 
@@ -40,6 +102,7 @@ namespace SushiAI
 
             /// Default Tensor constructor.
             Tensor(const std::vector<int>& shape, float fill = 0.0f, bool requiresGrad = false);
+            ~Tensor();
 
             /// Tensor construction with zeros.
             static std::shared_ptr<Tensor> Zeros(const std::vector<int>& shape, bool requiresGrad = false);
@@ -53,6 +116,12 @@ namespace SushiAI
 
             /// Reshape the tensor to a new shape, ensuring the total size remains the same.
             void reshape(const std::vector<int>& newShape);
+            /// Rounds the values to the given precision and tags the tensor with it.
+            void toDType(DType newDType);
+            /// Packs the values into 16-bit storage of the tensor's dtype (bf16 for Float32 tensors).
+            std::vector<uint16_t> packData() const;
+            /// Switches a 2-D tensor between a dense gradient and a row-sparse one (releasing the dense buffer).
+            void useSparseGradient(bool sparse);
             /// Prints the tensor’s shape, data, and gradients.
             void print(const std::string& name = "") const;
             
@@ -66,7 +135,13 @@ namespace SushiAI
             /// Performs backpropagation starting from a scalar output tensor.
             void backward(bool retainGraph = false, bool clearExisting = true);
             /// Performs backpropagation using a custom gradient seed vector.
+            /// Only nodes on a path to a leaf with requiresGradient run their gradient function; the rest of the
+            /// graph (inputs, frozen parameters and everything that only feeds from them) is skipped.
             void backward(const std::vector<float>& seed, bool retainGraph = false, bool clearExisting = true);
+            /// Backpropagates from a scalar output into the given leaves only; other leaves keep their gradients.
+            void backwardTo(const std::vector<std::shared_ptr<Tensor>>& inputs, bool retainGraph = false, bool clearExisting = true);
+            /// backwardTo() with a custom gradient seed vector.
+            void backwardTo(const std::vector<float>& seed, const std::vector<std::shared_ptr<Tensor>>& inputs, bool retainGraph = false, bool clearExisting = true);
 
             /// Clears the list of parent tensors.
             void clearParents() { parents.clear(); }
@@ -75,9 +150,23 @@ namespace SushiAI
 
             #pragma region Set Gradient Function
 
-            /// Sets the gradient function and its parent tensors for backpropagation.
-            void setGradientFunction(std::function<void()> fn, std::vector<std::shared_ptr<Tensor>> prnts)
+            /// Sets the gradient function and its parent tensors for backpropagation; under a NoGradGuard it
+            /// only marks the result as not requiring gradients. Ops whose backward
+            /// only writes dense gradients leave sparseAware false, so sparse-gradient parents get their
+            /// dense fallback buffer here instead of being written through an empty vector.
+            void setGradientFunction(std::function<void()> fn, std::vector<std::shared_ptr<Tensor>> prnts, bool sparseAware = false)
             {
+                if (!gradientsEnabled())
+                {
+                    requiresGradient = false;
+                    return;
+                }
+
+                if (!sparseAware)
+                    for (auto& p : prnts)
+                        if (p -> gradientIsSparse && p -> gradient.empty())
+                            p -> gradient.assign(p -> totalSize, 0.0f);
+
                 gradientFunction = std::move(fn);
                 parents = std::move(prnts);
             }
@@ -0,0 +1,253 @@
+#pragma once
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+/// Thin wrappers over the widest vector registers the build targets, plus vectorized exp / tanh / sigmoid.
+/// Shared by the SIMD backend and header-only kernels (StaticLinear) that want the same math inlined.
+namespace SushiAI
+{
+    namespace simd
+    {
+        #pragma region Vector Primitives
+
+        // One register type per build: AVX2 (+FMA) when the compiler targets it, SSE2 on any other x86-64, scalar elsewhere.
+        #if defined(__AVX2__)
+
+        constexpr int Lanes = 8;
+        constexpr const char* Isa = "avx2";
+        using vf = __m256;
+        using vi = __m256i;
+
+        inline vf vload(const float* p) { return _mm256_loadu_ps(p); }
+        inline void vstore(float* p, vf v) { _mm256_storeu_ps(p, v); }
+        inline vf vset(float v) { return _mm256_set1_ps(v); }
+        inline vf vzero() { return _mm256_setzero_ps(); }
+        inline vf vadd(vf a, vf b) { return _mm256_add_ps(a, b); }
+        inline vf vsub(vf a, vf b) { return _mm256_sub_ps(a, b); }
+        inline vf vmul(vf a, vf b) { return _mm256_mul_ps(a, b); }
+        inline vf vdiv(vf a, vf b) { return _mm256_div_ps(a, b); }
+        inline vf vmax(vf a, vf b) { return _mm256_max_ps(a, b); }
+        inline vf vmin(vf a, vf b) { return _mm256_min_ps(a, b); }
+        inline vf vand(vf a, vf b) { return _mm256_and_ps(a, b); }
+        inline vf vandnot(vf a, vf b) { return _mm256_andnot_ps(a, b); }
+        inline vf vor(vf a, vf b) { return _mm256_or_ps(a, b); }
+        inline vf vgreater(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        inline vf vless(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        inline vi vround(vf a) { return _mm256_cvtps_epi32(a); }
+        inline vf vfloat(vi a) { return _mm256_cvtepi32_ps(a); }
+        inline vf vexponent(vi n) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23)); }
+
+        /// p[0], p[2], ..., p[2·Lanes - 2] (reads 2·Lanes floats).
+        inline vf vloadEven(const float* p)
+        {
+            __m256 t = _mm256_shuffle_ps(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 8), _MM_SHUFFLE(2, 0, 2, 0));
+            return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(t), _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+
+        /// a * b + c
+        inline vf vfma(vf a, vf b, vf c)
+        {
+            #if defined(__FMA__)
+            return _mm256_fmadd_ps(a, b, c);
+            #else
+            return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+            #endif
+        }
+
+        inline float vsum(vf v)
+        {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            return _mm_cvtss_f32(s);
+        }
+
+        inline float vmaxAcross(vf v)
+        {
+            __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+            s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+            return _mm_cvtss_f32(s);
+        }
+
+        #elif defined(__SSE2__) || defined(_M_X64)
+
+        constexpr int Lanes = 4;
+        constexpr const char* Isa = "sse2";
+        using vf = __m128;
+        using vi = __m128i;
+
+        inline vf vload(const float* p) { return _mm_loadu_ps(p); }
+        inline void vstore(float* p, vf v) { _mm_storeu_ps(p, v); }
+        inline vf vset(float v) { return _mm_set1_ps(v); }
+        inline vf vzero() { return _mm_setzero_ps(); }
+        inline vf vadd(vf a, vf b) { return _mm_add_ps(a, b); }
+        inline vf vsub(vf a, vf b) { return _mm_sub_ps(a, b); }
+        inline vf vmul(vf a, vf b) { return _mm_mul_ps(a, b); }
+        inline vf vdiv(vf a, vf b) { return _mm_div_ps(a, b); }
+        inline vf vmax(vf a, vf b) { return _mm_max_ps(a, b); }
+        inline vf vmin(vf a, vf b) { return _mm_min_ps(a, b); }
+        inline vf vand(vf a, vf b) { return _mm_and_ps(a, b); }
+        inline vf vandnot(vf a, vf b) { return _mm_andnot_ps(a, b); }
+        inline vf vor(vf a, vf b) { return _mm_or_ps(a, b); }
+        inline vf vgreater(vf a, vf b) { return _mm_cmpgt_ps(a, b); }
+        inline vf vless(vf a, vf b) { return _mm_cmplt_ps(a, b); }
+        inline vi vround(vf a) { return _mm_cvtps_epi32(a); }
+        inline vf vfloat(vi a) { return _mm_cvtepi32_ps(a); }
+        inline vf vexponent(vi n) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)); }
+        inline vf vloadEven(const float* p) { return _mm_shuffle_ps(_mm_loadu_ps(p), _mm_loadu_ps(p + 4), _MM_SHUFFLE(2, 0, 2, 0)); }
+        inline vf vfma(vf a, vf b, vf c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+        inline float vsum(vf v)
+        {
+            v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+            return _mm_cvtss_f32(v);
+        }
+
+        inline float vmaxAcross(vf v)
+        {
+            v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+            v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+            return _mm_cvtss_f32(v);
+        }
+
+        #else
+
+        constexpr int Lanes = 1;
+        constexpr const char* Isa = "scalar";
+        using vf = float;
+        using vi = int;
+
+        inline vf vload(const float* p) { return *p; }
+        inline void vstore(float* p, vf v) { *p = v; }
+        inline vf vset(float v) { return v; }
+        inline vf vzero() { return 0.0f; }
+        inline vf vadd(vf a, vf b) { return a + b; }
+        inline vf vsub(vf a, vf b) { return a - b; }
+        inline vf vmul(vf a, vf b) { return a * b; }
+        inline vf vdiv(vf a, vf b) { return a / b; }
+        inline vf vmax(vf a, vf b) { return std::max(a, b); }
+        inline vf vmin(vf a, vf b) { return std::min(a, b); }
+        inline vf vfma(vf a, vf b, vf c) { return a * b + c; }
+        inline vf vloadEven(const float* p) { return *p; }
+        inline vf vgreater(vf a, vf b) { return a > b ? 1.0f : 0.0f; }
+        inline vf vless(vf a, vf b) { return a < b ? 1.0f : 0.0f; }
+        inline float vsum(vf v) { return v; }
+        inline float vmaxAcross(vf v) { return v; }
+
+        #endif
+
+        constexpr bool HasVectors = Lanes > 1;
+
+        #pragma endregion
+
+        #pragma region Vector Math
+
+        #if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+
+        inline vf vselect(vf mask, vf a, vf b) { return vor(vand(mask, a), vandnot(mask, b)); }
+
+        /// exp(x) with a degree-5 polynomial on [-ln2/2, ln2/2] (Cephes expf), ~1 ulp.
+        /// Saturates above 88 and flushes to zero below -87.3, where the float result would be denormal.
+        inline vf vexp(vf x)
+        {
+            vf underflow = vless(x, vset(-87.3f));
+            x = vmax(vmin(x, vset(88.0f)), vset(-87.3f));
+
+            vi n = vround(vmul(x, vset(1.44269504088896341f)));
+            vf fn = vfloat(n);
+            vf r = vsub(vsub(x, vmul(fn, vset(0.693359375f))), vmul(fn, vset(-2.12194440e-4f)));
+
+            vf p = vset(1.9875691500e-4f);
+            p = vfma(p, r, vset(1.3981999507e-3f));
+            p = vfma(p, r, vset(8.3334519073e-3f));
+            p = vfma(p, r, vset(4.1665795894e-2f));
+            p = vfma(p, r, vset(1.6666665459e-1f));
+            p = vfma(p, r, vset(5.0000001201e-1f));
+            p = vadd(vfma(p, vmul(r, r), r), vset(1.0f));
+
+            return vandnot(underflow, vmul(p, vexponent(n)));
+        }
+
+        /// tanh(x): odd polynomial below |x| = 0.625 (Cephes tanhf), 1 - 2 / (exp(2|x|) + 1) above it.
+        inline vf vtanh(vf x)
+        {
+            const vf signMask = vset(-0.0f);
+            vf ax = vandnot(signMask, x);
+
+            vf z = vmul(x, x);
+            vf p = vset(-5.70498872745e-3f);
+            p = vfma(p, z, vset(2.06390887954e-2f));
+            p = vfma(p, z, vset(-5.37397155531e-2f));
+            p = vfma(p, z, vset(1.33314422036e-1f));
+            p = vfma(p, z, vset(-3.33332819422e-1f));
+            vf small = vfma(vmul(p, z), x, x);
+
+            vf e = vexp(vadd(ax, ax));
+            vf large = vsub(vset(1.0f), vdiv(vset(2.0f), vadd(e, vset(1.0f))));
+            large = vor(large, vand(signMask, x));
+
+            return vselect(vless(ax, vset(0.625f)), small, large);
+        }
+
+        inline vf vsigmoid(vf x)
+        {
+            const vf one = vset(1.0f);
+            return vdiv(one, vadd(one, vexp(vsub(vzero(), x))));
+        }
+
+        #else
+
+        inline vf vselect(vf mask, vf a, vf b) { return mask != 0.0f ? a : b; }
+        inline vf vexp(vf x) { return std::exp(x); }
+        inline vf vtanh(vf x) { return std::tanh(x); }
+        inline vf vsigmoid(vf x) { return 1.0f / (1.0f + std::exp(-x)); }
+
+        #endif
+
+        /// y[i] = op(x[i]). The tail goes through a padded register too, so every element sees the same approximation.
+        template <typename Op>
+        inline void mapUnary(const float* x, float* y, size_t n, Op op)
+        {
+            size_t i = 0;
+            for (; i + Lanes <= n; i += Lanes)
+                vstore(y + i, op(vload(x + i)));
+
+            if (i < n)
+            {
+                float tx[Lanes] = {}, ty[Lanes];
+                std::memcpy(tx, x + i, (n - i) * sizeof(float));
+                vstore(ty, op(vload(tx)));
+                std::memcpy(y + i, ty, (n - i) * sizeof(float));
+            }
+        }
+
+        /// dx[i] += op(a[i], dy[i]).
+        template <typename Op>
+        inline void mapBackward(const float* a, const float* dy, float* dx, size_t n, Op op)
+        {
+            size_t i = 0;
+            for (; i + Lanes <= n; i += Lanes)
+                vstore(dx + i, vadd(vload(dx + i), op(vload(a + i), vload(dy + i))));
+
+            if (i < n)
+            {
+                float ta[Lanes] = {}, tdy[Lanes] = {}, tdx[Lanes] = {};
+                size_t bytes = (n - i) * sizeof(float);
+                std::memcpy(ta, a + i, bytes);
+                std::memcpy(tdy, dy + i, bytes);
+                std::memcpy(tdx, dx + i, bytes);
+                vstore(tdx, vadd(vload(tdx), op(vload(ta), vload(tdy))));
+                std::memcpy(dx + i, tdx, bytes);
+            }
+        }
+
+        #pragma endregion
+    }
+}
@@ -2,11 +2,14 @@
 #include <cassert>
 #include "loss.h"
 #include "ops.h"
+#include "profiler.h"
 
 namespace SushiAI
 {
     std::shared_ptr<Tensor> MSELoss::forward(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& target)
     {
+        ProfileScope scope("mseLoss", "forward");
+
         const auto& inputData = input -> getData();
         const auto& targetData = target -> getData();
         size_t N = inputData.size();
@@ -21,19 +24,32 @@ namespace SushiAI
         }
 
         float lossValue = sum / static_cast<float>(N);
-        auto loss = std::make_shared<Tensor>(std::vector<int>{1}, lossValue, true);
+        // Targets are data: the loss only needs a gradient when its prediction does
+        auto loss = std::make_shared<Tensor>(std::vector<int>{1}, lossValue, input -> requiresGradient);
 
-        loss -> setGradientFunction([input, target, loss, N]() 
+        if (loss -> requiresGradient)
         {
-            float gradOut = loss -> getGradient()[0];
-            auto& inGrad = input -> getGradient();
-            const auto& inData = input -> getData();
-            const auto& tData = target -> getData();
+            loss -> setGradientFunction([input, target, loss, N, layer = scope.getLayer()]() 
+            {
+                ProfileScope scope("mseLoss", "backward", layer);
+                scope.setCost(4.0 * N, 3.0 * N * sizeof(float));
+
+                float gradOut = loss -> getGradient()[0];
+                auto& inGrad = input -> getGradient();
+                const auto& inData = input -> getData();
+                const auto& tData = target -> getData();
+
+                for (size_t i = 0; i < N; ++i) 
+                    inGrad[i] += gradOut * 2.0f * (inData[i] - tData[i]) / static_cast<float>(N);
 
-            for (size_t i = 0; i < N; ++i) 
-                inGrad[i] += gradOut * 2.0f * (inData[i] - tData[i]) / static_cast<float>(N);
+            }, { input });
+        }
 
-        }, { input });
+        if (scope.active())
+        {
+            scope.setShape(loss -> getShape());
+            scope.setCost(3.0 * N, 2.0 * N * sizeof(float));
+        }
 
         return loss;
     }
@@ -1,5 +1,7 @@
-﻿#include <iostream>
+﻿#include <cmath>
+#include <iostream>
 #include <iomanip>
+#include <string>
 #include <vector>
 #include <random>
 #include <memory>
@@ -8,6 +10,7 @@
 #include "initializer.h"
 #include "sequential.h"
 #include "optimizer.h"
+#include "passes.h"
 #include "tensor.h"
 #include "layer.h"
 #include "loss.h"
@@ -51,8 +54,13 @@ using namespace SushiAI;
     solver.train();
 }*/
 
-int main()
+int main(int argc, char** argv)
 {
+    // --report adds the model's predicted cost before training and the inference-export rewrite after it
+    bool report = false;
+    for (int i = 1; i < argc; ++i)
+        report = report || std::string(argv[i]) == "--report";
+
     std::vector<std::pair<std::shared_ptr<Tensor>, std::shared_ptr<Tensor>>> dataset;
     std::mt19937 gen(std::random_device{}());
     std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
@@ -63,7 +71,7 @@ int main()
         float x2 = dist(gen);
         float y = (x1 * x1) + x2;
 
-        auto input = std::make_shared<Tensor>(std::vector<int>{1, 2}, 0.0f, true);
+        auto input = std::make_shared<Tensor>(std::vector<int>{1, 2}, 0.0f, false);
         auto target = std::make_shared<Tensor>(std::vector<int>{1, 1}, y, false);
 
         input->getData()[0] = x1;
@@ -79,6 +87,10 @@ int main()
     model->add(std::make_shared<Tanh>());
     model->add(std::make_shared<Linear>(16, 1, std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>()));
 
+    // Predicted per-layer cost of one training step on a single sample
+    if (report)
+        model->printSummary({ 1, 2 });
+
     // === 3) Loss & Optimizer
     auto lossFunction = std::make_shared<MSELoss>();
     auto optimizer = std::make_shared<Adam>(
@@ -154,6 +166,18 @@ int main()
         std::cout << std::endl;
     }
 
+    // === 5) Inference export: the back-to-back Linear(2,16) and Linear(16,16) collapse into one layer
+    if (report)
+    {
+        std::vector<std::shared_ptr<Tensor>> samples;
+        for (size_t i = 0; i < 8; ++i)
+            samples.push_back(dataset[i].first);
+
+        OptimizationReport optimization;
+        auto exported = optimizeForInference(*model, samples, &optimization);
+        optimization.print();
+    }
+
     return 0;
 }
 
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <stdexcept>
+#include "activationcache.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+namespace SushiAI
+{
+    namespace
+    {
+        /// Layers that compute something else in training mode (looking inside nested models): the cached
+        /// inference-mode output would silently switch them off.
+        bool modeDependent(const std::shared_ptr<Layer>& layer)
+        {
+            if (auto nested = std::dynamic_pointer_cast<Sequential>(layer))
+            {
+                for (size_t i = 0; i < nested -> layersSize(); ++i)
+                    if (modeDependent(nested -> getLayer(i)))
+                        return true;
+
+                return false;
+            }
+
+            return std::dynamic_pointer_cast<Dropout>(layer) || std::dynamic_pointer_cast<BatchNorm>(layer);
+        }
+    }
+
+    ActivationCache::ActivationCache(std::shared_ptr<Sequential> model, size_t numSamples) : model(std::move(model)), numSamples(numSamples)
+    {
+
+    }
+
+    ActivationCache::ActivationCache(std::shared_ptr<Sequential> model, size_t numSamples, const std::string& path) : model(std::move(model)), numSamples(numSamples), path(path)
+    {
+        if (path.empty())
+            throw std::invalid_argument("ActivationCache: empty file path");
+    }
+
+    ActivationCache::~ActivationCache()
+    {
+        release();
+    }
+
+    size_t ActivationCache::frozenPrefix() const
+    {
+        size_t n = 0;
+        while (n < model -> layersSize() && !model -> getLayer(n) -> isTrainable() && !modeDependent(model -> getLayer(n)))
+            ++n;
+
+        return n;
+    }
+
+    std::shared_ptr<Tensor> ActivationCache::forward(size_t sampleIndex, const std::shared_ptr<Tensor>& input, bool training)
+    {
+        if (sampleIndex >= numSamples)
+            throw std::out_of_range("ActivationCache::forward(): sample " + std::to_string(sampleIndex) + " of " + std::to_string(numSamples));
+
+        size_t prefix = frozenPrefix();
+        if (prefix != prefixLength)
+        {
+            invalidate();
+            prefixLength = prefix;
+        }
+
+        if (prefixLength == 0)
+            return model -> forward(input, training);
+
+        std::shared_ptr<Tensor> out;
+
+        if (sampleSize && present[sampleIndex])
+        {
+            ++hits;
+
+            const float* cached = (mapped ? mapped : memory.data()) + sampleIndex * sampleSize;
+            out = std::make_shared<Tensor>(sampleShape, 0.0f, false);
+            std::copy(cached, cached + sampleSize, out -> getData().begin());
+        }
+        else
+        {
+            ++misses;
+
+            out = input;
+            {
+                NoGradGuard guard;
+                for (size_t i = 0; i < prefixLength; ++i)
+                    out = model -> getLayer(i) -> forward(out, false);
+            }
+
+            float* storage = sampleSize ? (mapped ? mapped : memory.data()) : allocate(out -> getShape());
+            if (out -> getShape() != sampleShape)
+                throw std::invalid_argument("ActivationCache::forward(): sample " + std::to_string(sampleIndex) + " gives the frozen prefix a different output shape");
+
+            std::copy(out -> getData().begin(), out -> getData().end(), storage + sampleIndex * sampleSize);
+            present[sampleIndex] = true;
+        }
+
+        for (size_t i = prefixLength; i < model -> layersSize(); ++i)
+            out = model -> getLayer(i) -> forward(out, training);
+
+        return out;
+    }
+
+    void ActivationCache::invalidate()
+    {
+        release();
+        sampleShape.clear();
+        sampleSize = 0;
+        present.clear();
+    }
+
+    size_t ActivationCache::bytes() const
+    {
+        return mapped ? mappedBytes : memory.size() * sizeof(float);
+    }
+
+    float* ActivationCache::allocate(const std::vector<int>& shape)
+    {
+        sampleShape = shape;
+        sampleSize = 1;
+        for (int d : shape)
+            sampleSize *= d;
+
+        present.assign(numSamples, false);
+
+        if (path.empty())
+        {
+            memory.assign(numSamples * sampleSize, 0.0f);
+            return memory.data();
+        }
+
+        mappedBytes = std::max<size_t>(numSamples * sampleSize * sizeof(float), 1);
+
+        #ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("ActivationCache: can't create " + path);
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)mappedBytes >> 32), (DWORD)(mappedBytes & 0xffffffffu), nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, mappedBytes) : nullptr;
+        fileHandle = file;
+        mappingHandle = mapping;
+        #else
+        fileDescriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fileDescriptor < 0)
+            throw std::runtime_error("ActivationCache: can't create " + path);
+
+        void* view = nullptr;
+        if (ftruncate(fileDescriptor, (off_t)mappedBytes) == 0)
+        {
+            view = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+            if (view == MAP_FAILED)
+                view = nullptr;
+        }
+        #endif
+
+        if (!view)
+        {
+            release();
+            throw std::runtime_error("ActivationCache: can't map " + std::to_string(mappedBytes) + " bytes of " + path);
+        }
+
+        mapped = static_cast<float*>(view);
+        return mapped;
+    }
+
+    void ActivationCache::release()
+    {
+        memory.clear();
+        memory.shrink_to_fit();
+
+        #ifdef _WIN32
+        if (mapped)
+            UnmapViewOfFile(mapped);
+        if (mappingHandle)
+            CloseHandle(mappingHandle);
+        if (fileHandle)
+            CloseHandle(fileHandle);
+
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+        #else
+        if (mapped)
+            munmap(mapped, mappedBytes);
+        if (fileDescriptor >= 0)
+        {
+            close(fileDescriptor);
+            unlink(path.c_str());
+        }
+
+        fileDescriptor = -1;
+        #endif
+
+        mapped = nullptr;
+        mappedBytes = 0;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include "sequential.h"
+#include "tensor.h"
+
+namespace SushiAI
+{
+    /// Fine-tuning helper: caches, per dataset sample, the output of a Sequential's frozen prefix (the leading
+    /// layers without trainable parameters) so that later epochs start at the first trainable layer.
+    /// The prefix runs once per sample in inference mode without recording a graph, so it also ends at the
+    /// first Dropout or BatchNorm (nested ones included): those behave differently in training, and
+    /// caching would silently switch them to inference. Every sample must give the prefix output the same
+    /// shape. Freezing or unfreezing layers moves the prefix boundary and drops the cache; call invalidate()
+    /// after editing the prefix weights directly.
+    /// Entries live in memory, or in a memory-mapped scratch file when a path is given (created or truncated,
+    /// removed again by the destructor) so datasets larger than RAM stay paged by the OS.
+    class ActivationCache
+    {
+        public:
+            ActivationCache(std::shared_ptr<Sequential> model, size_t numSamples);
+            ActivationCache(std::shared_ptr<Sequential> model, size_t numSamples, const std::string& path);
+            ~ActivationCache();
+
+            ActivationCache(const ActivationCache&) = delete;
+            ActivationCache& operator=(const ActivationCache&) = delete;
+
+            /// model -> forward(input, training) for the given sample, reading its prefix output from the cache
+            /// (and filling the cache on a miss).
+            std::shared_ptr<Tensor> forward(size_t sampleIndex, const std::shared_ptr<Tensor>& input, bool training = true);
+
+            void invalidate();
+
+            /// Number of leading layers whose output is cached.
+            size_t getPrefixLength() const { return prefixLength; }
+            size_t getHits() const { return hits; }
+            size_t getMisses() const { return misses; }
+            /// Bytes reserved for the cached activations (mapped file size in file mode).
+            size_t bytes() const;
+
+        private:
+            std::shared_ptr<Sequential> model;
+            size_t numSamples;
+            std::string path;
+
+            size_t prefixLength = 0;
+            std::vector<int> sampleShape;
+            size_t sampleSize = 0;
+            std::vector<bool> present;
+            size_t hits = 0, misses = 0;
+
+            std::vector<float> memory;
+            float* mapped = nullptr;
+            size_t mappedBytes = 0;
+            #ifdef _WIN32
+            void* fileHandle = nullptr;
+            void* mappingHandle = nullptr;
+            #else
+            int fileDescriptor = -1;
+            #endif
+
+            size_t frozenPrefix() const;
+            float* allocate(const std::vector<int>& shape);
+            void release();
+    };
+}
@@ -0,0 +1,306 @@
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include "costmodel.h"
+#include "sequential.h"
+#include "inference.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        double elementCount(const std::vector<int>& shape)
+        {
+            double n = 1.0;
+            for (int d : shape)
+                n *= d;
+
+            return n;
+        }
+
+        std::string shapeText(const std::vector<int>& shape)
+        {
+            std::string text = "[";
+            for (size_t i = 0; i < shape.size(); ++i)
+                text += (i ? "," : "") + std::to_string(shape[i]);
+
+            return text + "]";
+        }
+
+        /// Shape and FLOPs of one layer. Backward is split into the input-gradient and parameter-gradient
+        /// parts so the caller can drop whichever the pruned graph doesn't run; nodes is the number of graph
+        /// tensors of the output's size the layer leaves behind, savedFloats anything else it keeps for backward.
+        struct LayerShape
+        {
+            std::vector<int> output;
+            double forward = 0.0, inputGradient = 0.0, parameterGradient = 0.0;
+            double nodes = 1.0, savedFloats = 0.0;
+            /// Parameter floats the forward reads and the backward writes; < 0 means all of them.
+            double parameterReads = -1.0, parameterWrites = -1.0;
+        };
+
+        LayerShape inferLayer(const std::shared_ptr<Layer>& layer, const std::vector<int>& in, bool training)
+        {
+            auto fail = [&](const std::string& expected)
+            {
+                return std::invalid_argument("analyzeCost(): " + layer -> name() + " expects " + expected + " input, got " + shapeText(in));
+            };
+
+            LayerShape s;
+            const double elements = elementCount(in);
+            PlanActivation act;
+            float alpha;
+
+            if (auto linear = std::dynamic_pointer_cast<Linear>(layer))
+            {
+                const double inF = linear -> weights -> getShape()[0], outF = linear -> weights -> getShape()[1];
+                if (in.empty() || in.back() != inF)
+                    throw fail("[..., " + std::to_string((int)inF) + "]");
+
+                const double rows = elements / inF;
+                s.output = in;
+                s.output.back() = (int)outF;
+                if (in.size() == 1)
+                    s.output.insert(s.output.begin(), 1);
+
+                s.forward = 2.0 * rows * inF * outF + rows * outF;
+                s.inputGradient = 2.0 * rows * inF * outF;
+                s.parameterGradient = 2.0 * rows * inF * outF + rows * outF;
+                s.nodes = 2.0;                              // matmul, bias add
+            }
+            else if (auto conv = std::dynamic_pointer_cast<Conv2d>(layer))
+            {
+                const auto& w = conv -> weights -> getShape();
+                const int k = w[2], span = conv -> dilation * (k - 1) + 1;
+                if (in.size() != 4 || in[1] != w[1] * conv -> groups)
+                    throw fail("[N, " + std::to_string(w[1] * conv -> groups) + ", H, W]");
+
+                const int outH = (in[2] + 2 * conv -> padding - span) / conv -> stride + 1;
+                const int outW = (in[3] + 2 * conv -> padding - span) / conv -> stride + 1;
+                s.output = { in[0], w[0], outH, outW };
+
+                const double outputs = elementCount(s.output), macs = outputs * w[1] * k * k;
+                s.forward = 2.0 * macs + outputs;
+                s.inputGradient = 2.0 * macs;
+                s.parameterGradient = 2.0 * macs + outputs;
+            }
+            else if (auto embedding = std::dynamic_pointer_cast<Embedding>(layer))
+            {
+                s.output = in;
+                s.output.push_back(embedding -> weights -> getShape()[1]);
+                s.parameterGradient = elementCount(s.output);       // scatter-add of the looked-up rows
+
+                // Only the looked-up rows are read; a sparse gradient only holds those rows, a dense one
+                // is the whole table (cleared and stepped in full)
+                s.parameterReads = elementCount(s.output);
+                if (embedding -> weights -> gradientIsSparse)
+                    s.parameterWrites = elementCount(s.output);
+            }
+            else if (auto attention = std::dynamic_pointer_cast<MultiHeadAttention>(layer))
+            {
+                const double E = attention -> queryWeights -> getShape()[0];
+                if (in.size() != 3 || in[2] != E)
+                    throw fail("[batch, seq, " + std::to_string((int)E) + "]");
+
+                const double rows = (double)in[0] * in[1], T = in[1];
+                const double projections = 4.0 * (2.0 * rows * E * E + rows * E);
+                const double scores = (attention -> causal ? 0.5 : 1.0) * rows * T;
+                const double core = 4.0 * scores * E + 5.0 * scores * attention -> numHeads;   // QKᵀ, PV, softmax
+
+                s.output = in;
+                s.forward = projections + core;
+                s.inputGradient = 4.0 * 2.0 * rows * E * E + 2.0 * core;                      // dX through Q/K/V/O, recomputed P
+                s.parameterGradient = projections;
+                s.nodes = 9.0;                                                                  // 4 × (matmul, bias), attention
+            }
+            else if (std::dynamic_pointer_cast<LSTM>(layer) || std::dynamic_pointer_cast<GRU>(layer))
+            {
+                auto lstm = std::dynamic_pointer_cast<LSTM>(layer);
+                auto gru = std::dynamic_pointer_cast<GRU>(layer);
+                const auto& wx = lstm ? lstm -> inputWeights -> getShape() : gru -> inputWeights -> getShape();
+                const double I = wx[0], G = wx[1], H = lstm ? G / 4.0 : G / 3.0;
+                if (in.size() != 3 || in[2] != I)
+                    throw fail("[batch, steps, " + std::to_string((int)I) + "]");
+
+                const double rows = (double)in[0] * in[1];
+                s.output = { in[0], in[1], (int)H };
+                s.forward = 2.0 * rows * (I + H) * G + 10.0 * rows * G;
+                s.inputGradient = 2.0 * rows * I * G + 2.0 * rows * H * G + 10.0 * rows * G;  // dX and dh through time
+                s.parameterGradient = 2.0 * rows * (I + H) * G + rows * G;
+                s.savedFloats = rows * (G + H);                                                 // gates and states
+            }
+            else if (asActivation(layer, act, alpha))
+            {
+                s.output = in;
+                s.forward = s.inputGradient = elements;
+            }
+            else if (std::dynamic_pointer_cast<Dropout>(layer))
+            {
+                s.output = in;
+                s.forward = s.inputGradient = training ? elements : 0.0;
+                s.nodes = training ? 1.0 : 0.0;
+            }
+            else if (auto bn = std::dynamic_pointer_cast<BatchNorm>(layer))
+            {
+                if (in.size() != 2 || in[1] != bn -> getNumFeatures())
+                    throw fail("[batch, " + std::to_string(bn -> getNumFeatures()) + "]");
+
+                s.output = in;
+                s.forward = (training ? 7.0 : 4.0) * elements;
+                s.inputGradient = 6.0 * elements;
+                s.parameterGradient = 2.0 * elements;
+            }
+            else if (std::dynamic_pointer_cast<LayerNorm>(layer) || std::dynamic_pointer_cast<RMSNorm>(layer))
+            {
+                auto layerNorm = std::dynamic_pointer_cast<LayerNorm>(layer);
+                int features = layerNorm ? layerNorm -> getNumFeatures() : std::dynamic_pointer_cast<RMSNorm>(layer) -> getNumFeatures();
+                if (in.empty() || in.back() != features)
+                    throw fail("[..., " + std::to_string(features) + "]");
+
+                s.output = in;
+                s.forward = 8.0 * elements;
+                s.inputGradient = 10.0 * elements;
+                s.parameterGradient = 3.0 * elements;
+            }
+            else if (std::dynamic_pointer_cast<MaxPool2d>(layer) || std::dynamic_pointer_cast<AvgPool2d>(layer))
+            {
+                auto maxPool = std::dynamic_pointer_cast<MaxPool2d>(layer);
+                auto avgPool = std::dynamic_pointer_cast<AvgPool2d>(layer);
+                const int k = maxPool ? maxPool -> kernelSize : avgPool -> kernelSize;
+                const int stride = maxPool ? maxPool -> stride : avgPool -> stride;
+                const int padding = maxPool ? maxPool -> padding : avgPool -> padding;
+                if (in.size() != 4)
+                    throw fail("[N, C, H, W]");
+
+                s.output = { in[0], in[1], (in[2] + 2 * padding - k) / stride + 1, (in[3] + 2 * padding - k) / stride + 1 };
+                s.forward = elementCount(s.output) * k * k;
+                s.inputGradient = maxPool ? elementCount(s.output) : s.forward;
+            }
+            else if (auto adaptive = std::dynamic_pointer_cast<AdaptiveAvgPool2d>(layer))
+            {
+                if (in.size() != 4)
+                    throw fail("[N, C, H, W]");
+
+                s.output = { in[0], in[1], adaptive -> outH, adaptive -> outW };
+                s.forward = s.inputGradient = elements;
+            }
+            else if (std::dynamic_pointer_cast<GlobalAvgPool2d>(layer))
+            {
+                if (in.size() != 4)
+                    throw fail("[N, C, H, W]");
+
+                s.output = { in[0], in[1] };
+                s.forward = s.inputGradient = elements;
+            }
+            else
+                throw std::invalid_argument("analyzeCost(): no cost model for " + layer -> name());
+
+            return s;
+        }
+    }
+
+    CostReport analyzeCost(const Sequential& model, const std::vector<int>& inputShape, bool training, bool inputRequiresGrad, const MachinePeak* machine)
+    {
+        CostReport report;
+        report.inputShape = inputShape;
+        report.training = training;
+        report.machine = machine ? *machine : machinePeak();
+
+        auto layers = model.flattenedLayers();
+
+        const double flopRate = report.machine.gflops * 1e9, byteRate = report.machine.bandwidthGBs * 1e9;
+        auto roofline = [&](double flops, double bytes)
+        {
+            return std::max(flopRate > 0.0 ? flops / flopRate : 0.0, byteRate > 0.0 ? bytes / byteRate : 0.0);
+        };
+
+        std::vector<int> shape = inputShape;
+        bool gradientFlows = inputRequiresGrad;     // does anything before this layer want a gradient?
+
+        for (size_t i = 0; i < layers.size(); ++i)
+        {
+            auto& layer = layers[i];
+            LayerShape s = inferLayer(layer, shape, training);
+
+            LayerCost c;
+            c.label = "[" + std::to_string(i) + "] " + layer -> name();
+            c.outputShape = s.output;
+
+            double parameters = 0.0;
+            for (auto& p : layer -> parameters())
+                parameters += p -> getTotalSize();
+
+            const double inputs = elementCount(shape), outputs = elementCount(s.output);
+            const double parameterReads = s.parameterReads < 0.0 ? parameters : s.parameterReads;
+            const double parameterWrites = s.parameterWrites < 0.0 ? parameters : s.parameterWrites;
+            bool trainable = layer -> isTrainable();
+
+            c.forwardFlops = s.forward;
+            c.forwardBytes = (inputs + outputs + parameterReads) * sizeof(float);
+            c.parameterBytes = (size_t)parameters * sizeof(float);
+            c.intensity = c.forwardBytes > 0.0 ? c.forwardFlops / c.forwardBytes : 0.0;
+            c.computeBound = byteRate > 0.0 && c.intensity >= flopRate / byteRate;
+            c.forwardSeconds = roofline(c.forwardFlops, c.forwardBytes);
+
+            if (training)
+            {
+                c.activationBytes = (size_t)((s.nodes * outputs * 2.0 + s.savedFloats) * sizeof(float));
+
+                if (gradientFlows || trainable)
+                {
+                    c.backwardFlops = (gradientFlows ? s.inputGradient : 0.0) + (trainable ? s.parameterGradient : 0.0);
+                    c.backwardBytes = (outputs + (gradientFlows ? 2.0 * inputs : inputs) + parameterReads + (trainable ? parameterWrites : 0.0)) * sizeof(float);
+                    c.backwardSeconds = roofline(c.backwardFlops, c.backwardBytes);
+                }
+
+                gradientFlows = gradientFlows || trainable;
+            }
+
+            report.forwardFlops += c.forwardFlops;
+            report.backwardFlops += c.backwardFlops;
+            report.activationBytes += c.activationBytes;
+            report.parameterBytes += c.parameterBytes;
+            report.forwardSeconds += c.forwardSeconds;
+            report.backwardSeconds += c.backwardSeconds;
+
+            report.layers.push_back(std::move(c));
+            shape = s.output;
+        }
+
+        report.outputShape = shape;
+
+        return report;
+    }
+
+    void CostReport::print() const
+    {
+        auto kb = [](double bytes) { return bytes / 1024.0; };
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+        std::cout << std::fixed << std::setprecision(2);
+
+        std::cout << "=== Cost Model " << shapeText(inputShape) << " -> " << shapeText(outputShape) << (training ? " (training)" : " (inference)") << " ===\n";
+        std::cout << std::left << std::setw(42) << "layer" << std::setw(16) << "output" << std::right
+            << std::setw(12) << "fwd MFLOP" << std::setw(12) << "bwd MFLOP" << std::setw(12) << "act KiB" << std::setw(12) << "param KiB"
+            << std::setw(10) << "FLOP/B" << std::setw(10) << "est ms" << "  bound\n";
+
+        for (auto& l : layers)
+            std::cout << std::left << std::setw(42) << l.label << std::setw(16) << shapeText(l.outputShape) << std::right
+                << std::setw(12) << l.forwardFlops / 1e6 << std::setw(12) << l.backwardFlops / 1e6
+                << std::setw(12) << kb(l.activationBytes) << std::setw(12) << kb(l.parameterBytes)
+                << std::setw(10) << l.intensity << std::setw(10) << (l.forwardSeconds + l.backwardSeconds) * 1e3
+                << "  " << (l.computeBound ? "compute" : "memory") << "\n";
+
+        std::cout << std::left << std::setw(58) << "total" << std::right
+            << std::setw(12) << forwardFlops / 1e6 << std::setw(12) << backwardFlops / 1e6
+            << std::setw(12) << kb(activationBytes) << std::setw(12) << kb(parameterBytes)
+            << std::setw(10) << "" << std::setw(10) << stepSeconds() * 1e3 << "\n";
+
+        std::cout << "Machine: " << machine.gflops << " GFLOP/s, " << machine.bandwidthGBs << " GB/s (" << machine.threads << " threads)"
+            << " | estimated step " << stepSeconds() * 1e3 << " ms (forward " << forwardSeconds * 1e3 << ", backward " << backwardSeconds * 1e3 << ")\n";
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+}
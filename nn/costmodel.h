@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include "machine.h"
+#include "layer.h"
+
+namespace SushiAI
+{
+    class Sequential;
+
+    struct LayerCost
+    {
+        std::string label;                  // "[i] Layer"
+        std::vector<int> outputShape;
+        double forwardFlops = 0.0;
+        double backwardFlops = 0.0;         // input and parameter gradients that backward() actually computes
+        double forwardBytes = 0.0;          // input + output + parameters read (an Embedding's looked-up rows), each once
+        double backwardBytes = 0.0;
+        size_t activationBytes = 0;         // training: graph outputs (data + gradient) held until backward
+        size_t parameterBytes = 0;
+        double intensity = 0.0;             // forward FLOPs per byte
+        double forwardSeconds = 0.0;        // roofline estimates on the machine peak
+        double backwardSeconds = 0.0;
+        bool computeBound = false;
+    };
+
+    /// Static cost of one forward (+ backward) pass of a Sequential at a fixed input shape.
+    struct CostReport
+    {
+        std::vector<int> inputShape, outputShape;
+        std::vector<LayerCost> layers;
+        double forwardFlops = 0.0, backwardFlops = 0.0;
+        size_t activationBytes = 0, parameterBytes = 0;
+        double forwardSeconds = 0.0, backwardSeconds = 0.0;
+        bool training = true;
+        MachinePeak machine;
+
+        double stepSeconds() const { return forwardSeconds + backwardSeconds; }
+        void print() const;
+    };
+
+    /// Propagates inputShape through every layer without running it and prices each one: FLOPs of the
+    /// forward and backward kernels, activation/parameter bytes and arithmetic intensity. Step time is a
+    /// roofline estimate per layer, max(FLOPs / peak GFLOP/s, bytes / bandwidth), on the measured
+    /// machinePeak() or on the given (e.g. prospective) machine. Backward follows the graph pruning: frozen
+    /// layers skip their parameter gradients and nothing before the first trainable layer (or a
+    /// gradient-requiring input) propagates an input gradient. Throws for layers it has no model of.
+    CostReport analyzeCost(const Sequential& model, const std::vector<int>& inputShape, bool training = true,
+        bool inputRequiresGrad = false, const MachinePeak* machine = nullptr);
+}
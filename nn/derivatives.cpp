@@ -0,0 +1,365 @@
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include "derivatives.h"
+#include "inference.h"
+#include "derivativesdetail.h"
+#include "profiler.h"
+#include "backend.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using detail::activationDerivatives;
+
+        /// Linear layer on [value; tangent] rows: Y = S W, the bias on the value rows, and the parameter
+        /// direction x V_W + V_b on the tangent rows (vw / vb may be nullptr for a zero direction).
+        std::shared_ptr<Tensor> tangentLinear(const std::shared_ptr<Tensor>& s, const std::shared_ptr<Tensor>& w, const std::shared_ptr<Tensor>& b,
+            const std::shared_ptr<Tensor>& vw, const std::shared_ptr<Tensor>& vb, int n)
+        {
+            ProfileScope scope("tangentLinear", "forward");
+
+            const int in = w -> getShape()[0], out = w -> getShape()[1];
+
+            if (s -> getShape()[1] != in)
+                throw std::invalid_argument("hvp(): Linear expects " + std::to_string(in) + " features, got " + std::to_string(s -> getShape()[1]));
+
+            auto result = std::make_shared<Tensor>(std::vector<int>{ 2 * n, out }, 0.0f,
+                s -> requiresGradient || w -> requiresGradient || b -> requiresGradient);
+            auto& Y = result -> getData();
+            float* tangent = Y.data() + (size_t)n * out;
+
+            const Backend& be = backend();
+            be.gemm(false, false, 2 * n, out, in, s -> data.data(), in, w -> data.data(), out, Y.data(), out);
+            be.addRow(Y.data(), b -> data.data(), Y.data(), n, out);
+            if (vw)
+                be.gemm(false, false, n, out, in, s -> data.data(), in, vw -> data.data(), out, tangent, out);
+            if (vb)
+                be.addRow(tangent, vb -> data.data(), tangent, n, out);
+
+            if (result -> requiresGradient)
+            {
+                auto s_ptr = s;
+                auto w_ptr = w;
+                auto b_ptr = b;
+                auto result_ptr = result;
+                result -> setGradientFunction([s_ptr, w_ptr, b_ptr, vw, result_ptr, in, out, n, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("tangentLinear", "backward", layer);
+                    scope.setCost((vw ? 10.0 : 8.0) * n * in * out, (4.0 * n * in + 3.0 * in * out + 2.0 * n * out) * sizeof(float));
+
+                    const auto& dY = result_ptr -> gradient;
+                    const Backend& be = backend();
+
+                    if (s_ptr -> requiresGradient)
+                    {
+                        // dS = dY · W^T, and the value rows also feed the tangent through V_W
+                        be.gemm(false, true, 2 * n, in, out, dY.data(), out, w_ptr -> data.data(), out, s_ptr -> gradient.data(), in);
+                        if (vw)
+                            be.gemm(false, true, n, in, out, dY.data() + (size_t)n * out, out, vw -> data.data(), out, s_ptr -> gradient.data(), in);
+                    }
+
+                    if (w_ptr -> requiresGradient)
+                        be.gemm(true, false, in, out, 2 * n, s_ptr -> data.data(), in, dY.data(), out, w_ptr -> gradient.data(), out);
+
+                    if (b_ptr -> requiresGradient)
+                        be.accumulateRows(dY.data(), b_ptr -> gradient.data(), n, out);
+                }, { s_ptr, w_ptr, b_ptr });
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost((vw ? 6.0 : 4.0) * n * in * out, (2.0 * n * in + 2.0 * in * out + 2.0 * n * out) * sizeof(float));
+            }
+
+            return result;
+        }
+
+        /// y = σ(u), ẏ = σ'(u) u̇ on [value; tangent] rows.
+        std::shared_ptr<Tensor> tangentActivation(const std::shared_ptr<Tensor>& s, PlanActivation act, float alpha, int n)
+        {
+            ProfileScope scope("tangentActivation", "forward");
+
+            const size_t size = (size_t)n * s -> getShape()[1];
+
+            auto result = std::make_shared<Tensor>(s -> getShape(), 0.0f, s -> requiresGradient);
+            const auto& S = s -> getData();
+            auto& Y = result -> getData();
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                float d1, d2, d3;
+                activationDerivatives(act, S[i], alpha, d1, d2, d3);
+
+                Y[i] = applyActivation(act, S[i], alpha);
+                Y[size + i] = d1 * S[size + i];
+            }
+
+            if (s -> requiresGradient)
+            {
+                auto s_ptr = s;
+                auto result_ptr = result;
+                result -> setGradientFunction([s_ptr, result_ptr, act, alpha, size, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("tangentActivation", "backward", layer);
+                    scope.setCost(8.0 * size, 6.0 * size * sizeof(float));
+
+                    const auto& S = s_ptr -> data;
+                    const auto& dY = result_ptr -> gradient;
+                    auto& dS = s_ptr -> gradient;
+
+                    for (size_t i = 0; i < size; ++i)
+                    {
+                        float d1, d2, d3;
+                        activationDerivatives(act, S[i], alpha, d1, d2, d3);
+
+                        dS[i] += dY[i] * d1 + dY[size + i] * d2 * S[size + i];
+                        dS[size + i] += dY[size + i] * d1;
+                    }
+                }, { s_ptr });
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost(6.0 * size, 4.0 * size * sizeof(float));
+            }
+
+            return result;
+        }
+
+        /// ∇_y L · ẏ for the loss on the value rows, with ∇_y L exactly as the loss' own backward computes it:
+        /// MSE 2 (y - t) / M, cross-entropy (softmax(y) - t) / M over all M entries.
+        std::shared_ptr<Tensor> tangentLoss(const std::shared_ptr<Tensor>& s, const std::shared_ptr<Tensor>& target, bool crossEntropy, int n)
+        {
+            ProfileScope scope("tangentLoss", "forward");
+
+            const size_t size = (size_t)n * s -> getShape()[1];
+            const float scale = 1.0f / (float)size;
+
+            if ((size_t)target -> getTotalSize() != size)
+                throw std::invalid_argument("hvp(): target has " + std::to_string(target -> getTotalSize()) + " values for "
+                    + std::to_string(size) + " outputs");
+
+            const auto& S = s -> getData();
+            const auto& T = target -> getData();
+
+            // ∂L/∂y; cross-entropy needs the softmax over all values, as crossEntropyLoss() takes it
+            std::vector<float> p;
+            if (crossEntropy)
+            {
+                p.assign(S.begin(), S.begin() + size);
+                float maxV = *std::max_element(p.begin(), p.end()), sum = 0.0f;
+                for (auto& value : p)
+                {
+                    value = std::exp(value - maxV);
+                    sum += value;
+                }
+                for (auto& value : p)
+                    value /= sum;
+            }
+
+            double dot = 0.0;
+            for (size_t i = 0; i < size; ++i)
+            {
+                float g = crossEntropy ? p[i] - T[i] : 2.0f * (S[i] - T[i]);
+                dot += (double)g * S[size + i];
+            }
+
+            auto result = std::make_shared<Tensor>(std::vector<int>{ 1 }, (float)(dot * scale), s -> requiresGradient);
+
+            if (s -> requiresGradient)
+            {
+                auto s_ptr = s;
+                auto t_ptr = target;
+                auto result_ptr = result;
+                result -> setGradientFunction([s_ptr, t_ptr, result_ptr, p, crossEntropy, size, scale, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("tangentLoss", "backward", layer);
+                    scope.setCost(6.0 * size, 5.0 * size * sizeof(float));
+
+                    const auto& S = s_ptr -> data;
+                    const auto& T = t_ptr -> data;
+                    auto& dS = s_ptr -> gradient;
+                    const float g = result_ptr -> gradient[0] * scale;
+
+                    if (crossEntropy)
+                    {
+                        // ∂/∂y_j Σ_i p_i ẏ_i = p_j (ẏ_j - p · ẏ)
+                        double pDot = 0.0;
+                        for (size_t i = 0; i < size; ++i)
+                            pDot += (double)p[i] * S[size + i];
+
+                        for (size_t i = 0; i < size; ++i)
+                        {
+                            dS[i] += g * p[i] * (S[size + i] - (float)pDot);
+                            dS[size + i] += g * (p[i] - T[i]);
+                        }
+                    }
+                    else
+                        for (size_t i = 0; i < size; ++i)
+                        {
+                            dS[i] += g * 2.0f * S[size + i];
+                            dS[size + i] += g * 2.0f * (S[i] - T[i]);
+                        }
+                }, { s_ptr });
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost(3.0 * size, 3.0 * size * sizeof(float));
+            }
+
+            return result;
+        }
+
+        using Directions = std::unordered_map<const Tensor*, std::shared_ptr<Tensor>>;
+
+        /// Makes every parameter require a gradient for the pass and puts flags and gradients back afterwards.
+        struct ParameterState
+        {
+            std::vector<std::shared_ptr<Tensor>> params;
+            std::vector<bool> flags;
+            std::vector<std::vector<float>> gradients;
+
+            explicit ParameterState(const std::vector<std::shared_ptr<Tensor>>& params) : params(params)
+            {
+                for (auto& p : params)
+                {
+                    flags.push_back(p -> requiresGradient);
+                    gradients.push_back(p -> gradient);
+                    p -> requiresGradient = true;
+                    p -> gradient.assign(p -> getTotalSize(), 0.0f);
+                }
+            }
+
+            ~ParameterState()
+            {
+                for (size_t i = 0; i < params.size(); ++i)
+                {
+                    params[i] -> requiresGradient = flags[i];
+                    params[i] -> gradient = std::move(gradients[i]);
+                }
+            }
+        };
+    }
+
+    std::shared_ptr<Tensor> jacobian(Sequential& model, const std::shared_ptr<Tensor>& inputs)
+    {
+        if (!gradientsEnabled())
+            throw std::runtime_error("jacobian(): gradients are disabled (NoGradGuard)");
+
+        const auto& shape = inputs -> getShape();
+        if (shape.empty() || shape[0] == 0)
+            throw std::invalid_argument("jacobian(): inputs need a non-empty batch axis");
+
+        const int n = shape[0];
+        const size_t inSize = (size_t)inputs -> getTotalSize() / n;
+        const auto& X = inputs -> getData();
+
+        // Output size per sample from one sample
+        size_t outSize;
+        {
+            NoGradGuard guard;
+
+            std::vector<int> sampleShape = shape;
+            sampleShape[0] = 1;
+            auto sample = std::make_shared<Tensor>(sampleShape, 0.0f, false);
+            std::copy(X.begin(), X.begin() + inSize, sample -> getData().begin());
+
+            outSize = model.forward(sample, false) -> getTotalSize();
+        }
+
+        // Replica o of the batch carries the seed of output o
+        std::vector<int> replicatedShape = shape;
+        replicatedShape[0] = (int)outSize * n;
+        auto replicated = std::make_shared<Tensor>(replicatedShape, 0.0f, true);
+        for (size_t o = 0; o < outSize; ++o)
+            std::copy(X.begin(), X.end(), replicated -> getData().begin() + o * n * inSize);
+
+        auto output = model.forward(replicated, false);
+        if ((size_t)output -> getTotalSize() != outSize * n * outSize)
+            throw std::invalid_argument("jacobian(): the model mixes samples of a batch");
+
+        std::vector<float> seed(output -> getTotalSize(), 0.0f);
+        for (size_t o = 0; o < outSize; ++o)
+            for (int i = 0; i < n; ++i)
+                seed[((o * n) + i) * outSize + o] = 1.0f;
+
+        output -> backwardTo(seed, { replicated });
+
+        auto result = std::make_shared<Tensor>(std::vector<int>{ n, (int)outSize, (int)inSize }, 0.0f, false);
+        const auto& G = replicated -> getGradient();
+        auto& J = result -> getData();
+
+        for (int i = 0; i < n; ++i)
+            for (size_t o = 0; o < outSize; ++o)
+                std::copy(G.begin() + (o * n + i) * inSize, G.begin() + (o * n + i + 1) * inSize, J.begin() + (i * outSize + o) * inSize);
+
+        return result;
+    }
+
+    std::vector<std::shared_ptr<Tensor>> hvp(const Sequential& model, const Loss& loss, const std::shared_ptr<Tensor>& input,
+        const std::shared_ptr<Tensor>& target, const std::vector<std::shared_ptr<Tensor>>& params, const std::vector<std::shared_ptr<Tensor>>& v)
+    {
+        if (!gradientsEnabled())
+            throw std::runtime_error("hvp(): gradients are disabled (NoGradGuard)");
+        if (params.size() != v.size())
+            throw std::invalid_argument("hvp(): " + std::to_string(params.size()) + " parameters but " + std::to_string(v.size()) + " directions");
+        if (input -> getShape().size() != 2)
+            throw std::invalid_argument("hvp(): input must be [samples, features]");
+
+        bool crossEntropy = dynamic_cast<const CrossEntropyLoss*>(&loss) != nullptr;
+        if (!crossEntropy && !dynamic_cast<const MSELoss*>(&loss))
+            throw std::invalid_argument("hvp(): only MSELoss and CrossEntropyLoss have a tangent rule");
+
+        auto stages = linearStages(model, "hvp()");
+
+        Directions directions;
+        for (size_t i = 0; i < params.size(); ++i)
+        {
+            if (params[i] -> getShape() != v[i] -> getShape())
+                throw std::invalid_argument("hvp(): direction " + std::to_string(i) + " doesn't match its parameter's shape");
+            directions[params[i].get()] = v[i];
+        }
+
+        ParameterState state(params);
+
+        // [value; tangent] rows; the input itself doesn't move along v
+        const int n = input -> getShape()[0], features = input -> getShape()[1];
+        auto s = std::make_shared<Tensor>(std::vector<int>{ 2 * n, features }, 0.0f, false);
+        std::copy(input -> getData().begin(), input -> getData().end(), s -> getData().begin());
+
+        auto direction = [&](const std::shared_ptr<Tensor>& parameter)
+        {
+            auto it = directions.find(parameter.get());
+            return it == directions.end() ? nullptr : it -> second;
+        };
+
+        for (auto& stage : stages)
+        {
+            if (stage.linear)
+                s = tangentLinear(s, stage.linear -> weights, stage.linear -> bias, direction(stage.linear -> weights), direction(stage.linear -> bias), n);
+            if (stage.activation != PlanActivation::None)
+                s = tangentActivation(s, stage.activation, stage.alpha, n);
+        }
+
+        auto directional = tangentLoss(s, target, crossEntropy, n);
+        directional -> backwardTo(params, false, false);
+
+        std::vector<std::shared_ptr<Tensor>> result;
+        for (auto& p : params)
+        {
+            auto hv = std::make_shared<Tensor>(p -> getShape(), 0.0f, false);
+            hv -> getData() = p -> gradient;
+            result.push_back(hv);
+        }
+
+        return result;
+    }
+}
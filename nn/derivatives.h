@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "sequential.h"
+#include "loss.h"
+#include "tensor.h"
+
+namespace SushiAI
+{
+    /// Input Jacobian of a Sequential for every sample: inputs [N, ...] → [N, O, I], where O and I are the
+    /// per-sample output and input sizes (J[n][o][i] = ∂y_no / ∂x_ni). The batch is replicated O times along
+    /// the first axis and run forward once in inference mode; one backward with a seed that is one-hot in
+    /// output o for replica o then yields every row of every sample's Jacobian, instead of O·N backward
+    /// passes over rebuilt graphs. Parameter gradients are not touched. Needs layers that treat the samples
+    /// of a batch independently (true of all of them outside training) and holds O copies of the activations.
+    std::shared_ptr<Tensor> jacobian(Sequential& model, const std::shared_ptr<Tensor>& inputs);
+
+    /// Hessian-vector product of loss(model(input), target) with respect to params, in direction v (one
+    /// tensor per parameter, same shapes). Reverse-over-forward: the forward pass carries alongside every
+    /// activation its directional derivative along v (for a Linear, u̇ = ẋ W + x V_W + V_b), the loss
+    /// turns that into ∇L · v, and one backward of that scalar into params gives H v exactly, for the whole
+    /// batch in one graph. Returns H v per parameter; the parameters' gradients are left as they were.
+    /// Supports Linear, ReLU, LeakyReLU, Sigmoid, Tanh, Dropout (identity) and nested Sequentials with
+    /// MSELoss or CrossEntropyLoss; throws std::invalid_argument otherwise.
+    std::vector<std::shared_ptr<Tensor>> hvp(const Sequential& model, const Loss& loss, const std::shared_ptr<Tensor>& input,
+        const std::shared_ptr<Tensor>& target, const std::vector<std::shared_ptr<Tensor>>& params, const std::vector<std::shared_ptr<Tensor>>& v);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cmath>
+#include "inference.h"
+
+/// Forward-mode helpers shared by jet.cpp and derivatives.cpp. Include it from .cpp files only.
+namespace SushiAI
+{
+    namespace detail
+    {
+        /// σ', σ'' and σ''' at u, for the forward-mode rules of jetForward() and hvp().
+        inline void activationDerivatives(PlanActivation act, float u, float alpha, float& d1, float& d2, float& d3)
+        {
+            switch (act)
+            {
+                case PlanActivation::ReLU:
+                    d1 = u > 0.0f ? 1.0f : 0.0f;
+                    d2 = d3 = 0.0f;
+                    break;
+                case PlanActivation::LeakyReLU:
+                    d1 = u > 0.0f ? 1.0f : alpha;
+                    d2 = d3 = 0.0f;
+                    break;
+                case PlanActivation::Sigmoid:
+                {
+                    float s = 1.0f / (1.0f + std::exp(-u));
+                    d1 = s * (1.0f - s);
+                    d2 = d1 * (1.0f - 2.0f * s);
+                    d3 = d2 * (1.0f - 2.0f * s) - 2.0f * d1 * d1;
+                    break;
+                }
+                case PlanActivation::Tanh:
+                {
+                    float t = std::tanh(u);
+                    d1 = 1.0f - t * t;
+                    d2 = -2.0f * t * d1;
+                    d3 = -2.0f * d1 * (d1 - 2.0f * t * t);
+                    break;
+                }
+                default:
+                    d1 = 1.0f;
+                    d2 = d3 = 0.0f;
+                    break;
+            }
+        }
+    }
+}
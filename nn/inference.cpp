@@ -0,0 +1,388 @@
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "inference.h"
+#include "backend.h"
+#include "normalization.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        const char* activationName(PlanActivation act)
+        {
+            switch (act)
+            {
+                case PlanActivation::ReLU:      return "ReLU";
+                case PlanActivation::LeakyReLU: return "LeakyReLU";
+                case PlanActivation::Sigmoid:   return "Sigmoid";
+                case PlanActivation::Tanh:      return "Tanh";
+                default:                        return "None";
+            }
+        }
+
+        /// In-place capable: y may alias x. Uses the same backend kernels as the activation ops.
+        void activate(const Backend& be, PlanActivation act, float alpha, const float* x, float* y, size_t n)
+        {
+            switch (act)
+            {
+                case PlanActivation::ReLU:      be.relu(x, y, n); break;
+                case PlanActivation::LeakyReLU: be.leakyRelu(x, y, n, alpha); break;
+                case PlanActivation::Sigmoid:   be.sigmoid(x, y, n); break;
+                case PlanActivation::Tanh:      be.tanh(x, y, n); break;
+                default:                        if (x != y) std::copy(x, x + n, y); break;
+            }
+        }
+
+        int elementCount(const std::vector<int>& shape)
+        {
+            int n = 1;
+            for (int d : shape)
+                n *= d;
+
+            return n;
+        }
+
+        /// Copies of linear's weights and bias with a preceding affine (x̂ · gamma + beta) multiplied in.
+        void foldAffine(const Linear& linear, const std::shared_ptr<Tensor>& gamma, const std::shared_ptr<Tensor>& beta,
+            std::shared_ptr<Tensor>& weights, std::shared_ptr<Tensor>& bias)
+        {
+            const int in = linear.weights -> getShape()[0], out = linear.weights -> getShape()[1];
+            const float* W = linear.weights -> data.data();
+            const float* g = gamma -> data.data();
+
+            weights = Tensor::Zeros({ in, out }, false);
+            bias = Tensor::Zeros({ out }, false);
+            bias -> data = linear.bias -> data;
+
+            for (int i = 0; i < in; ++i)
+                for (int j = 0; j < out; ++j)
+                {
+                    weights -> data[(size_t)i * out + j] = g[i] * W[(size_t)i * out + j];
+                    if (beta)
+                        bias -> data[j] += beta -> data[i] * W[(size_t)i * out + j];
+                }
+        }
+    }
+
+    bool asActivation(const std::shared_ptr<Layer>& layer, PlanActivation& act, float& alpha)
+    {
+        alpha = 0.0f;
+
+        if (std::dynamic_pointer_cast<ReLU>(layer))
+            act = PlanActivation::ReLU;
+        else if (auto leaky = std::dynamic_pointer_cast<LeakyReLU>(layer))
+        {
+            act = PlanActivation::LeakyReLU;
+            alpha = leaky -> alpha;
+        }
+        else if (std::dynamic_pointer_cast<Sigmoid>(layer))
+            act = PlanActivation::Sigmoid;
+        else if (std::dynamic_pointer_cast<Tanh>(layer))
+            act = PlanActivation::Tanh;
+        else
+            return false;
+
+        return true;
+    }
+
+    std::vector<LinearStage> linearStages(const Sequential& model, const std::string& caller)
+    {
+        std::vector<LinearStage> stages;
+
+        for (auto& layer : model.flattenedLayers())
+        {
+            if (std::dynamic_pointer_cast<Dropout>(layer))
+                continue;
+
+            if (auto linear = std::dynamic_pointer_cast<Linear>(layer))
+            {
+                LinearStage stage;
+                stage.linear = linear;
+                stages.push_back(stage);
+                continue;
+            }
+
+            PlanActivation act;
+            float alpha;
+            if (!asActivation(layer, act, alpha))
+                throw std::invalid_argument(caller + ": no rule for " + layer -> name());
+
+            // An activation closes the open stage, or starts a Linear-less one after another activation
+            if (stages.empty() || stages.back().activation != PlanActivation::None)
+                stages.push_back(LinearStage());
+
+            stages.back().activation = act;
+            stages.back().alpha = alpha;
+        }
+
+        return stages;
+    }
+
+    InferencePlan InferencePlan::compile(const Sequential& model, const std::vector<int>& inputShape, bool foldNormalization)
+    {
+        InferencePlan plan;
+        plan.inputShape = inputShape;
+
+        auto layers = model.flattenedLayers();
+
+        // 1) Shape inference + lowering to steps, fusing an activation into the Linear before it.
+        std::vector<int> shape = inputShape;
+        std::shared_ptr<Tensor> foldedWeights, foldedBias;     // Linear parameters with the previous norm's affine folded in
+        for (size_t i = 0; i < layers.size(); ++i)
+        {
+            auto& layer = layers[i];
+            PlanActivation act;
+            float alpha;
+
+            if (std::dynamic_pointer_cast<Dropout>(layer))
+                continue;
+
+            PlanStep step;
+            step.label = layer -> name();
+
+            if (auto linear = std::dynamic_pointer_cast<Linear>(layer))
+            {
+                int in = linear -> weights -> getShape()[0];
+                int out = linear -> weights -> getShape()[1];
+
+                if (shape.size() == 1)
+                    shape = { 1, shape[0] };
+
+                if (shape.size() != 2 || shape[1] != in)
+                    throw std::invalid_argument("InferencePlan: Linear expects [batch, " + std::to_string(in) + "] input");
+
+                step.kind = PlanStep::Kind::Linear;
+                step.rows = shape[0];
+                step.in = in;
+                step.out = out;
+                step.weights = foldedWeights ? foldedWeights : linear -> weights;
+                step.bias = foldedBias ? foldedBias : linear -> bias;
+                foldedWeights = foldedBias = nullptr;
+                shape = { shape[0], out };
+
+                if (i + 1 < layers.size() && asActivation(layers[i + 1], act, alpha))
+                {
+                    step.activation = act;
+                    step.alpha = alpha;
+                    step.label += " + " + layers[i + 1] -> name();
+                    ++i;
+                }
+            }
+            else if (asActivation(layer, act, alpha))
+            {
+                step.kind = PlanStep::Kind::Activation;
+                step.activation = act;
+                step.alpha = alpha;
+                step.rows = 1;
+                step.in = step.out = elementCount(shape);
+            }
+            else if (auto bn = std::dynamic_pointer_cast<BatchNorm>(layer))
+            {
+                if (shape.size() != 2 || shape[1] != bn -> getNumFeatures())
+                    throw std::invalid_argument("InferencePlan: BatchNorm expects [batch, " + std::to_string(bn -> getNumFeatures()) + "] input");
+
+                step.kind = PlanStep::Kind::BatchNorm;
+                step.rows = shape[0];
+                step.in = step.out = shape[1];
+                step.mean = bn -> getRunningMean();
+                step.variance = bn -> getRunningVar();
+                step.gamma = bn -> getGamma();
+                step.beta = bn -> getBeta();
+                step.eps = bn -> getEps();
+            }
+            else if (std::dynamic_pointer_cast<LayerNorm>(layer) || std::dynamic_pointer_cast<RMSNorm>(layer))
+            {
+                auto layerNorm = std::dynamic_pointer_cast<LayerNorm>(layer);
+                auto rmsNorm = std::dynamic_pointer_cast<RMSNorm>(layer);
+                int features = layerNorm ? layerNorm -> getNumFeatures() : rmsNorm -> getNumFeatures();
+
+                if (features < 1 || shape.empty() || shape.back() != features)
+                    throw std::invalid_argument("InferencePlan: " + layer -> name() + " expects [..., " + std::to_string(features) + "] input");
+
+                step.kind = PlanStep::Kind::Normalize;
+                step.centered = layerNorm != nullptr;
+                step.rows = elementCount(shape) / features;
+                step.in = step.out = features;
+                step.gamma = layerNorm ? layerNorm -> getGamma() : rmsNorm -> getGamma();
+                step.beta = layerNorm ? layerNorm -> getBeta() : nullptr;
+                step.eps = layerNorm ? layerNorm -> getEps() : rmsNorm -> getEps();
+
+                auto next = i + 1 < layers.size() ? std::dynamic_pointer_cast<Linear>(layers[i + 1]) : nullptr;
+                if (foldNormalization && next && shape.size() <= 2 && next -> weights -> getShape()[0] == features)
+                {
+                    foldAffine(*next, step.gamma, step.beta, foldedWeights, foldedBias);
+                    step.gamma = step.beta = nullptr;
+                    step.label += " (affine folded into " + next -> name() + ")";
+                }
+            }
+            else
+                throw std::invalid_argument("InferencePlan: unsupported layer " + layer -> name());
+
+            plan.steps.push_back(std::move(step));
+        }
+
+        plan.outputShape = shape;
+
+        if (plan.steps.empty())
+        {
+            PlanStep copy;
+            copy.kind = PlanStep::Kind::Copy;
+            copy.rows = 1;
+            copy.in = copy.out = elementCount(shape);
+            copy.label = "Copy";
+            plan.steps.push_back(copy);
+        }
+
+        // 2) Buffer assignment. Each intermediate is read only by the next step, so two buffers
+        //    suffice: Linear ping-pongs between them, elementwise steps overwrite their input.
+        size_t sizes[2] = { 0, 0 };
+        int current = PlanInput;
+
+        for (size_t i = 0; i < plan.steps.size(); ++i)
+        {
+            auto& step = plan.steps[i];
+            bool inPlace = step.kind != PlanStep::Kind::Linear;
+
+            step.source = current;
+
+            if (i + 1 == plan.steps.size())
+                step.destination = PlanOutput;
+            else if (inPlace && current >= 0)
+                step.destination = current;
+            else
+                step.destination = (current == 0) ? 1 : 0;
+
+            if (step.destination >= 0)
+                sizes[step.destination] = std::max(sizes[step.destination], (size_t)step.rows * step.out);
+
+            current = step.destination;
+        }
+
+        for (size_t size : sizes)
+            if (size > 0)
+                plan.buffers.emplace_back(size, 0.0f);
+
+        return plan;
+    }
+
+    void InferencePlan::run(const float* input, float* output)
+    {
+        const Backend& be = backend();
+
+        for (const auto& step : steps)
+        {
+            const float* x = step.source == PlanInput ? input : buffers[step.source].data();
+            float* y = step.destination == PlanOutput ? output : buffers[step.destination].data();
+
+            switch (step.kind)
+            {
+                case PlanStep::Kind::Linear:
+                {
+                    const float* W = step.weights -> data.data();
+                    const float* b = step.bias -> data.data();
+                    int in = step.in, out = step.out;
+
+                    size_t n = (size_t)step.rows * out;
+
+                    // Same kernels, in the same order, as matmul() followed by add() and the activation op.
+                    std::fill(y, y + n, 0.0f);
+                    be.gemm(false, false, step.rows, out, in, x, in, W, out, y, out);
+                    be.addRow(y, b, y, step.rows, out);
+
+                    if (step.activation != PlanActivation::None)
+                        activate(be, step.activation, step.alpha, y, y, n);
+                    break;
+                }
+                case PlanStep::Kind::Activation:
+                {
+                    activate(be, step.activation, step.alpha, x, y, step.out);
+                    break;
+                }
+                case PlanStep::Kind::BatchNorm:
+                {
+                    const float* mean = step.mean -> data.data();
+                    const float* var = step.variance -> data.data();
+                    const float* g = step.gamma -> data.data();
+                    const float* b = step.beta -> data.data();
+                    int F = step.in;
+
+                    for (int i = 0; i < step.rows; ++i)
+                    {
+                        for (int f = 0; f < F; ++f)
+                        {
+                            int idx = i * F + f;
+                            y[idx] = ((x[idx] - mean[f]) / std::sqrt(var[f] + step.eps)) * g[f] + b[f];
+                        }
+                    }
+                    break;
+                }
+                case PlanStep::Kind::Normalize:
+                {
+                    const float* g = step.gamma ? step.gamma -> data.data() : nullptr;
+                    const float* b = step.beta ? step.beta -> data.data() : nullptr;
+                    int F = step.in;
+
+                    for (int i = 0; i < step.rows; ++i)
+                    {
+                        const float* row = x + (size_t)i * F;
+                        float mean = 0.0f, rstd;
+
+                        if (step.centered)
+                            layerNormStatistics(row, F, step.eps, mean, rstd);
+                        else
+                            rstd = rmsNormStatistics(row, F, step.eps);
+
+                        normalizeRow(row, y + (size_t)i * F, F, mean, rstd, g, b);
+                    }
+                    break;
+                }
+                case PlanStep::Kind::Copy:
+                    std::copy(x, x + step.out, y);
+                    break;
+            }
+        }
+    }
+
+    void InferencePlan::run(const Tensor& input, Tensor& output)
+    {
+        if (input.getShape() != inputShape)
+            throw std::invalid_argument("InferencePlan::run(): input shape differs from the compiled shape");
+        if (output.getShape() != outputShape)
+            throw std::invalid_argument("InferencePlan::run(): output shape differs from the compiled shape");
+
+        run(input.data.data(), output.data.data());
+    }
+
+    size_t InferencePlan::workspaceBytes() const
+    {
+        size_t bytes = 0;
+        for (auto& b : buffers)
+            bytes += b.size() * sizeof(float);
+
+        return bytes;
+    }
+
+    void InferencePlan::printPlan() const
+    {
+        auto bufferName = [](int b)
+        {
+            if (b == PlanInput) return std::string("input");
+            if (b == PlanOutput) return std::string("output");
+            return "buffer" + std::to_string(b);
+        };
+
+        std::cout << "=== Inference Plan ===\n";
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            const auto& s = steps[i];
+            std::cout << "[" << i << "] " << s.label
+                << " | " << s.rows << "x" << s.in << " -> " << s.rows << "x" << s.out
+                << " | " << bufferName(s.source) << " -> " << bufferName(s.destination);
+            if (s.kind == PlanStep::Kind::Linear && s.activation != PlanActivation::None)
+                std::cout << " | fused " << activationName(s.activation);
+            std::cout << "\n";
+        }
+        std::cout << "=== Workspace: " << workspaceBytes() << " bytes in " << buffers.size() << " buffers ===\n";
+    }
+}
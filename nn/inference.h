@@ -0,0 +1,112 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include "sequential.h"
+#include "layer.h"
+#include "tensor.h"
+
+namespace SushiAI
+{
+    /// Activation applied in place by a plan step (fused into the step that produces the values).
+    enum class PlanActivation
+    {
+        None,
+        ReLU,
+        LeakyReLU,
+        Sigmoid,
+        Tanh
+    };
+
+    /// Scalar activations with the same expressions as the reference backend kernels.
+    inline float applyActivation(PlanActivation act, float x, float alpha)
+    {
+        switch (act)
+        {
+            case PlanActivation::ReLU:      return std::max(0.0f, x);
+            case PlanActivation::LeakyReLU: return x > 0.0f ? x : alpha * x;
+            case PlanActivation::Sigmoid:   return 1.0f / (1.0f + std::exp(-x));
+            case PlanActivation::Tanh:      return std::tanh(x);
+            default:                        return x;
+        }
+    }
+
+    /// Recognizes the activation layers, returns false for anything else.
+    bool asActivation(const std::shared_ptr<Layer>& layer, PlanActivation& act, float& alpha);
+
+    /// A Linear and the activation that follows it; linear is null for an activation with no Linear before it.
+    struct LinearStage
+    {
+        std::shared_ptr<Linear> linear;
+        PlanActivation activation = PlanActivation::None;
+        float alpha = 0.0f;
+    };
+
+    /// Splits a model (nested Sequentials flattened, Dropout dropped as the inference-mode identity) into
+    /// Linear(+activation) stages. Any other layer throws std::invalid_argument prefixed by caller.
+    std::vector<LinearStage> linearStages(const Sequential& model, const std::string& caller);
+
+    /// Where a plan step reads from or writes to.
+    enum PlanBuffer
+    {
+        PlanInput = -1,
+        PlanOutput = -2
+    };
+
+    struct PlanStep
+    {
+        enum class Kind { Linear, Activation, BatchNorm, Normalize, Copy };
+
+        Kind kind = Kind::Copy;
+        PlanActivation activation = PlanActivation::None;
+        float alpha = 0.0f;                 // LeakyReLU slope
+        int rows = 0, in = 0, out = 0;      // rows x in → rows x out (elementwise steps: in == out)
+        int source = PlanInput, destination = PlanOutput;
+
+        // Parameters stay owned by the layers; the plan reads them at run time.
+        std::shared_ptr<Tensor> weights, bias;
+        std::shared_ptr<Tensor> mean, variance, gamma, beta;
+        float eps = 0.0f;
+        bool centered = false;              // Normalize: LayerNorm (true) or RMSNorm (false)
+
+        std::string label;
+    };
+
+    /// Inference-only execution plan of a Sequential for a fixed input shape.
+    /// compile() infers every shape, fuses Linear with the activation that follows it, drops Dropout,
+    /// and assigns intermediates to a couple of reusable ping-pong buffers (activations are chained, so an
+    /// intermediate is dead as soon as the next step has consumed it; elementwise steps run in place).
+    /// run() then performs no heap allocation and reproduces Sequential::forward(input, false) bit for bit.
+    /// The plan reads the model's parameters in place, so it keeps tracking them through further training.
+    ///
+    /// foldNormalization (off by default) lets a LayerNorm/RMSNorm directly followed by a Linear only
+    /// normalize, with its gamma/beta folded into a copy of that Linear (W' = diag(gamma) W, b' = b + beta W).
+    /// That saves a pass over the activations, but the folded Linear is a snapshot taken at compile(): later
+    /// updates to it or to the norm are not seen until the plan is recompiled, and the results differ from
+    /// the eager path by rounding.
+    class InferencePlan
+    {
+        public:
+            static InferencePlan compile(const Sequential& model, const std::vector<int>& inputShape, bool foldNormalization = false);
+
+            /// input holds inputShape elements, output receives outputShape elements; they must not overlap.
+            void run(const float* input, float* output);
+            /// Shape-checked convenience overload. output must already have outputShape.
+            void run(const Tensor& input, Tensor& output);
+
+            const std::vector<int>& getInputShape() const { return inputShape; }
+            const std::vector<int>& getOutputShape() const { return outputShape; }
+            const std::vector<PlanStep>& getSteps() const { return steps; }
+            /// Bytes held by the intermediate buffers.
+            size_t workspaceBytes() const;
+
+            void printPlan() const;
+
+        private:
+            std::vector<int> inputShape, outputShape;
+            std::vector<PlanStep> steps;
+            std::vector<std::vector<float>> buffers;
+    };
+}
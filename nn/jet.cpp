@@ -0,0 +1,280 @@
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "jet.h"
+#include "inference.h"
+#include "derivativesdetail.h"
+#include "profiler.h"
+#include "backend.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using detail::activationDerivatives;
+
+        /// Stacked jet of the input itself: value rows x, first-derivative block k one-hot in column k,
+        /// second derivatives zero. The gradient of the value rows flows back into x.
+        std::shared_ptr<Tensor> jetSeed(const std::shared_ptr<Tensor>& x)
+        {
+            ProfileScope scope("jetSeed", "forward");
+
+            const int n = x -> getShape()[0], k = x -> getShape()[1];
+            const size_t size = (size_t)n * k;
+
+            auto result = std::make_shared<Tensor>(std::vector<int>{ (1 + 2 * k) * n, k }, 0.0f, x -> requiresGradient);
+            auto& S = result -> getData();
+
+            std::copy(x -> getData().begin(), x -> getData().end(), S.begin());
+            for (int d = 0; d < k; ++d)
+                for (int i = 0; i < n; ++i)
+                    S[size * (1 + d) + (size_t)i * k + d] = 1.0f;
+
+            if (x -> requiresGradient)
+            {
+                auto x_ptr = x;
+                auto result_ptr = result;
+                result -> setGradientFunction([x_ptr, result_ptr, size, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("jetSeed", "backward", layer);
+                    scope.setCost((double)size, 3.0 * size * sizeof(float));
+
+                    backend().accumulate(result_ptr -> gradient.data(), x_ptr -> gradient.data(), size);
+                }, { x_ptr });
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost(0.0, (double)S.size() * sizeof(float));
+            }
+
+            return result;
+        }
+
+        /// Linear layer on a stacked jet: one GEMM over every block, bias on the value rows only
+        /// (the derivative of a constant is zero).
+        std::shared_ptr<Tensor> jetLinear(const std::shared_ptr<Tensor>& s, const std::shared_ptr<Tensor>& w, const std::shared_ptr<Tensor>& b, int n)
+        {
+            ProfileScope scope("jetLinear", "forward");
+
+            const int rows = s -> getShape()[0];
+            const int in = w -> getShape()[0], out = w -> getShape()[1];
+
+            if (s -> getShape()[1] != in)
+                throw std::invalid_argument("jetForward(): Linear expects " + std::to_string(in) + " features, got " + std::to_string(s -> getShape()[1]));
+
+            auto result = std::make_shared<Tensor>(std::vector<int>{ rows, out }, 0.0f,
+                s -> requiresGradient || w -> requiresGradient || b -> requiresGradient);
+            auto& Y = result -> getData();
+
+            const Backend& be = backend();
+            be.gemm(false, false, rows, out, in, s -> data.data(), in, w -> data.data(), out, Y.data(), out);
+            be.addRow(Y.data(), b -> data.data(), Y.data(), n, out);
+
+            if (result -> requiresGradient)
+            {
+                auto s_ptr = s;
+                auto w_ptr = w;
+                auto b_ptr = b;
+                auto result_ptr = result;
+                result -> setGradientFunction([s_ptr, w_ptr, b_ptr, result_ptr, rows, in, out, n, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("jetLinear", "backward", layer);
+                    scope.setCost(4.0 * rows * in * out, (2.0 * rows * in + 2.0 * in * out + (double)rows * out) * sizeof(float));
+
+                    const auto& dY = result_ptr -> gradient;
+                    const Backend& be = backend();
+
+                    // dS = dY · W^T
+                    if (s_ptr -> requiresGradient)
+                        be.gemm(false, true, rows, in, out, dY.data(), out, w_ptr -> data.data(), out, s_ptr -> gradient.data(), in);
+
+                    // dW = S^T · dY over every block
+                    if (w_ptr -> requiresGradient)
+                        be.gemm(true, false, in, out, rows, s_ptr -> data.data(), in, dY.data(), out, w_ptr -> gradient.data(), out);
+
+                    // db only sees the value rows
+                    if (b_ptr -> requiresGradient)
+                        be.accumulateRows(dY.data(), b_ptr -> gradient.data(), n, out);
+                }, { s_ptr, w_ptr, b_ptr });
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost(2.0 * rows * in * out, ((double)rows * in + (double)in * out + (double)rows * out) * sizeof(float));
+            }
+
+            return result;
+        }
+
+        /// Elementwise activation on a stacked jet of K directions:
+        ///   y = σ(u),  y'_k = σ'(u) u'_k,  y''_k = σ''(u) u'_k² + σ'(u) u''_k.
+        /// Backward differentiates those through u, u' and u'' (σ''' for the second-order block).
+        std::shared_ptr<Tensor> jetActivation(const std::shared_ptr<Tensor>& s, PlanActivation act, float alpha, int n, int k)
+        {
+            ProfileScope scope("jetActivation", "forward");
+
+            const size_t size = (size_t)n * s -> getShape()[1];
+
+            auto result = std::make_shared<Tensor>(s -> getShape(), 0.0f, s -> requiresGradient);
+            const auto& S = s -> getData();
+            auto& Y = result -> getData();
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                float u = S[i], d1, d2, d3;
+                activationDerivatives(act, u, alpha, d1, d2, d3);
+                Y[i] = applyActivation(act, u, alpha);
+
+                for (int d = 0; d < k; ++d)
+                {
+                    size_t first = size * (1 + d) + i, second = size * (1 + k + d) + i;
+                    float du = S[first];
+
+                    Y[first] = d1 * du;
+                    Y[second] = d2 * du * du + d1 * S[second];
+                }
+            }
+
+            if (s -> requiresGradient)
+            {
+                auto s_ptr = s;
+                auto result_ptr = result;
+                result -> setGradientFunction([s_ptr, result_ptr, act, alpha, size, k, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("jetActivation", "backward", layer);
+                    scope.setCost(12.0 * size * k, 5.0 * size * (1 + 2 * k) * sizeof(float));
+
+                    const auto& S = s_ptr -> data;
+                    const auto& dY = result_ptr -> gradient;
+                    auto& dS = s_ptr -> gradient;
+
+                    for (size_t i = 0; i < size; ++i)
+                    {
+                        float d1, d2, d3;
+                        activationDerivatives(act, S[i], alpha, d1, d2, d3);
+
+                        float du = dY[i] * d1;
+                        for (int d = 0; d < k; ++d)
+                        {
+                            size_t first = size * (1 + d) + i, second = size * (1 + k + d) + i;
+                            float u1 = S[first], u2 = S[second];
+                            float g1 = dY[first], g2 = dY[second];
+
+                            du += g1 * d2 * u1 + g2 * (d3 * u1 * u1 + d2 * u2);
+                            dS[first] += g1 * d1 + 2.0f * g2 * d2 * u1;
+                            dS[second] += g2 * d1;
+                        }
+                        dS[i] += du;
+                    }
+                }, { s_ptr });
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost(8.0 * size * k, 2.0 * size * (1 + 2 * k) * sizeof(float));
+            }
+
+            return result;
+        }
+
+        /// Σ of `count` consecutive [N, F] blocks of a stacked jet starting at block `first`.
+        std::shared_ptr<Tensor> jetBlocks(const std::shared_ptr<Tensor>& s, int first, int count, int n)
+        {
+            ProfileScope scope("jetBlocks", "forward");
+
+            const int f = s -> getShape()[1];
+            const size_t size = (size_t)n * f;
+
+            auto result = std::make_shared<Tensor>(std::vector<int>{ n, f }, 0.0f, s -> requiresGradient);
+            auto& R = result -> getData();
+
+            const Backend& be = backend();
+            for (int c = 0; c < count; ++c)
+                be.accumulate(s -> data.data() + size * (first + c), R.data(), size);
+
+            if (s -> requiresGradient)
+            {
+                auto s_ptr = s;
+                auto result_ptr = result;
+                result -> setGradientFunction([s_ptr, result_ptr, first, count, size, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("jetBlocks", "backward", layer);
+                    scope.setCost((double)size * count, 3.0 * size * count * sizeof(float));
+
+                    const Backend& be = backend();
+                    for (int c = 0; c < count; ++c)
+                        be.accumulate(result_ptr -> gradient.data(), s_ptr -> gradient.data() + size * (first + c), size);
+                }, { s_ptr });
+            }
+
+            if (scope.active())
+            {
+                scope.setShape(result -> getShape());
+                scope.setCost((double)size * count, (count + 1.0) * size * sizeof(float));
+            }
+
+            return result;
+        }
+
+    }
+
+    Jet jetForward(const Sequential& model, const std::shared_ptr<Tensor>& input)
+    {
+        if (input -> getShape().size() != 2)
+            throw std::invalid_argument("jetForward(): input must be [samples, features]");
+
+        Jet jet;
+        jet.samples = input -> getShape()[0];
+        jet.directions = input -> getShape()[1];
+
+        auto stages = linearStages(model, "jetForward()");
+
+        jet.stacked = jetSeed(input);
+        for (auto& stage : stages)
+        {
+            if (stage.linear)
+                jet.stacked = jetLinear(jet.stacked, stage.linear -> weights, stage.linear -> bias, jet.samples);
+            if (stage.activation != PlanActivation::None)
+                jet.stacked = jetActivation(jet.stacked, stage.activation, stage.alpha, jet.samples, jet.directions);
+        }
+        jet.features = jet.stacked -> getShape()[1];
+
+        return jet;
+    }
+
+    std::shared_ptr<Tensor> Jet::block(int index) const
+    {
+        return jetBlocks(stacked, index, 1, samples);
+    }
+
+    std::shared_ptr<Tensor> Jet::value() const
+    {
+        return block(0);
+    }
+
+    std::shared_ptr<Tensor> Jet::derivative(int k) const
+    {
+        if (k < 0 || k >= directions)
+            throw std::out_of_range("Jet::derivative(): direction " + std::to_string(k) + " of " + std::to_string(directions));
+
+        return block(1 + k);
+    }
+
+    std::shared_ptr<Tensor> Jet::secondDerivative(int k) const
+    {
+        if (k < 0 || k >= directions)
+            throw std::out_of_range("Jet::secondDerivative(): direction " + std::to_string(k) + " of " + std::to_string(directions));
+
+        return block(1 + directions + k);
+    }
+
+    std::shared_ptr<Tensor> Jet::laplacian() const
+    {
+        return jetBlocks(stacked, 1 + directions, directions, samples);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "sequential.h"
+#include "tensor.h"
+
+namespace SushiAI
+{
+    /// Output of a Sequential together with its first and pure second derivatives with respect to every input
+    /// coordinate, as produced by jetForward(). All blocks live in one stacked tensor of (1 + 2K)·N rows:
+    /// the value rows, then ∂y/∂x_k for k = 0..K-1, then ∂²y/∂x_k². The accessors below are autograd ops on
+    /// it, so a PDE residual built from them back-propagates into the model parameters.
+    struct Jet
+    {
+        std::shared_ptr<Tensor> stacked;    // [(1 + 2K) * N, F]
+        int samples = 0;                    // N
+        int directions = 0;                 // K = input features
+        int features = 0;                   // F = output features
+
+        /// y: [N, F]
+        std::shared_ptr<Tensor> value() const;
+        /// ∂y/∂x_k: [N, F]
+        std::shared_ptr<Tensor> derivative(int k) const;
+        /// ∂²y/∂x_k²: [N, F]
+        std::shared_ptr<Tensor> secondDerivative(int k) const;
+        /// Δy = Σ_k ∂²y/∂x_k²: [N, F]
+        std::shared_ptr<Tensor> laplacian() const;
+        /// Block `index` of stacked: [N, F]
+        std::shared_ptr<Tensor> block(int index) const;
+    };
+
+    /// Taylor-mode (second-order forward) evaluation of model at input [N, K]: along each input axis e_k it
+    /// pushes the truncated series x + t·e_k through every layer, so values, gradients and the diagonal of
+    /// the input Hessian come out of a single pass. A Linear layer is one GEMM over all (1 + 2K)·N rows
+    /// with the bias added to the value rows only; an activation σ maps (u, u', u'') to
+    /// (σ(u), σ'(u)·u', σ''(u)·u'² + σ'(u)·u''). That is linear in K, where nested reverse mode would need
+    /// a backward pass per input coordinate and per sample.
+    /// Layers run in inference mode (Dropout is the identity). Supports Linear, ReLU, LeakyReLU, Sigmoid,
+    /// Tanh and nested Sequentials; throws std::invalid_argument for anything else. Values and derivatives
+    /// stay in fp32 under autocast, second derivatives don't survive 16-bit rounding.
+    Jet jetForward(const Sequential& model, const std::shared_ptr<Tensor>& input);
+}
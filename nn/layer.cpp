@@ -1,4 +1,6 @@
 ﻿#include <random>
+#include <string>
+#include <stdexcept>
 #include "layer.h"
 #include "ops.h"
 
@@ -14,6 +16,12 @@ namespace SushiAI
         biasInit -> initialize(bias);
     }
 
+    Linear::Linear(std::shared_ptr<Tensor> weightTensor, std::shared_ptr<Tensor> biasTensor) : weights(std::move(weightTensor)), bias(std::move(biasTensor))
+    {
+        if (!weights || !bias || weights -> getShape().size() != 2 || bias -> getShape() != std::vector<int>{ weights -> getShape()[1] })
+            throw std::invalid_argument("Linear: expected weights [in, out] and bias [out]");
+    }
+
     std::shared_ptr<Tensor> Linear::forward(const std::shared_ptr<Tensor>& input, bool training)
     {
         if (input -> getShape().size() == 1)
@@ -40,4 +48,175 @@ namespace SushiAI
 
         return add(out, bias);
     }
-}
\ No newline at end of file
+
+    Conv2d::Conv2d(int inChannels, int outChannels, int kernelSize, std::shared_ptr<Initializer> weightInitializer, std::shared_ptr<Initializer> biasInitializer,
+        int stride, int padding, int dilation, int groups) : weightInit(std::move(weightInitializer)), biasInit(std::move(biasInitializer)), stride(stride), padding(padding), dilation(dilation), groups(groups)
+    {
+        if (groups < 1 || inChannels % groups != 0 || outChannels % groups != 0)
+            throw std::invalid_argument("Conv2d: " + std::to_string(inChannels) + " -> " + std::to_string(outChannels) + " channels do not split into " + std::to_string(groups) + " groups");
+
+        weights = Tensor::Zeros({ outChannels, inChannels / groups, kernelSize, kernelSize }, true);
+        bias = Tensor::Zeros({ outChannels }, true);
+
+        weightInit -> initialize(weights);
+        biasInit -> initialize(bias);
+    }
+
+    std::shared_ptr<Tensor> Conv2d::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        return conv2d(input, weights, bias, stride, padding, dilation, groups);
+    }
+
+    std::string Conv2d::name() const
+    {
+        const auto& shape = weights -> getShape();
+        std::string text = "Conv2d(" + std::to_string(shape[1] * groups) + ", " + std::to_string(shape[0]) + ", k=" + std::to_string(shape[2]);
+
+        if (stride != 1)
+            text += ", s=" + std::to_string(stride);
+        if (padding != 0)
+            text += ", p=" + std::to_string(padding);
+        if (dilation != 1)
+            text += ", d=" + std::to_string(dilation);
+        if (groups != 1)
+            text += ", g=" + std::to_string(groups);
+
+        return text + ")";
+    }
+
+    Embedding::Embedding(int vocabSize, int dim, std::shared_ptr<Initializer> weightInitializer, bool sparseGradient) : weightInit(std::move(weightInitializer))
+    {
+        weights = Tensor::Zeros({ vocabSize, dim }, true);
+        weightInit -> initialize(weights);
+
+        if (sparseGradient)
+            weights -> useSparseGradient(true);
+    }
+
+    std::shared_ptr<Tensor> Embedding::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        return embedding(weights, input);
+    }
+
+    std::string Embedding::name() const
+    {
+        return "Embedding(" + std::to_string(weights -> getShape()[0]) + ", " + std::to_string(weights -> getShape()[1]) + (weights -> gradientIsSparse ? ", sparse)" : ")");
+    }
+
+    MultiHeadAttention::MultiHeadAttention(int embedDim, int numHeads, std::shared_ptr<Initializer> weightInitializer, std::shared_ptr<Initializer> biasInitializer, bool causal)
+        : weightInit(std::move(weightInitializer)), biasInit(std::move(biasInitializer)), numHeads(numHeads), causal(causal)
+    {
+        if (numHeads < 1 || embedDim % numHeads != 0)
+            throw std::invalid_argument("MultiHeadAttention: embedding size " + std::to_string(embedDim) + " is not divisible into " + std::to_string(numHeads) + " heads");
+
+        for (auto* w : { &queryWeights, &keyWeights, &valueWeights, &outputWeights })
+        {
+            *w = Tensor::Zeros({ embedDim, embedDim }, true);
+            weightInit -> initialize(*w);
+        }
+
+        for (auto* b : { &queryBias, &keyBias, &valueBias, &outputBias })
+        {
+            *b = Tensor::Zeros({ embedDim }, true);
+            biasInit -> initialize(*b);
+        }
+    }
+
+    std::shared_ptr<Tensor> MultiHeadAttention::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        const auto& shape = input -> getShape();
+        const int embedDim = queryWeights -> getShape()[0];
+
+        if (shape.size() != 3 || shape[2] != embedDim)
+            throw std::invalid_argument("MultiHeadAttention: expected input [batch, seq, " + std::to_string(embedDim) + "]");
+
+        // The projections run as one [batch·seq, E] GEMM each, straight on the [batch, seq, E] tensors (no
+        // reshape copies); the heads are column ranges of their outputs
+        auto project = [&](const std::shared_ptr<Tensor>& w, const std::shared_ptr<Tensor>& b)
+        {
+            return add(matmul(input, w), b);
+        };
+
+        auto attended = scaledDotProductAttention(project(queryWeights, queryBias), project(keyWeights, keyBias), project(valueWeights, valueBias), numHeads, causal);
+
+        return add(matmul(attended, outputWeights), outputBias);
+    }
+
+    std::string MultiHeadAttention::name() const
+    {
+        return "MultiHeadAttention(" + std::to_string(queryWeights -> getShape()[0]) + ", heads=" + std::to_string(numHeads) + (causal ? ", causal)" : ")");
+    }
+
+    LSTM::LSTM(int inputSize, int hiddenSize, std::shared_ptr<Initializer> weightInitializer, std::shared_ptr<Initializer> biasInitializer)
+        : weightInit(std::move(weightInitializer)), biasInit(std::move(biasInitializer))
+    {
+        inputWeights = Tensor::Zeros({ inputSize, 4 * hiddenSize }, true);
+        recurrentWeights = Tensor::Zeros({ hiddenSize, 4 * hiddenSize }, true);
+        bias = Tensor::Zeros({ 4 * hiddenSize }, true);
+
+        weightInit -> initialize(inputWeights);
+        weightInit -> initialize(recurrentWeights);
+        biasInit -> initialize(bias);
+    }
+
+    std::shared_ptr<Tensor> LSTM::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        return lstm(input, inputWeights, recurrentWeights, bias);
+    }
+
+    std::string LSTM::name() const
+    {
+        return "LSTM(" + std::to_string(inputWeights -> getShape()[0]) + ", " + std::to_string(recurrentWeights -> getShape()[0]) + ")";
+    }
+
+    GRU::GRU(int inputSize, int hiddenSize, std::shared_ptr<Initializer> weightInitializer, std::shared_ptr<Initializer> biasInitializer)
+        : weightInit(std::move(weightInitializer)), biasInit(std::move(biasInitializer))
+    {
+        inputWeights = Tensor::Zeros({ inputSize, 3 * hiddenSize }, true);
+        recurrentWeights = Tensor::Zeros({ hiddenSize, 3 * hiddenSize }, true);
+        inputBias = Tensor::Zeros({ 3 * hiddenSize }, true);
+        recurrentBias = Tensor::Zeros({ 3 * hiddenSize }, true);
+
+        weightInit -> initialize(inputWeights);
+        weightInit -> initialize(recurrentWeights);
+        biasInit -> initialize(inputBias);
+        biasInit -> initialize(recurrentBias);
+    }
+
+    std::shared_ptr<Tensor> GRU::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        return gru(input, inputWeights, recurrentWeights, inputBias, recurrentBias);
+    }
+
+    std::string GRU::name() const
+    {
+        return "GRU(" + std::to_string(inputWeights -> getShape()[0]) + ", " + std::to_string(recurrentWeights -> getShape()[0]) + ")";
+    }
+
+    LayerNorm::LayerNorm(int features, float eps) : numFeatures(features), eps(eps)
+    {
+        gamma = Tensor::Ones({ features }, true);
+        beta = Tensor::Zeros({ features }, true);
+    }
+
+    std::shared_ptr<Tensor> LayerNorm::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        if (input -> getShape().empty() || input -> getShape().back() != numFeatures)
+            throw std::invalid_argument("LayerNorm: expected input [..., " + std::to_string(numFeatures) + "]");
+
+        return layerNorm(input, gamma, beta, eps);
+    }
+
+    RMSNorm::RMSNorm(int features, float eps) : numFeatures(features), eps(eps)
+    {
+        gamma = Tensor::Ones({ features }, true);
+    }
+
+    std::shared_ptr<Tensor> RMSNorm::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        if (input -> getShape().empty() || input -> getShape().back() != numFeatures)
+            throw std::invalid_argument("RMSNorm: expected input [..., " + std::to_string(numFeatures) + "]");
+
+        return rmsNorm(input, gamma, eps);
+    }
+}
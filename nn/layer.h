@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <random>
+#include <algorithm>
 #include "initializer.h"
 #include "tensor.h"
 #include "ops.h"
@@ -22,6 +23,29 @@ namespace SushiAI
             virtual std::vector<std::shared_ptr<Tensor>> parameters() const { return {}; }
 
             virtual void resetState() {}
+
+            /// Frozen parameters stop requiring gradients: backward prunes the branches that only lead to them
+            /// and optimizers skip them. Graphs recorded before the call are pruned at their next backward().
+            /// Their gradients are zeroed, since backward() no longer clears them.
+            void freeze()
+            {
+                for (auto& p : parameters())
+                {
+                    p -> requiresGradient = false;
+                    std::fill(p -> gradient.begin(), p -> gradient.end(), 0.0f);
+                    p -> sparseGradient.clear();
+                }
+            }
+            void unfreeze() { for (auto& p : parameters()) p -> requiresGradient = true; }
+            /// True while any parameter still requires a gradient (false for parameterless layers).
+            bool isTrainable() const
+            {
+                for (auto& p : parameters())
+                    if (p -> requiresGradient)
+                        return true;
+
+                return false;
+            }
     };
 
     #pragma endregion
@@ -31,6 +55,9 @@ namespace SushiAI
     {
         public:
             Linear(int in_features, int out_features, std::shared_ptr<Initializer> weightInit, std::shared_ptr<Initializer> biasInit);
+            /// Wraps existing parameters, weights [in, out] and bias [out], e.g. ones computed by an export pass.
+            /// No initializer runs; weightInit and biasInit stay null.
+            Linear(std::shared_ptr<Tensor> weights, std::shared_ptr<Tensor> bias);
 
             std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
             std::string name() const override { return "Linear"; }
@@ -42,6 +69,100 @@ namespace SushiAI
             std::shared_ptr<Initializer> biasInit;
     };
 
+    // 2-D Convolution Layer (NCHW inputs: [batch, channels, height, width])
+    class Conv2d : public Layer
+    {
+        public:
+            Conv2d(int inChannels, int outChannels, int kernelSize, std::shared_ptr<Initializer> weightInit, std::shared_ptr<Initializer> biasInit,
+                int stride = 1, int padding = 0, int dilation = 1, int groups = 1);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override;
+            std::vector<std::shared_ptr<Tensor>> parameters() const override { return { weights, bias }; }
+
+            std::shared_ptr<Tensor> weights;            // [outChannels, inChannels / groups, kernelSize, kernelSize]
+            std::shared_ptr<Initializer> weightInit;
+            std::shared_ptr<Tensor> bias;               // [outChannels]
+            std::shared_ptr<Initializer> biasInit;
+
+            int stride, padding, dilation, groups;
+    };
+
+    // Embedding Layer: integer-valued indices [...] → rows of the table [..., dim]
+    class Embedding : public Layer
+    {
+        public:
+            /// With sparseGradient the table's gradient holds only the looked-up rows and SGD/Adam update
+            /// just those (lazily). Small vocabularies can keep the plain dense gradient instead.
+            Embedding(int vocabSize, int dim, std::shared_ptr<Initializer> weightInit, bool sparseGradient = true);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override;
+            std::vector<std::shared_ptr<Tensor>> parameters() const override { return { weights }; }
+
+            std::shared_ptr<Tensor> weights;            // [vocabSize, dim]
+            std::shared_ptr<Initializer> weightInit;
+    };
+
+    // Multi-Head Self-Attention: [batch, seq, embedDim] → [batch, seq, embedDim]
+    class MultiHeadAttention : public Layer
+    {
+        public:
+            /// Q, K, V and output projections around the fused attention kernel; causal lets position i attend
+            /// to positions ≤ i only.
+            MultiHeadAttention(int embedDim, int numHeads, std::shared_ptr<Initializer> weightInit, std::shared_ptr<Initializer> biasInit, bool causal = false);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override;
+            std::vector<std::shared_ptr<Tensor>> parameters() const override
+            {
+                return { queryWeights, queryBias, keyWeights, keyBias, valueWeights, valueBias, outputWeights, outputBias };
+            }
+
+            std::shared_ptr<Tensor> queryWeights, keyWeights, valueWeights, outputWeights;  // [embedDim, embedDim]
+            std::shared_ptr<Tensor> queryBias, keyBias, valueBias, outputBias;              // [embedDim]
+            std::shared_ptr<Initializer> weightInit;
+            std::shared_ptr<Initializer> biasInit;
+
+            int numHeads;
+            bool causal;
+    };
+
+    // LSTM Layer: [batch, steps, inputSize] → hidden states [batch, steps, hiddenSize], starting from zero state
+    class LSTM : public Layer
+    {
+        public:
+            LSTM(int inputSize, int hiddenSize, std::shared_ptr<Initializer> weightInit, std::shared_ptr<Initializer> biasInit);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override;
+            std::vector<std::shared_ptr<Tensor>> parameters() const override { return { inputWeights, recurrentWeights, bias }; }
+
+            std::shared_ptr<Tensor> inputWeights;       // [inputSize, 4 * hiddenSize], gates [i, f, g, o]
+            std::shared_ptr<Tensor> recurrentWeights;   // [hiddenSize, 4 * hiddenSize]
+            std::shared_ptr<Tensor> bias;               // [4 * hiddenSize]
+            std::shared_ptr<Initializer> weightInit;
+            std::shared_ptr<Initializer> biasInit;
+    };
+
+    // GRU Layer: [batch, steps, inputSize] → hidden states [batch, steps, hiddenSize], starting from zero state
+    class GRU : public Layer
+    {
+        public:
+            GRU(int inputSize, int hiddenSize, std::shared_ptr<Initializer> weightInit, std::shared_ptr<Initializer> biasInit);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override;
+            std::vector<std::shared_ptr<Tensor>> parameters() const override { return { inputWeights, recurrentWeights, inputBias, recurrentBias }; }
+
+            std::shared_ptr<Tensor> inputWeights;       // [inputSize, 3 * hiddenSize], gates [r, z, n]
+            std::shared_ptr<Tensor> recurrentWeights;   // [hiddenSize, 3 * hiddenSize]
+            std::shared_ptr<Tensor> inputBias;          // [3 * hiddenSize]
+            std::shared_ptr<Tensor> recurrentBias;      // [3 * hiddenSize]
+            std::shared_ptr<Initializer> weightInit;
+            std::shared_ptr<Initializer> biasInit;
+    };
+
     class ReLU : public Layer
     {
         public:
@@ -90,6 +211,67 @@ namespace SushiAI
             std::string name() const override { return "Tanh"; }
     };
 
+    #pragma region Pooling Layers
+
+    // Max Pooling Layer (NCHW inputs); the stride defaults to the kernel size
+    class MaxPool2d : public Layer
+    {
+        public:
+            int kernelSize, stride, padding;
+            MaxPool2d(int kernelSize, int stride = 0, int padding = 0) : kernelSize(kernelSize), stride(stride > 0 ? stride : kernelSize), padding(padding) {}
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override
+            {
+                return maxPool2d(input, kernelSize, stride, padding);
+            }
+
+            std::string name() const override { return "MaxPool2d(k=" + std::to_string(kernelSize) + ", s=" + std::to_string(stride) + ")"; }
+    };
+
+    // Average Pooling Layer (NCHW inputs); the stride defaults to the kernel size
+    class AvgPool2d : public Layer
+    {
+        public:
+            int kernelSize, stride, padding;
+            AvgPool2d(int kernelSize, int stride = 0, int padding = 0) : kernelSize(kernelSize), stride(stride > 0 ? stride : kernelSize), padding(padding) {}
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override
+            {
+                return avgPool2d(input, kernelSize, stride, padding);
+            }
+
+            std::string name() const override { return "AvgPool2d(k=" + std::to_string(kernelSize) + ", s=" + std::to_string(stride) + ")"; }
+    };
+
+    // Adaptive Average Pooling Layer: any [N, C, H, W] → [N, C, outH, outW]
+    class AdaptiveAvgPool2d : public Layer
+    {
+        public:
+            int outH, outW;
+            AdaptiveAvgPool2d(int outH, int outW) : outH(outH), outW(outW) {}
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override
+            {
+                return adaptiveAvgPool2d(input, outH, outW);
+            }
+
+            std::string name() const override { return "AdaptiveAvgPool2d(" + std::to_string(outH) + ", " + std::to_string(outW) + ")"; }
+    };
+
+    // Global Average Pooling Layer: [N, C, H, W] → [N, C]
+    class GlobalAvgPool2d : public Layer
+    {
+        public:
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override
+            {
+                return globalAvgPool2d(input);
+            }
+
+            std::string name() const override { return "GlobalAvgPool2d"; }
+    };
+
+    #pragma endregion
+
     #pragma region Regularization Layers
 
     // Dropout Layer
@@ -97,9 +279,10 @@ namespace SushiAI
     {
         private:
             float prob;
+            std::mt19937 generator;
 
         public:
-            Dropout(float p) : prob(p) {}
+            Dropout(float p) : prob(p), generator(std::random_device{}()) {}
 
             std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override 
             {
@@ -108,7 +291,6 @@ namespace SushiAI
                     
                 auto out = Tensor::Zeros(input -> getShape(), false);
 
-                std::mt19937 gen(std::random_device{}());
                 std::bernoulli_distribution dist(1.0f - prob);
 
                 auto& inData = input -> getData();
@@ -116,12 +298,15 @@ namespace SushiAI
 
                 float scale = 1.0f / (1.0f - prob);
                 for (size_t i = 0; i < inData.size(); ++i)
-                    outData[i] = dist(gen) ? inData[i] * scale : 0.0f;
+                    outData[i] = dist(generator) ? inData[i] * scale : 0.0f;
 
                 return out;
             }
 
             std::string name() const override { return "Dropout(p=" + std::to_string(prob) + ")"; }
+
+            /// Mask generator, seeded once per layer; copy it to replay or undo the masks of a forward.
+            std::mt19937& getGenerator() { return generator; }
     };
 
     // Batch Normalization Layer (for 2D inputs: [batch, features])
@@ -210,6 +395,13 @@ namespace SushiAI
             std::string name() const override { return "BatchNorm(" + std::to_string(numFeatures) + ")"; }
             std::vector<std::shared_ptr<Tensor>> parameters() const override { return { gamma, beta }; }
 
+            int getNumFeatures() const { return numFeatures; }
+            float getEps() const { return eps; }
+            const std::shared_ptr<Tensor>& getGamma() const { return gamma; }
+            const std::shared_ptr<Tensor>& getBeta() const { return beta; }
+            const std::shared_ptr<Tensor>& getRunningMean() const { return runningMean; }
+            const std::shared_ptr<Tensor>& getRunningVar() const { return runningVar; }
+
             void resetState() 
             {
                 std::fill(runningMean -> getData().begin(), runningMean -> getData().end(), 0.0f);
@@ -217,5 +409,46 @@ namespace SushiAI
             }
     };
 
+    // Layer Normalization: normalizes every sample over its last axis (any rank), then scales and shifts
+    class LayerNorm : public Layer
+    {
+        public:
+            LayerNorm(int features, float eps = 1e-5f);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override { return "LayerNorm(" + std::to_string(numFeatures) + ")"; }
+            std::vector<std::shared_ptr<Tensor>> parameters() const override { return { gamma, beta }; }
+
+            int getNumFeatures() const { return numFeatures; }
+            float getEps() const { return eps; }
+            const std::shared_ptr<Tensor>& getGamma() const { return gamma; }
+            const std::shared_ptr<Tensor>& getBeta() const { return beta; }
+
+        private:
+            int numFeatures;
+            float eps;
+            std::shared_ptr<Tensor> gamma, beta;
+    };
+
+    // RMS Normalization: divides every sample by the root mean square of its last axis, then scales (no centering, no shift)
+    class RMSNorm : public Layer
+    {
+        public:
+            RMSNorm(int features, float eps = 1e-5f);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override { return "RMSNorm(" + std::to_string(numFeatures) + ")"; }
+            std::vector<std::shared_ptr<Tensor>> parameters() const override { return { gamma }; }
+
+            int getNumFeatures() const { return numFeatures; }
+            float getEps() const { return eps; }
+            const std::shared_ptr<Tensor>& getGamma() const { return gamma; }
+
+        private:
+            int numFeatures;
+            float eps;
+            std::shared_ptr<Tensor> gamma;
+    };
+
     #pragma endregion
 } 
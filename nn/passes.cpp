@@ -0,0 +1,253 @@
+#include <cmath>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include "passes.h"
+#include "inference.h"
+#include "costmodel.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using Layers = std::vector<std::shared_ptr<Layer>>;
+
+        /// Layers that return their input unchanged in inference mode.
+        bool isIdentity(const std::shared_ptr<Layer>& layer)
+        {
+            if (std::dynamic_pointer_cast<Dropout>(layer))
+                return true;
+            if (auto pool = std::dynamic_pointer_cast<MaxPool2d>(layer))
+                return pool -> kernelSize == 1 && pool -> stride == 1 && pool -> padding == 0;
+            if (auto pool = std::dynamic_pointer_cast<AvgPool2d>(layer))
+                return pool -> kernelSize == 1 && pool -> stride == 1 && pool -> padding == 0;
+
+            return false;
+        }
+
+        /// A frozen Linear holding the given parameters.
+        std::shared_ptr<Linear> makeLinear(int in, int out, std::vector<float> weights, std::vector<float> bias)
+        {
+            auto W = std::make_shared<Tensor>(std::vector<int>{ in, out }, 0.0f, false);
+            auto b = std::make_shared<Tensor>(std::vector<int>{ out }, 0.0f, false);
+            W -> data = std::move(weights);
+            b -> data = std::move(bias);
+
+            return std::make_shared<Linear>(W, b);
+        }
+
+        /// Inference-mode BatchNorm as the per-feature affine x · scale + shift of its (constant) statistics.
+        void batchNormAffine(const BatchNorm& bn, std::vector<double>& scale, std::vector<double>& shift)
+        {
+            const auto& mean = bn.getRunningMean() -> data;
+            const auto& var = bn.getRunningVar() -> data;
+            const auto& gamma = bn.getGamma() -> data;
+            const auto& beta = bn.getBeta() -> data;
+
+            scale.resize(bn.getNumFeatures());
+            shift.resize(bn.getNumFeatures());
+            for (int f = 0; f < bn.getNumFeatures(); ++f)
+            {
+                scale[f] = gamma[f] / std::sqrt((double)var[f] + bn.getEps());
+                shift[f] = beta[f] - mean[f] * scale[f];
+            }
+        }
+
+        /// BatchNorm(Linear(x)) as one Linear: every output column j is scaled by gamma_j / √(var_j + eps).
+        std::shared_ptr<Linear> foldBatchNorm(const Linear& linear, const BatchNorm& bn)
+        {
+            const int in = linear.weights -> getShape()[0], out = linear.weights -> getShape()[1];
+            const auto& W = linear.weights -> data;
+            const auto& b = linear.bias -> data;
+
+            std::vector<double> scale, shift;
+            batchNormAffine(bn, scale, shift);
+
+            std::vector<float> weights(W.size()), bias(out);
+            for (int j = 0; j < out; ++j)
+            {
+                for (int i = 0; i < in; ++i)
+                    weights[(size_t)i * out + j] = (float)(W[(size_t)i * out + j] * scale[j]);
+                bias[j] = (float)(b[j] * scale[j] + shift[j]);
+            }
+
+            return makeLinear(in, out, std::move(weights), std::move(bias));
+        }
+
+        /// Linear(BatchNorm(x)) as one Linear: row i of W is scaled by the norm's scale_i, and its shift
+        /// passes through W into the bias.
+        std::shared_ptr<Linear> foldBatchNormInput(const BatchNorm& bn, const Linear& linear)
+        {
+            const int in = linear.weights -> getShape()[0], out = linear.weights -> getShape()[1];
+            const auto& W = linear.weights -> data;
+
+            std::vector<double> scale, shift;
+            batchNormAffine(bn, scale, shift);
+
+            std::vector<float> weights(W.size());
+            std::vector<double> bias(linear.bias -> data.begin(), linear.bias -> data.end());
+            for (int i = 0; i < in; ++i)
+                for (int j = 0; j < out; ++j)
+                {
+                    double w = W[(size_t)i * out + j];
+                    weights[(size_t)i * out + j] = (float)(w * scale[i]);
+                    bias[j] += shift[i] * w;
+                }
+
+            return makeLinear(in, out, std::move(weights), std::vector<float>(bias.begin(), bias.end()));
+        }
+
+        /// second(first(x)) as one Linear, accumulated in double.
+        std::shared_ptr<Linear> mergeLinears(const Linear& first, const Linear& second)
+        {
+            const int in = first.weights -> getShape()[0], mid = first.weights -> getShape()[1], out = second.weights -> getShape()[1];
+            const auto& W1 = first.weights -> data;
+            const auto& W2 = second.weights -> data;
+
+            std::vector<double> W((size_t)in * out, 0.0), b(second.bias -> data.begin(), second.bias -> data.end());
+            for (int i = 0; i < in; ++i)
+                for (int k = 0; k < mid; ++k)
+                {
+                    double w = W1[(size_t)i * mid + k];
+                    for (int j = 0; j < out; ++j)
+                        W[(size_t)i * out + j] += w * W2[(size_t)k * out + j];
+                }
+
+            for (int k = 0; k < mid; ++k)
+                for (int j = 0; j < out; ++j)
+                    b[j] += (double)first.bias -> data[k] * W2[(size_t)k * out + j];
+
+            return makeLinear(in, out, std::vector<float>(W.begin(), W.end()), std::vector<float>(b.begin(), b.end()));
+        }
+    }
+
+    std::shared_ptr<Sequential> optimizeForInference(const Sequential& model, const std::vector<std::shared_ptr<Tensor>>& samples, OptimizationReport* report)
+    {
+        OptimizationReport local;
+        OptimizationReport& r = report ? *report : local;
+        r = OptimizationReport();
+
+        Layers original = model.flattenedLayers();
+        r.layersBefore = original.size();
+
+        // 1-2) Flatten and drop identities
+        Layers layers;
+        for (auto& layer : original)
+        {
+            if (isIdentity(layer))
+                r.rewrites.push_back("drop " + layer -> name());
+            else
+                layers.push_back(layer);
+        }
+
+        // 3) Fold BatchNorm into the Linear before it, or else into the Linear right after it
+        Layers folded;
+        for (auto& layer : layers)
+        {
+            auto bn = std::dynamic_pointer_cast<BatchNorm>(layer);
+            auto linear = std::dynamic_pointer_cast<Linear>(layer);
+            auto previousLinear = folded.empty() ? nullptr : std::dynamic_pointer_cast<Linear>(folded.back());
+            auto previousNorm = folded.empty() ? nullptr : std::dynamic_pointer_cast<BatchNorm>(folded.back());
+
+            auto describe = [](const Linear& l)
+            {
+                return "Linear(" + std::to_string(l.weights -> getShape()[0]) + ", " + std::to_string(l.weights -> getShape()[1]) + ")";
+            };
+
+            if (bn && previousLinear && previousLinear -> weights -> getShape()[1] == bn -> getNumFeatures())
+            {
+                folded.back() = foldBatchNorm(*previousLinear, *bn);
+                r.rewrites.push_back("fold " + bn -> name() + " into the " + describe(*previousLinear) + " before it");
+            }
+            else if (linear && previousNorm && linear -> weights -> getShape()[0] == previousNorm -> getNumFeatures())
+            {
+                folded.back() = foldBatchNormInput(*previousNorm, *linear);
+                r.rewrites.push_back("fold " + previousNorm -> name() + " into the " + describe(*linear) + " after it");
+            }
+            else
+                folded.push_back(layer);
+        }
+
+        // 4) Merge adjacent Linears when that doesn't cost more
+        Layers merged;
+        for (auto& layer : folded)
+        {
+            auto linear = std::dynamic_pointer_cast<Linear>(layer);
+            auto previous = merged.empty() ? nullptr : std::dynamic_pointer_cast<Linear>(merged.back());
+
+            if (linear && previous)
+            {
+                double in = previous -> weights -> getShape()[0], mid = previous -> weights -> getShape()[1], out = linear -> weights -> getShape()[1];
+
+                if (in * out <= in * mid + mid * out)
+                {
+                    merged.back() = mergeLinears(*previous, *linear);
+                    r.rewrites.push_back("merge Linear(" + std::to_string((int)in) + ", " + std::to_string((int)mid) + ") + Linear("
+                        + std::to_string((int)mid) + ", " + std::to_string((int)out) + ")");
+                    continue;
+                }
+            }
+
+            merged.push_back(layer);
+        }
+
+        // 5) Linear + activation pairs left for the plan's fused epilogue
+        PlanActivation act;
+        float alpha;
+        for (size_t i = 0; i + 1 < merged.size(); ++i)
+            if (std::dynamic_pointer_cast<Linear>(merged[i]) && asActivation(merged[i + 1], act, alpha))
+                ++r.fusedActivations;
+
+        auto optimized = std::make_shared<Sequential>(merged);
+        r.layersAfter = merged.size();
+
+        Sequential reference(original);
+
+        if (!samples.empty())
+        {
+            MachinePeak unmeasured;     // FLOPs only, no need to time the machine
+            r.flopsBefore = analyzeCost(reference, samples[0] -> getShape(), false, false, &unmeasured).forwardFlops;
+            r.flopsAfter = analyzeCost(*optimized, samples[0] -> getShape(), false, false, &unmeasured).forwardFlops;
+        }
+
+        // Numeric equivalence against the original layers
+        NoGradGuard guard;
+
+        for (auto& sample : samples)
+        {
+            auto expected = reference.forward(sample, false);
+            auto actual = optimized -> forward(sample, false);
+
+            if (expected -> getShape() != actual -> getShape())
+                throw std::runtime_error("optimizeForInference(): optimized model changed the output shape");
+
+            for (size_t i = 0; i < expected -> data.size(); ++i)
+                r.maxAbsError = std::max(r.maxAbsError, std::fabs(expected -> data[i] - actual -> data[i]));
+            ++r.samplesChecked;
+        }
+
+        return optimized;
+    }
+
+    void OptimizationReport::print() const
+    {
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+
+        std::cout << "=== Inference Optimization ===\n";
+        for (auto& rewrite : rewrites)
+            std::cout << "  " << rewrite << "\n";
+        if (rewrites.empty())
+            std::cout << "  (nothing to rewrite)\n";
+
+        std::cout << "Layers          : " << layersBefore << " -> " << layersAfter << "\n"
+            << "Forward FLOPs   : " << std::fixed << std::setprecision(0) << flopsBefore << " -> " << flopsAfter
+            << " (" << std::setprecision(1) << (flopsBefore > 0.0 ? 100.0 * (1.0 - flopsAfter / flopsBefore) : 0.0) << "% fewer)\n"
+            << "Fused Linear+act: " << fusedActivations << " (at compile())\n"
+            << std::defaultfloat << std::setprecision(6)
+            << "Max abs error   : " << maxAbsError << " over " << samplesChecked << " samples\n";
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include "sequential.h"
+#include "layer.h"
+#include "tensor.h"
+
+namespace SushiAI
+{
+    /// What optimizeForInference() rewrote and what it bought.
+    struct OptimizationReport
+    {
+        std::vector<std::string> rewrites;  // one line per applied rewrite
+        size_t layersBefore = 0, layersAfter = 0;
+        double flopsBefore = 0.0;           // inference forward FLOPs at the first sample's shape (analyzeCost())
+        double flopsAfter = 0.0;
+        int fusedActivations = 0;           // Linear + activation pairs compile() runs as one step
+        float maxAbsError = 0.0f;           // against the original model over the samples
+        size_t samplesChecked = 0;
+
+        void print() const;
+    };
+
+    /// Inference-export pass pipeline over a Sequential. Returns a new model computing the same function in
+    /// inference mode:
+    ///   1) nested Sequentials are flattened;
+    ///   2) Dropout and 1x1 / stride 1 pools (identities outside training) are dropped;
+    ///   3) a BatchNorm is folded into the weights and bias of the Linear right before it, or else of the
+    ///      Linear right after it (its running statistics are constants in inference mode);
+    ///   4) adjacent Linears are merged into one (W = W1·W2, b = b1·W2 + b2) when in·out ≤ in·mid + mid·out,
+    ///      so bottlenecks are kept;
+    ///   5) the Linear + activation pairs left are counted; compile() fuses them into one step.
+    /// Rewritten Linears get new frozen weights, untouched layers are shared with the original.
+    /// There is no separate constant-folding pass: every layer of a Sequential consumes the previous layer's
+    /// output, so the only constants to fold ahead of time are the BatchNorm statistics (3) and the products
+    /// of adjacent weight matrices (4).
+    /// The samples check the rewrite numerically (and give the input shape for the FLOP count).
+    std::shared_ptr<Sequential> optimizeForInference(const Sequential& model, const std::vector<std::shared_ptr<Tensor>>& samples,
+        OptimizationReport* report = nullptr);
+}
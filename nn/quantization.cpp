@@ -0,0 +1,314 @@
+#include <cmath>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include "quantization.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace SushiAI
+{
+    namespace
+    {
+        /// Row length granularity of the int8 kernels (one 256-bit register of int8).
+        constexpr int QuantBlock = 32;
+
+        /// Sum of a[i] * b[i] over n int8 values (n is a multiple of QuantBlock, b within [-127, 127]).
+        inline int32_t dotInt8(const int8_t* a, const int8_t* b, int n)
+        {
+            #if defined(__AVX2__)
+            // maddubs/dpbusd need an unsigned operand: use |a| and move the sign of a onto b.
+            // |a| <= 128 and |b| <= 127 keep the pairwise int16 sums of maddubs from saturating.
+            __m256i acc = _mm256_setzero_si256();
+            #if !defined(__AVXVNNI__) && !(defined(__AVX512VNNI__) && defined(__AVX512VL__))
+            const __m256i ones = _mm256_set1_epi16(1);
+            #endif
+
+            for (int k = 0; k < n; k += QuantBlock)
+            {
+                __m256i va = _mm256_loadu_si256((const __m256i*)(a + k));
+                __m256i vb = _mm256_loadu_si256((const __m256i*)(b + k));
+                __m256i absA = _mm256_sign_epi8(va, va);
+                __m256i signedB = _mm256_sign_epi8(vb, va);
+
+                #if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+                acc = _mm256_dpbusd_epi32(acc, absA, signedB);
+                #elif defined(__AVXVNNI__)
+                acc = _mm256_dpbusd_avx_epi32(acc, absA, signedB);
+                #else
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(absA, signedB), ones));
+                #endif
+            }
+
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            return _mm_cvtsi128_si32(sum);
+            #else
+            int32_t acc = 0;
+            for (int k = 0; k < n; ++k)
+                acc += (int32_t)a[k] * (int32_t)b[k];
+
+            return acc;
+            #endif
+        }
+
+        inline int8_t quantizeValue(float x, float inverseScale)
+        {
+            float q = std::nearbyint(x * inverseScale);
+            return (int8_t)std::max(-127.0f, std::min(127.0f, q));
+        }
+
+        size_t layerWeightBytes(const Layer& layer)
+        {
+            if (auto q = dynamic_cast<const QuantizedLinear*>(&layer))
+                return q -> weightBytes();
+
+            if (auto seq = dynamic_cast<const Sequential*>(&layer))
+            {
+                size_t bytes = 0;
+                for (size_t i = 0; i < seq -> layersSize(); ++i)
+                    bytes += layerWeightBytes(*seq -> getLayer(i));
+                return bytes;
+            }
+
+            size_t bytes = 0;
+            for (auto& p : layer.parameters())
+                bytes += p -> getTotalSize() * sizeof(float);
+
+            return bytes;
+        }
+
+        std::shared_ptr<Tensor> observe(const Sequential& model, std::shared_ptr<Tensor> x, QuantizationCalibration& calibration)
+        {
+            for (size_t i = 0; i < model.layersSize(); ++i)
+            {
+                auto layer = model.getLayer(i);
+
+                if (auto nested = std::dynamic_pointer_cast<Sequential>(layer))
+                {
+                    x = observe(*nested, x, calibration);
+                    continue;
+                }
+
+                if (std::dynamic_pointer_cast<Linear>(layer))
+                {
+                    float& absMax = calibration.inputAbsMax[layer.get()];
+                    for (float v : x -> getData())
+                        absMax = std::max(absMax, std::fabs(v));
+                }
+
+                x = layer -> forward(x, false);
+            }
+
+            return x;
+        }
+    }
+
+    #pragma region Quantized Linear
+
+    QuantizedLinear::QuantizedLinear(const Linear& linear, PlanActivation activation, float alpha, float inputScale)
+        : inputScale(inputScale), activation(activation), alpha(alpha)
+    {
+        in = linear.weights -> getShape()[0];
+        out = linear.weights -> getShape()[1];
+        stride = (in + QuantBlock - 1) / QuantBlock * QuantBlock;
+
+        const auto& W = linear.weights -> getData();
+        weights.assign((size_t)out * stride, 0);
+        scales.assign(out, 1.0f);
+        bias = linear.bias -> getData();
+        rowBuffer.assign(stride, 0);
+
+        // Symmetric per-output-channel scales: the largest |w| of every column maps to 127.
+        for (int n = 0; n < out; ++n)
+        {
+            float absMax = 0.0f;
+            for (int k = 0; k < in; ++k)
+                absMax = std::max(absMax, std::fabs(W[k * out + n]));
+
+            if (absMax > 0.0f)
+                scales[n] = absMax / 127.0f;
+
+            float inverse = 1.0f / scales[n];
+            for (int k = 0; k < in; ++k)
+                weights[(size_t)n * stride + k] = quantizeValue(W[k * out + n], inverse);
+        }
+    }
+
+    std::string QuantizedLinear::name() const
+    {
+        return std::string("QuantizedLinear(int8, ") + (isDynamic() ? "dynamic" : "calibrated") + ")";
+    }
+
+    void QuantizedLinear::forward(const float* x, int rows, float* y)
+    {
+        for (int i = 0; i < rows; ++i)
+        {
+            const float* xRow = x + (size_t)i * in;
+            float* yRow = y + (size_t)i * out;
+
+            float rowScale = inputScale;
+            if (rowScale <= 0.0f)
+            {
+                float absMax = 0.0f;
+                for (int k = 0; k < in; ++k)
+                    absMax = std::max(absMax, std::fabs(xRow[k]));
+                rowScale = absMax > 0.0f ? absMax / 127.0f : 1.0f;
+            }
+
+            float inverse = 1.0f / rowScale;
+            for (int k = 0; k < in; ++k)
+                rowBuffer[k] = quantizeValue(xRow[k], inverse);
+
+            // int32 accumulate, then requantize + bias + activation in one pass
+            for (int n = 0; n < out; ++n)
+            {
+                int32_t acc = dotInt8(rowBuffer.data(), &weights[(size_t)n * stride], stride);
+                yRow[n] = applyActivation(activation, (float)acc * (rowScale * scales[n]) + bias[n], alpha);
+            }
+        }
+    }
+
+    std::shared_ptr<Tensor> QuantizedLinear::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        const auto& shape = input -> getShape();
+        int rows = shape.size() == 1 ? 1 : shape[0];
+
+        if (shape.empty() || shape.size() > 2 || shape.back() != in)
+            throw std::invalid_argument("QuantizedLinear: expected input of shape [batch, " + std::to_string(in) + "]");
+
+        auto result = std::make_shared<Tensor>(std::vector<int>{ rows, out }, 0.0f, false);
+        forward(input -> getData().data(), rows, result -> getData().data());
+
+        return result;
+    }
+
+    #pragma endregion
+
+    #pragma region Calibration and Conversion
+
+    QuantizationCalibration calibrate(const Sequential& model, const std::vector<std::shared_ptr<Tensor>>& samples)
+    {
+        QuantizationCalibration calibration;
+
+        for (auto& sample : samples)
+            observe(model, sample, calibration);
+
+        return calibration;
+    }
+
+    std::shared_ptr<Sequential> quantize(const Sequential& model, const QuantizationCalibration* calibration)
+    {
+        auto result = std::make_shared<Sequential>();
+
+        for (size_t i = 0; i < model.layersSize(); ++i)
+        {
+            auto layer = model.getLayer(i);
+
+            if (auto nested = std::dynamic_pointer_cast<Sequential>(layer))
+            {
+                result -> add(quantize(*nested, calibration));
+                continue;
+            }
+
+            auto linear = std::dynamic_pointer_cast<Linear>(layer);
+            if (!linear)
+            {
+                result -> add(layer);
+                continue;
+            }
+
+            PlanActivation act = PlanActivation::None;
+            float alpha = 0.0f;
+            if (i + 1 < model.layersSize() && asActivation(model.getLayer(i + 1), act, alpha))
+                ++i;
+
+            float scale = 0.0f;
+            if (calibration)
+            {
+                auto it = calibration -> inputAbsMax.find(linear.get());
+                if (it != calibration -> inputAbsMax.end() && it -> second > 0.0f)
+                    scale = it -> second / 127.0f;
+            }
+
+            result -> add(std::make_shared<QuantizedLinear>(*linear, act, alpha, scale));
+        }
+
+        return result;
+    }
+
+    QuantizationReport compareQuantized(Sequential& floatModel, Sequential& quantizedModel,
+        const std::vector<std::shared_ptr<Tensor>>& samples, int repeats)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        QuantizationReport report;
+        report.floatWeightBytes = layerWeightBytes(floatModel);
+        report.int8WeightBytes = layerWeightBytes(quantizedModel);
+
+        double errorSum = 0.0;
+        size_t count = 0;
+
+        for (auto& sample : samples)
+        {
+            auto reference = floatModel.forward(sample, false);
+            auto quantized = quantizedModel.forward(sample, false);
+
+            const auto& a = reference -> getData();
+            const auto& b = quantized -> getData();
+            if (a.size() != b.size())
+                throw std::runtime_error("compareQuantized(): models produce different output sizes");
+
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                float e = std::fabs(a[i] - b[i]);
+                report.maxAbsError = std::max(report.maxAbsError, e);
+                errorSum += e;
+            }
+            count += a.size();
+        }
+
+        report.meanAbsError = count ? (float)(errorSum / count) : 0.0f;
+
+        auto start = Clock::now();
+        for (int r = 0; r < repeats; ++r)
+            for (auto& sample : samples)
+                floatModel.forward(sample, false);
+        report.floatSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (int r = 0; r < repeats; ++r)
+            for (auto& sample : samples)
+                quantizedModel.forward(sample, false);
+        report.int8Seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        report.speedup = report.int8Seconds > 0.0 ? report.floatSeconds / report.int8Seconds : 0.0;
+
+        return report;
+    }
+
+    void QuantizationReport::print() const
+    {
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+
+        std::cout << "=== Int8 Quantization Report ===\n"
+            << "Max abs error   : " << maxAbsError << "\n"
+            << "Mean abs error  : " << meanAbsError << "\n"
+            << "Weights (float) : " << floatWeightBytes << " bytes\n"
+            << "Weights (int8)  : " << int8WeightBytes << " bytes ("
+            << std::fixed << std::setprecision(2) << (int8WeightBytes ? (double)floatWeightBytes / int8WeightBytes : 0.0) << "x smaller)\n"
+            << "Float time      : " << floatSeconds << " s\n"
+            << "Int8 time       : " << int8Seconds << " s (" << speedup << "x)\n";
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    #pragma endregion
+}
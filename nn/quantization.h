@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include "inference.h"
+#include "sequential.h"
+#include "layer.h"
+
+namespace SushiAI
+{
+    /// Inference-only int8 version of a Linear layer.
+    /// Weights are per-output-channel symmetric int8, activations are quantized per row either dynamically
+    /// (scale from each row's max |x|) or with a fixed calibrated scale. The int8 x int8 → int32 dot products
+    /// use AVX-VNNI / AVX2 (maddubs) when the build enables them and a scalar loop otherwise; requantization,
+    /// bias and the optional activation are fused into the epilogue. Output is float.
+    class QuantizedLinear : public Layer
+    {
+        public:
+            /// inputScale <= 0 selects dynamic activation quantization.
+            QuantizedLinear(const Linear& linear, PlanActivation activation = PlanActivation::None, float alpha = 0.0f, float inputScale = 0.0f);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override;
+
+            /// Raw kernel: x is [rows, in], y receives [rows, out].
+            void forward(const float* x, int rows, float* y);
+
+            size_t weightBytes() const { return weights.size() * sizeof(int8_t) + (scales.size() + bias.size()) * sizeof(float); }
+            bool isDynamic() const { return inputScale <= 0.0f; }
+
+        private:
+            int in, out, stride;            // stride: in rounded up to the SIMD width, zero padded
+            std::vector<int8_t> weights;    // [out][stride], transposed so every dot product is contiguous
+            std::vector<float> scales;      // [out] weight scale per output channel
+            std::vector<float> bias;
+            float inputScale;
+            PlanActivation activation;
+            float alpha;
+            std::vector<int8_t> rowBuffer;  // quantized input row
+    };
+
+    /// Max |x| seen at the input of every Linear, keyed by the layer.
+    struct QuantizationCalibration
+    {
+        std::unordered_map<const Layer*, float> inputAbsMax;
+    };
+
+    struct QuantizationReport
+    {
+        float maxAbsError = 0.0f;
+        float meanAbsError = 0.0f;
+        double floatSeconds = 0.0;
+        double int8Seconds = 0.0;
+        double speedup = 0.0;
+        size_t floatWeightBytes = 0;
+        size_t int8WeightBytes = 0;
+
+        void print() const;
+    };
+
+    /// Runs the samples through the model (inference mode) and records the input range of every Linear.
+    QuantizationCalibration calibrate(const Sequential& model, const std::vector<std::shared_ptr<Tensor>>& samples);
+
+    /// Returns a copy of the model with every Linear replaced by a QuantizedLinear, fusing the activation
+    /// that directly follows it. Without calibration, activations are quantized dynamically.
+    std::shared_ptr<Sequential> quantize(const Sequential& model, const QuantizationCalibration* calibration = nullptr);
+
+    /// Compares outputs and inference time of the float model and its quantized copy over the samples.
+    QuantizationReport compareQuantized(Sequential& floatModel, Sequential& quantizedModel,
+        const std::vector<std::shared_ptr<Tensor>>& samples, int repeats = 5);
+}
@@ -1,7 +1,99 @@
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
 #include "sequential.h"
+#include "inference.h"
+#include "costmodel.h"
+#include "profiler.h"
+#include "memorytracker.h"
 
 namespace SushiAI 
 {
+    namespace
+    {
+        /// Layers whose training forward can be replayed exactly, looking inside nested models.
+        bool recomputable(const std::shared_ptr<Layer>& layer)
+        {
+            if (auto nested = std::dynamic_pointer_cast<Sequential>(layer))
+            {
+                for (size_t i = 0; i < nested -> layersSize(); ++i)
+                    if (!recomputable(nested -> getLayer(i)))
+                        return false;
+
+                return true;
+            }
+
+            return !std::dynamic_pointer_cast<Dropout>(layer) && !std::dynamic_pointer_cast<BatchNorm>(layer);
+        }
+
+        size_t tensorBytes(const Tensor& t)
+        {
+            return (t.data.size() + t.gradient.size()) * sizeof(float);
+        }
+
+        /// Runs the segment without recording a graph and returns one node that recomputes it in backward.
+        /// The segment's parameters are listed as parents so backward() still clears their gradients.
+        std::shared_ptr<Tensor> checkpointSegment(const std::vector<std::shared_ptr<Layer>>& segment, const std::shared_ptr<Tensor>& input)
+        {
+            ProfileScope scope("checkpoint", "forward");
+
+            auto out = input;
+            {
+                NoGradGuard guard;
+                for (auto& layer : segment)
+                    out = layer -> forward(out, true);
+            }
+
+            bool requiresGrad = input -> requiresGradient;
+            std::vector<std::shared_ptr<Tensor>> parents = { input };
+            for (auto& layer : segment)
+                for (auto& p : layer -> parameters())
+                {
+                    requiresGrad = requiresGrad || p -> requiresGradient;
+                    parents.push_back(p);
+                }
+
+            auto result = std::make_shared<Tensor>(out -> getShape(), 0.0f, requiresGrad);
+            result -> getData() = out -> getData();
+            result -> dtype = out -> dtype;
+
+            if (requiresGrad)
+            {
+                auto input_ptr = input;
+                auto result_ptr = result;
+
+                result -> setGradientFunction([segment, input_ptr, result_ptr, layer = scope.getLayer()]()
+                {
+                    ProfileScope scope("checkpoint", "backward", layer);
+
+                    // Rerun the segment with the graph on, from a leaf copy of its input, and backpropagate through
+                    // it without clearing: the parameters accumulate like they would in the uncheckpointed graph.
+                    auto x = std::make_shared<Tensor>(input_ptr -> getShape(), 0.0f, input_ptr -> requiresGradient);
+                    x -> getData() = input_ptr -> getData();
+                    x -> dtype = input_ptr -> dtype;
+
+                    auto y = x;
+                    for (auto& l : segment)
+                        y = l -> forward(y, true);
+
+                    if (y -> requiresGradient)
+                        y -> backward(result_ptr -> gradient, false, false);
+
+                    if (input_ptr -> requiresGradient)
+                        for (size_t i = 0; i < x -> gradient.size(); ++i)
+                            input_ptr -> gradient[i] += x -> gradient[i];
+                }, parents);
+            }
+
+            if (scope.active())
+                scope.setShape(result -> getShape());
+
+            return result;
+        }
+    }
+
     Sequential::Sequential(const std::vector<std::shared_ptr<Layer>>& layers) : layers(layers) 
     {
 
@@ -22,10 +114,40 @@ namespace SushiAI
 
     std::shared_ptr<Tensor> Sequential::forward(const std::shared_ptr<Tensor>& input, bool training)
     {
+        if (training && !checkpoints.empty() && gradientsEnabled())
+            return forwardCheckpointed(input);
+
         auto out = input;
 
-        for (auto& layer : layers)
-            out = layer -> forward(out, training);
+        if (!Profiler::isEnabled() && !MemoryTracker::isEnabled())
+        {
+            for (auto& layer : layers)
+                out = layer -> forward(out, training);
+
+            return out;
+        }
+
+        // Profiled path: every layer becomes one "layer" event and tags the ops it runs and the tensors they allocate.
+        // Labels carry the owning model's path (the enclosing layer's label when nested, else "#<model>"), so
+        // models or nested Sequentials with the same layer at the same index stay apart.
+        int outerLayer = Profiler::currentLayer();
+        if (outerLayer < 0 && profileId == 0)
+        {
+            static std::atomic<int> models{ 0 };
+            profileId = ++models;
+        }
+
+        std::string path = outerLayer >= 0 ? Profiler::layerLabel(outerLayer) : "#" + std::to_string(profileId);
+
+        for (size_t i = 0; i < layers.size(); ++i)
+        {
+            int id = Profiler::internLayer(path + "/[" + std::to_string(i) + "] " + layers[i] -> name());
+            CurrentLayerGuard current(id);
+
+            ProfileScope scope(Profiler::layerLabel(id).c_str(), "layer", id);
+            out = layers[i] -> forward(out, training);
+            scope.setShape(out -> getShape());
+        }
 
         return out;
     }
@@ -42,4 +164,292 @@ namespace SushiAI
 
         return params;
     }
+
+    std::vector<std::shared_ptr<Layer>> Sequential::flattenedLayers() const
+    {
+        std::vector<std::shared_ptr<Layer>> flat;
+
+        for (auto& layer : layers)
+        {
+            if (auto nested = std::dynamic_pointer_cast<Sequential>(layer))
+            {
+                auto inner = nested -> flattenedLayers();
+                flat.insert(flat.end(), inner.begin(), inner.end());
+            }
+            else
+                flat.push_back(layer);
+        }
+
+        return flat;
+    }
+
+    std::shared_ptr<InferencePlan> Sequential::compile(const std::vector<int>& inputShape, bool foldNormalization) const
+    {
+        return std::make_shared<InferencePlan>(InferencePlan::compile(*this, inputShape, foldNormalization));
+    }
+
+    void Sequential::printSummary(const std::vector<int>& inputShape, bool training) const
+    {
+        analyzeCost(*this, inputShape, training).print();
+    }
+
+    #pragma region Training State Guard
+
+    TrainingStateGuard::TrainingStateGuard(const std::vector<std::shared_ptr<Layer>>& layers)
+    {
+        save(layers);
+    }
+
+    TrainingStateGuard::~TrainingStateGuard()
+    {
+        for (auto& [t, values] : statistics)
+            t -> getData() = values;
+        for (auto& [dropout, generator] : generators)
+            dropout -> getGenerator() = generator;
+    }
+
+    void TrainingStateGuard::save(const std::vector<std::shared_ptr<Layer>>& layers)
+    {
+        for (auto& layer : layers)
+        {
+            if (auto nested = std::dynamic_pointer_cast<Sequential>(layer))
+            {
+                std::vector<std::shared_ptr<Layer>> children;
+                for (size_t i = 0; i < nested -> layersSize(); ++i)
+                    children.push_back(nested -> getLayer(i));
+                save(children);
+            }
+            else if (auto bn = std::dynamic_pointer_cast<BatchNorm>(layer))
+            {
+                for (auto& t : { bn -> getRunningMean(), bn -> getRunningVar() })
+                    statistics.push_back({ t, t -> getData() });
+            }
+            else if (auto dropout = std::dynamic_pointer_cast<Dropout>(layer))
+                generators.push_back({ dropout, dropout -> getGenerator() });
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region Gradient Checkpointing
+
+    std::shared_ptr<Tensor> Sequential::forwardCheckpointed(const std::shared_ptr<Tensor>& input)
+    {
+        auto out = input;
+        size_t next = 0;
+
+        for (size_t i = 0; i < layers.size();)
+        {
+            if (next < checkpoints.size() && checkpoints[next].first == i)
+            {
+                auto [begin, end] = checkpoints[next++];
+                out = checkpointSegment({ layers.begin() + begin, layers.begin() + end }, out);
+                i = end;
+            }
+            else
+                out = layers[i++] -> forward(out, true);
+        }
+
+        return out;
+    }
+
+    void Sequential::setCheckpoints(const std::vector<std::pair<size_t, size_t>>& segments)
+    {
+        size_t previousEnd = 0;
+
+        for (auto [begin, end] : segments)
+        {
+            if (begin < previousEnd || begin >= end || end > layers.size())
+                throw std::invalid_argument("Sequential::setCheckpoints(): segments must be sorted, non-empty, disjoint and within the model");
+
+            for (size_t i = begin; i < end; ++i)
+                if (!recomputable(layers[i]))
+                    throw std::invalid_argument("Sequential::setCheckpoints(): " + layers[i] -> name() + " can't be recomputed inside a segment");
+
+            previousEnd = end;
+        }
+
+        checkpoints = segments;
+    }
+
+    CheckpointPlan Sequential::planCheckpoints(const std::shared_ptr<Tensor>& sampleInput, size_t budgetBytes)
+    {
+        const size_t n = layers.size();
+        CheckpointPlan plan;
+        plan.budget = budgetBytes;
+
+        // 1) Probe: per layer, the bytes of the graph nodes it adds (its activations) and of its output
+        std::vector<size_t> held(n, 0), output(n, 0);
+        std::vector<double> seconds(n, 0.0);
+
+        // The probe must leave the model as it found it: BatchNorm statistics and Dropout generators are
+        // restored on exit, and it starts from a detached copy of the input so the caller's graph is untouched
+        TrainingStateGuard state(layers);
+
+        auto probe = std::make_shared<Tensor>(sampleInput -> getShape(), 0.0f, sampleInput -> requiresGradient);
+        probe -> getData() = sampleInput -> getData();
+        probe -> dtype = sampleInput -> dtype;
+
+        std::unordered_set<const Tensor*> seen{ probe.get() };
+        for (auto& p : parameters())
+            seen.insert(p.get());
+
+        auto out = probe;
+        for (size_t i = 0; i < n; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            out = layers[i] -> forward(out, true);
+            seconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            for (auto* node : out -> topologicalSort())
+                if (seen.insert(node).second)
+                    held[i] += tensorBytes(*node);
+
+            output[i] = tensorBytes(*out);
+        }
+
+        // Break the probe graph's closures (they hold their own outputs)
+        for (auto* node : out -> topologicalSort())
+        {
+            node -> gradientFunction = nullptr;
+            node -> parents.clear();
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            plan.activationBytes += held[i];
+            plan.forwardSeconds += seconds[i];
+        }
+
+        // 2) Footprint of a segmentation: activations of the plain layers, the output of every segment, and
+        //    the activations of the largest segment while backward recomputes it
+        using Segments = std::vector<std::pair<size_t, size_t>>;
+        auto footprint = [&](const Segments& segments)
+        {
+            std::vector<bool> inside(n, false);
+            size_t bytes = 0, peak = 0;
+
+            for (auto [begin, end] : segments)
+            {
+                size_t segmentBytes = 0;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    inside[i] = true;
+                    segmentBytes += held[i];
+                }
+
+                bytes += output[end - 1];
+                peak = std::max(peak, segmentBytes);
+            }
+
+            for (size_t i = 0; i < n; ++i)
+                if (!inside[i])
+                    bytes += held[i];
+
+            return bytes + peak;
+        };
+
+        Segments best;
+        if (plan.activationBytes > budgetBytes)
+        {
+            // 3) Cut the recomputable runs greedily into segments of at most total / k bytes and keep the
+            //    smallest footprint over k (√n-style checkpointing lands near the minimum)
+            size_t bestBytes = plan.activationBytes;
+
+            for (size_t k = 2; k <= n; ++k)
+            {
+                size_t limit = plan.activationBytes / k;
+                Segments segments;
+                size_t begin = 0, bytes = 0;
+
+                for (size_t i = 0; i <= n; ++i)
+                {
+                    bool cut = i == n || !recomputable(layers[i]) || (i > begin && bytes + held[i] > limit);
+                    if (cut && i > begin)
+                    {
+                        segments.push_back({ begin, i });
+                        begin = i;
+                        bytes = 0;
+                    }
+
+                    if (i < n && !recomputable(layers[i]))
+                        begin = i + 1;
+                    else if (i < n)
+                        bytes += held[i];
+                }
+
+                size_t bytesNow = footprint(segments);
+                if (bytesNow < bestBytes)
+                {
+                    best = segments;
+                    bestBytes = bytesNow;
+                }
+            }
+
+            // 4) Hand budget headroom back: un-checkpoint the segments with the most recompute time per byte
+            //    saved while the footprint still fits
+            auto secondsPerByte = [&](const std::pair<size_t, size_t>& segment)
+            {
+                double time = 0.0;
+                size_t bytes = 0;
+                for (size_t i = segment.first; i < segment.second; ++i)
+                {
+                    time += seconds[i];
+                    bytes += held[i];
+                }
+
+                size_t saved = bytes > output[segment.second - 1] ? bytes - output[segment.second - 1] : 0;
+                return saved == 0 ? 1e300 : time / saved;
+            };
+
+            Segments order = best;
+            std::sort(order.begin(), order.end(), [&](auto& a, auto& b) { return secondsPerByte(a) > secondsPerByte(b); });
+
+            for (auto& segment : order)
+            {
+                Segments without;
+                for (auto& s : best)
+                    if (s != segment)
+                        without.push_back(s);
+
+                if (footprint(without) <= budgetBytes || secondsPerByte(segment) == 1e300)
+                    best = without;
+            }
+        }
+
+        plan.segments = best;
+        plan.checkpointedBytes = footprint(best);
+        for (auto [begin, end] : best)
+            for (size_t i = begin; i < end; ++i)
+                plan.recomputeSeconds += seconds[i];
+
+        setCheckpoints(best);
+
+        return plan;
+    }
+
+    void CheckpointPlan::print() const
+    {
+        auto kb = [](size_t bytes) { return bytes / 1024.0; };
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+        std::cout << std::fixed << std::setprecision(1);
+
+        std::cout << "=== Gradient Checkpointing ===\n";
+        std::cout << "Segments  : ";
+        if (segments.empty())
+            std::cout << "none";
+        for (auto [begin, end] : segments)
+            std::cout << "[" << begin << ", " << end << ") ";
+        std::cout << "\n";
+
+        std::cout << "Activation: " << kb(activationBytes) << " KiB -> " << kb(checkpointedBytes) << " KiB (budget " << kb(budget) << " KiB"
+            << (withinBudget() ? ")" : " - EXCEEDED)") << "\n";
+        std::cout << "Compute   : forward " << forwardSeconds * 1e3 << " ms, recompute in backward +" << recomputeSeconds * 1e3 << " ms\n";
+
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    #pragma endregion
 }
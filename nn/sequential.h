@@ -2,6 +2,7 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <utility>
 #include <iomanip> 
 #include <numeric>
 #include <iostream>
@@ -9,6 +10,41 @@
 
 namespace SushiAI 
 {
+    class InferencePlan;
+
+    /// Gradient checkpointing setup of a Sequential: the layer ranges that drop their activations during the
+    /// forward pass and are recomputed by backward(), and what that trades.
+    struct CheckpointPlan
+    {
+        std::vector<std::pair<size_t, size_t>> segments;    // [begin, end) layer indices
+        size_t activationBytes = 0;     // activations (data + gradient) held until backward without checkpointing
+        size_t checkpointedBytes = 0;   // held with the segments, plus the largest segment's recompute peak
+        size_t budget = 0;
+        double forwardSeconds = 0.0;    // one forward pass, as measured by the probe
+        double recomputeSeconds = 0.0;  // forward work every backward repeats
+
+        bool withinBudget() const { return checkpointedBytes <= budget; }
+        void print() const;
+    };
+
+    /// Saves the state a training-mode probe forward changes, the BatchNorm running statistics and Dropout mask
+    /// generators of the layers (through nested Sequentials), and puts it back when it goes out of scope.
+    class TrainingStateGuard
+    {
+        public:
+            explicit TrainingStateGuard(const std::vector<std::shared_ptr<Layer>>& layers);
+            ~TrainingStateGuard();
+
+            TrainingStateGuard(const TrainingStateGuard&) = delete;
+            TrainingStateGuard& operator=(const TrainingStateGuard&) = delete;
+
+        private:
+            std::vector<std::pair<std::shared_ptr<Tensor>, std::vector<float>>> statistics;
+            std::vector<std::pair<std::shared_ptr<Dropout>, std::mt19937>> generators;
+
+            void save(const std::vector<std::shared_ptr<Layer>>& layers);
+    };
+
     class Sequential : public Layer 
     {
         public:
@@ -18,9 +54,27 @@ namespace SushiAI
             std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
             std::string name() const override { return "Sequential"; }
             std::vector<std::shared_ptr<Tensor>> parameters() const override;
+            /// The layers in execution order with nested Sequentials expanded in place.
+            std::vector<std::shared_ptr<Layer>> flattenedLayers() const;
 
             void add(const std::shared_ptr<Layer>& layer);
             void remove(size_t index);
+
+            /// Compiles the model into an allocation-free inference plan for a fixed input shape. See
+            /// InferencePlan::compile() for foldNormalization, which trades exactness and live weights for speed.
+            std::shared_ptr<InferencePlan> compile(const std::vector<int>& inputShape, bool foldNormalization = false) const;
+
+            /// Gradient checkpointing for training forward passes: every [begin, end) range of layers keeps only
+            /// its output in the graph and is rerun from its input when backward() reaches it. Dropout and
+            /// BatchNorm can't be inside a range, nor inside a nested model in one (their masks / running statistics
+            /// would not replay).
+            void setCheckpoints(const std::vector<std::pair<size_t, size_t>>& segments);
+            /// Measures every layer's activation bytes and forward time with one probe forward on a detached copy
+            /// of sampleInput (BatchNorm statistics and Dropout generators are restored afterwards), then enables the segments that fit budgetBytes with the least recomputation (the smallest
+            /// footprint reachable if nothing fits).
+            CheckpointPlan planCheckpoints(const std::shared_ptr<Tensor>& sampleInput, size_t budgetBytes);
+            void clearCheckpoints() { checkpoints.clear(); }
+            const std::vector<std::pair<size_t, size_t>>& getCheckpoints() const { return checkpoints; }
             
 			size_t layersSize() const { return layers.size(); }
             std::shared_ptr<Layer> getLayer(size_t index) const
@@ -77,7 +131,15 @@ namespace SushiAI
                 std::cout << "=== Total trainable parameters: " << totalParams << " ===\n";
             }
 
+            /// Static analysis at a fixed input shape: per-layer output shapes, forward/backward FLOPs,
+            /// activation and parameter bytes, arithmetic intensity and estimated step time (see analyzeCost()).
+            void printSummary(const std::vector<int>& inputShape, bool training = true) const;
+
         private:
             std::vector<std::shared_ptr<Layer>> layers;
+            std::vector<std::pair<size_t, size_t>> checkpoints;
+            int profileId = 0;      // "#<id>" prefix of this model's profiler layer labels, assigned on its first top-level profiled forward
+
+            std::shared_ptr<Tensor> forwardCheckpointed(const std::shared_ptr<Tensor>& input);
     };
 }
@@ -0,0 +1,309 @@
+#pragma once
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include "inference.h"
+#include "sequential.h"
+#include "layer.h"
+#include "vectormath.h"
+
+namespace SushiAI
+{
+    #pragma region Activations
+
+    /// act(x) on one register, with the SIMD backend's exp / tanh / sigmoid inlined (libm calls would cost
+    /// more than a whole tiny layer, and scalar selects don't vectorize).
+    template <PlanActivation Act>
+    inline simd::vf staticActivation(simd::vf x, float alpha)
+    {
+        using namespace simd;
+
+        if constexpr (Act == PlanActivation::ReLU)
+            return vmax(x, vzero());
+        else if constexpr (Act == PlanActivation::LeakyReLU)
+            return vadd(vmax(x, vzero()), vmul(vset(alpha), vmin(x, vzero())));
+        else if constexpr (Act == PlanActivation::Sigmoid)
+            return vsigmoid(x);
+        else if constexpr (Act == PlanActivation::Tanh)
+            return vtanh(x);
+        else
+            return x;
+    }
+
+    /// v[i] = act(v[i]) in place.
+    template <PlanActivation Act>
+    inline void staticActivation(float* v, int n, float alpha)
+    {
+        if constexpr (Act != PlanActivation::None)
+            simd::mapUnary(v, v, n, [alpha](simd::vf x) { return staticActivation<Act>(x, alpha); });
+    }
+
+    #pragma endregion
+
+    #pragma region StaticLinear
+
+    /// Dense layer with compile-time sizes: y = act(x · W + b), loaded from a Linear's W [In, Out].
+    /// Everything lives inline, so a whole network is one flat object and the loops unroll completely.
+    /// Results match Sequential::forward to within a few ulp (vectorized activations, different summation order).
+    template <int In, int Out, PlanActivation Act = PlanActivation::None>
+    struct StaticLinear
+    {
+        static_assert(In > 0 && Out > 0, "StaticLinear: sizes must be positive");
+
+        static constexpr int InputSize = In;
+        static constexpr int OutputSize = Out;
+        static constexpr PlanActivation Activation = Act;
+
+        // forward() works output-major with every accumulator in a register. A layer at least one register wide
+        // takes its outputs Lanes at a time: each register holds Lanes dot products and every input adds
+        // x[i] · W[i, block] to it. A narrower layer takes one dot product per output, Lanes inputs at a time.
+        static constexpr int Lanes = simd::Lanes;
+        static constexpr bool Blocked = Out >= Lanes;
+        static constexpr int Blocks = (Out + Lanes - 1) / Lanes;
+        static constexpr int Chunks = (In + Lanes - 1) / Lanes;
+        static constexpr int MaxRegisters = 8;          // output registers per pass over the inputs
+
+        /// Position of W[i, j]: [block][In][Lanes] when Blocked, [Out][Chunks · Lanes] otherwise, zero padded.
+        static constexpr int index(int i, int j)
+        {
+            return Blocked ? ((j / Lanes) * In + i) * Lanes + j % Lanes : j * Chunks * Lanes + i;
+        }
+
+        std::array<float, Blocked ? Blocks * In * Lanes : Out * Chunks * Lanes> weights{};
+        std::array<float, Blocks * Lanes> bias{};
+        float alpha = 0.01f;            // LeakyReLU slope
+
+        void load(const LinearStage& stage)
+        {
+            const auto& shape = stage.linear -> weights -> getShape();
+            if (shape[0] != In || shape[1] != Out)
+                throw std::invalid_argument("StaticLinear: expected a Linear(" + std::to_string(In) + ", " + std::to_string(Out)
+                    + "), got Linear(" + std::to_string(shape[0]) + ", " + std::to_string(shape[1]) + ")");
+            if (stage.activation != Act)
+                throw std::invalid_argument("StaticLinear: activation after Linear(" + std::to_string(In) + ", " + std::to_string(Out) + ") differs from the template");
+
+            const float* w = stage.linear -> weights -> data.data();
+            for (int i = 0; i < In; ++i)
+                for (int j = 0; j < Out; ++j)
+                    weights[index(i, j)] = w[i * Out + j];
+
+            std::copy(stage.linear -> bias -> data.begin(), stage.linear -> bias -> data.end(), bias.begin());
+            alpha = stage.alpha;
+        }
+
+        /// One sample: x[In] → y[Out].
+        void forward(const float* x, float* y) const
+        {
+            if constexpr (Blocked)
+                forwardBlocks<0>(x, y);
+            else
+                forwardDots(x, y, std::make_index_sequence<Chunks>{});
+        }
+
+        /// Batch samples at once in feature-major layout: x[In][Batch] → y[Out][Batch]. The inner loop runs
+        /// across samples with the same weight, so it vectorizes without any horizontal reduction.
+        template <int Batch>
+        void forwardBatch(const float* x, float* y) const
+        {
+            for (int j = 0; j < Out; ++j)
+            {
+                float* yj = y + j * Batch;
+                for (int s = 0; s < Batch; ++s)
+                    yj[s] = bias[j];
+
+                for (int i = 0; i < In; ++i)
+                {
+                    const float w = weights[index(i, j)];
+                    const float* xi = x + i * Batch;
+                    for (int s = 0; s < Batch; ++s)
+                        yj[s] += xi[s] * w;
+                }
+
+                staticActivation<Act>(yj, Batch, alpha);
+            }
+        }
+
+        private:
+            /// Output registers First .. First + sizeof...(B) - 1, then the next group.
+            template <int First, size_t... B>
+            void forwardGroup(const float* x, float* y, std::index_sequence<B...>) const
+            {
+                using namespace simd;
+
+                vf acc[] = { vload(bias.data() + (First + B) * Lanes)... };
+                for (int i = 0; i < In; ++i)
+                {
+                    const vf xi = vset(x[i]);
+                    ((acc[B] = vfma(xi, vload(weights.data() + ((First + B) * In + i) * Lanes), acc[B])), ...);
+                }
+
+                ((acc[B] = staticActivation<Act>(acc[B], alpha)), ...);
+
+                if constexpr (Out % Lanes == 0)
+                    (vstore(y + (First + B) * Lanes, acc[B]), ...);
+                else
+                {
+                    constexpr int Count = std::min<int>(sizeof...(B) * Lanes, Out - First * Lanes);
+                    float out[sizeof...(B) * Lanes];
+                    (vstore(out + B * Lanes, acc[B]), ...);
+                    std::memcpy(y + First * Lanes, out, sizeof(float) * Count);
+                }
+            }
+
+            template <int First>
+            void forwardBlocks(const float* x, float* y) const
+            {
+                constexpr int Count = std::min(MaxRegisters, Blocks - First);
+                forwardGroup<First>(x, y, std::make_index_sequence<Count>{});
+                if constexpr (First + Count < Blocks)
+                    forwardBlocks<First + Count>(x, y);
+            }
+
+            template <size_t... C>
+            void forwardDots(const float* x, float* y, std::index_sequence<C...>) const
+            {
+                using namespace simd;
+
+                float xs[Chunks * Lanes] = {}, out[Lanes] = {};
+                std::memcpy(xs, x, sizeof(float) * In);
+
+                for (int j = 0; j < Out; ++j)
+                {
+                    const float* wj = weights.data() + j * Chunks * Lanes;
+                    vf acc = vzero();
+                    ((acc = vfma(vload(xs + C * Lanes), vload(wj + C * Lanes), acc)), ...);
+                    out[j] = vsum(acc) + bias[j];
+                }
+
+                vstore(out, staticActivation<Act>(vload(out), alpha));
+                std::memcpy(y, out, sizeof(float) * Out);
+            }
+    };
+
+    #pragma endregion
+
+    #pragma region StaticSequential
+
+    /// A chain of StaticLinear layers, checked at compile time, e.g. the 2→16→16→1 regressor:
+    ///
+    ///     StaticSequential<StaticLinear<2, 16>, StaticLinear<16, 16, PlanActivation::Tanh>, StaticLinear<16, 1>> net;
+    ///     net.load(*model);
+    ///     auto y = net.forward({ x1, x2 });
+    ///
+    /// Intermediates are stack arrays; nothing allocates after load().
+    template <typename... Layers>
+    class StaticSequential
+    {
+        static_assert(sizeof...(Layers) > 0, "StaticSequential: needs at least one layer");
+
+        private:
+            using LayerTuple = std::tuple<Layers...>;
+            static constexpr size_t Count = sizeof...(Layers);
+
+            template <size_t I>
+            using LayerAt = std::tuple_element_t<I, LayerTuple>;
+
+            static constexpr bool chained()
+            {
+                constexpr int outs[] = { Layers::OutputSize... };
+                constexpr int ins[] = { Layers::InputSize... };
+                for (size_t i = 0; i + 1 < Count; ++i)
+                    if (outs[i] != ins[i + 1])
+                        return false;
+
+                return true;
+            }
+
+            static_assert(chained(), "StaticSequential: every layer's OutputSize must equal the next layer's InputSize");
+
+            LayerTuple layers;
+
+            template <size_t I>
+            void forwardFrom(const float* x, float* y) const
+            {
+                if constexpr (I + 1 == Count)
+                    std::get<I>(layers).forward(x, y);
+                else
+                {
+                    float hidden[LayerAt<I>::OutputSize];
+                    std::get<I>(layers).forward(x, hidden);
+                    forwardFrom<I + 1>(hidden, y);
+                }
+            }
+
+            template <size_t I, int Batch>
+            void forwardBatchFrom(const float* x, float* y) const
+            {
+                if constexpr (I + 1 == Count)
+                    std::get<I>(layers).template forwardBatch<Batch>(x, y);
+                else
+                {
+                    float hidden[LayerAt<I>::OutputSize * Batch];
+                    std::get<I>(layers).template forwardBatch<Batch>(x, hidden);
+                    forwardBatchFrom<I + 1, Batch>(hidden, y);
+                }
+            }
+
+            template <size_t... I>
+            void loadAll(const std::vector<LinearStage>& stages, std::index_sequence<I...>)
+            {
+                (std::get<I>(layers).load(stages[I]), ...);
+            }
+
+        public:
+            static constexpr int InputSize = LayerAt<0>::InputSize;
+            static constexpr int OutputSize = LayerAt<Count - 1>::OutputSize;
+
+            /// Copies the parameters of a trained model whose Linear sizes and activations match the template.
+            void load(const Sequential& model)
+            {
+                auto stages = linearStages(model, "StaticSequential");
+                for (size_t i = 0; i < stages.size(); ++i)
+                    if (!stages[i].linear)
+                        throw std::invalid_argument("StaticSequential: activation at stage " + std::to_string(i) + " has no Linear before it");
+                if (stages.size() != Count)
+                    throw std::invalid_argument("StaticSequential: model has " + std::to_string(stages.size()) + " Linear layers, template has " + std::to_string(Count));
+
+                loadAll(stages, std::index_sequence_for<Layers...>{});
+            }
+
+            template <size_t I>
+            LayerAt<I>& layer() { return std::get<I>(layers); }
+
+            void forward(const float* x, float* y) const { forwardFrom<0>(x, y); }
+
+            std::array<float, OutputSize> forward(const std::array<float, InputSize>& x) const
+            {
+                std::array<float, OutputSize> y;
+                forwardFrom<0>(x.data(), y.data());
+                return y;
+            }
+
+            /// Batch samples in the usual sample-major layout: x[Batch][InputSize] → y[Batch][OutputSize].
+            /// Internally transposed so that SIMD lanes hold different samples.
+            template <int Batch>
+            void forwardBatch(const float* x, float* y) const
+            {
+                float in[InputSize * Batch], out[OutputSize * Batch];
+                for (int s = 0; s < Batch; ++s)
+                    for (int i = 0; i < InputSize; ++i)
+                        in[i * Batch + s] = x[s * InputSize + i];
+
+                forwardBatchFrom<0, Batch>(in, out);
+
+                for (int s = 0; s < Batch; ++s)
+                    for (int j = 0; j < OutputSize; ++j)
+                        y[s * OutputSize + j] = out[j * Batch + s];
+            }
+    };
+
+    #pragma endregion
+}
@@ -1,9 +1,15 @@
 #include "optimizer.h"
+#include "memorytracker.h"
 #include <cmath>
 #include <algorithm>
 
 namespace SushiAI 
 {
+    Optimizer::~Optimizer()
+    {
+        MemoryTracker::onOptimizerDestroyed(this);
+    }
+
     // ----- SGD -----
     SGD::SGD(float learningRate, float momentum, float weightDecay) : learningRate(learningRate), momentum(momentum), weightDecay(weightDecay) 
     {
@@ -13,13 +19,33 @@ namespace SushiAI
     void SGD::zeroGradient(const std::vector<std::shared_ptr<Tensor>>& parameters) 
     {
         for (auto& p : parameters)
+        {
             std::fill(p -> getGradient().begin(), p -> getGradient().end(), 0.0f);
+            p -> sparseGradient.clear();
+        }
     }
 
     void SGD::step(const std::vector<std::shared_ptr<Tensor>>& parameters) 
     {
         for (auto& p : parameters) 
         {
+            // Frozen parameters keep their values (and their optimizer state) untouched
+            if (!p -> requiresGradient)
+                continue;
+
+            if (p -> gradientIsSparse)
+            {
+                if (p -> gradient.empty())
+                {
+                    sparseStep(*p);
+                    continue;
+                }
+
+                // Tied table with a dense fallback gradient: fold in the rows recorded before it existed
+                p -> sparseGradient.addTo(p -> gradient);
+                p -> sparseGradient.clear();
+            }
+
             auto& data = p -> getData();
             auto& grad = p -> getGradient();
             Tensor* key = p.get();
@@ -36,6 +62,55 @@ namespace SushiAI
                 data[i] -= v[i];
             }
         }
+
+        if (MemoryTracker::isEnabled())
+            MemoryTracker::onOptimizerStep(this);
+    }
+
+    void SGD::sparseStep(Tensor& p)
+    {
+        SparseGradient& sparse = p.sparseGradient;
+        sparse.coalesce();
+
+        auto& data = p.getData();
+        const int cols = sparse.cols;
+
+        float* v = nullptr;
+        if (momentum != 0.0f)
+        {
+            auto& state = velocity[&p];
+            if (state.empty())
+                state.assign(data.size(), 0.0f);
+            v = state.data();
+        }
+
+        for (size_t r = 0; r < sparse.rows(); ++r)
+        {
+            size_t offset = (size_t)sparse.indices[r] * cols;
+            float* w = data.data() + offset;
+            const float* grad = sparse.values.data() + r * cols;
+
+            for (int j = 0; j < cols; ++j)
+            {
+                float g = grad[j] + weightDecay * w[j];
+                if (v)
+                {
+                    v[offset + j] = momentum * v[offset + j] + learningRate * g;
+                    w[j] -= v[offset + j];
+                }
+                else
+                    w[j] -= learningRate * g;
+            }
+        }
+    }
+
+    size_t SGD::stateBytes() const
+    {
+        size_t bytes = 0;
+        for (auto& [key, v] : velocity)
+            bytes += v.capacity() * sizeof(float);
+
+        return bytes;
     }
 
     // ----- Adam -----
@@ -47,7 +122,10 @@ namespace SushiAI
     void Adam::zeroGradient(const std::vector<std::shared_ptr<Tensor>>& params) 
     {
         for (auto& p : params)
+        {
             std::fill(p -> getGradient().begin(), p -> getGradient().end(), 0.0f);
+            p -> sparseGradient.clear();
+        }
     }
 
     void Adam::step(const std::vector<std::shared_ptr<Tensor>>& params) 
@@ -58,6 +136,21 @@ namespace SushiAI
 
         for (auto& p : params) 
         {
+            if (!p -> requiresGradient)
+                continue;
+
+            if (p -> gradientIsSparse)
+            {
+                if (p -> gradient.empty())
+                {
+                    sparseStep(*p, biasCorrection1, biasCorrection2);
+                    continue;
+                }
+
+                p -> sparseGradient.addTo(p -> gradient);
+                p -> sparseGradient.clear();
+            }
+
             auto& data = p -> getData();
             auto& grad = p -> getGradient();
             Tensor* key = p.get();
@@ -79,5 +172,126 @@ namespace SushiAI
                 data[i] -= learningRate * mHat / (std::sqrt(vHat) + eps);
             }
         }
+
+        if (MemoryTracker::isEnabled())
+            MemoryTracker::onOptimizerStep(this);
+    }
+
+    void Adam::sparseStep(Tensor& p, float biasCorrection1, float biasCorrection2)
+    {
+        SparseGradient& sparse = p.sparseGradient;
+        sparse.coalesce();
+
+        auto& data = p.getData();
+        auto& mt = meanMoment[&p];
+        auto& vt = varianceMoment[&p];
+
+        if (mt.empty())
+            mt.assign(data.size(), 0.0f);
+        if (vt.empty())
+            vt.assign(data.size(), 0.0f);
+
+        const int cols = sparse.cols;
+        for (size_t r = 0; r < sparse.rows(); ++r)
+        {
+            size_t offset = (size_t)sparse.indices[r] * cols;
+            const float* grad = sparse.values.data() + r * cols;
+
+            for (int j = 0; j < cols; ++j)
+            {
+                size_t i = offset + j;
+                mt[i] = beta1 * mt[i] + (1.0f - beta1) * grad[j];
+                vt[i] = beta2 * vt[i] + (1.0f - beta2) * grad[j] * grad[j];
+                float mHat = mt[i] / biasCorrection1;
+                float vHat = vt[i] / biasCorrection2;
+                data[i] -= learningRate * mHat / (std::sqrt(vHat) + eps);
+            }
+        }
+    }
+
+    size_t Adam::stateBytes() const
+    {
+        size_t bytes = 0;
+        for (auto& [key, m] : meanMoment)
+            bytes += m.capacity() * sizeof(float);
+        for (auto& [key, v] : varianceMoment)
+            bytes += v.capacity() * sizeof(float);
+
+        return bytes;
+    }
+
+    // ----- Mixed Precision -----
+    MixedPrecisionOptimizer::MixedPrecisionOptimizer(std::shared_ptr<Optimizer> inner, DType modelDType, float initialScale, float growthFactor, float backoffFactor, int growthInterval)
+        : inner(std::move(inner)), modelDType(modelDType), lossScale(initialScale), growthFactor(growthFactor), backoffFactor(backoffFactor), growthInterval(growthInterval)
+    {
+
+    }
+
+    void MixedPrecisionOptimizer::backward(const std::shared_ptr<Tensor>& loss)
+    {
+        std::vector<float> seed(loss -> getTotalSize(), 0.0f);
+        seed[0] = lossScale;
+
+        loss -> backward(seed);
+    }
+
+    void MixedPrecisionOptimizer::zeroGradient(const std::vector<std::shared_ptr<Tensor>>& params)
+    {
+        inner -> zeroGradient(params);
+    }
+
+    void MixedPrecisionOptimizer::step(const std::vector<std::shared_ptr<Tensor>>& params)
+    {
+        // Unscale, watching for overflow
+        float inverseScale = 1.0f / lossScale;
+        bool finite = true;
+
+        for (auto& p : params)
+        {
+            // Frozen parameters are skipped by the inner step, so their gradients must not veto it either
+            if (!p -> requiresGradient)
+                continue;
+
+            for (auto& g : p -> getGradient())
+            {
+                g *= inverseScale;
+                finite = finite && std::isfinite(g);
+            }
+
+            for (auto& g : p -> sparseGradient.values)
+            {
+                g *= inverseScale;
+                finite = finite && std::isfinite(g);
+            }
+        }
+
+        skipped = !finite;
+        if (skipped)
+        {
+            lossScale = std::max(1.0f, lossScale * backoffFactor);
+            goodSteps = 0;
+            ++skippedSteps;
+
+            inner -> zeroGradient(params);
+            if (MemoryTracker::isEnabled())
+                MemoryTracker::onOptimizerStep(this);
+            return;
+        }
+
+        inner -> step(params);
+
+        if (++goodSteps >= growthInterval)
+        {
+            lossScale *= growthFactor;
+            goodSteps = 0;
+        }
+
+        if (MemoryTracker::isEnabled())
+            MemoryTracker::onOptimizerStep(this);
+    }
+
+    size_t MixedPrecisionOptimizer::stateBytes() const
+    {
+        return inner -> stateBytes();
     }
 }
\ No newline at end of file
@@ -9,9 +9,11 @@ namespace SushiAI
     class Optimizer 
     {
         public:
-            virtual ~Optimizer() = default;
+            virtual ~Optimizer();
             virtual void zeroGradient(const std::vector<std::shared_ptr<Tensor>>& parameters) = 0;
             virtual void step(const std::vector<std::shared_ptr<Tensor>>& parameters) = 0;
+            /// Bytes of per-parameter state the optimizer currently holds.
+            virtual size_t stateBytes() const { return 0; }
     };
 
     class SGD : public Optimizer 
@@ -20,6 +22,7 @@ namespace SushiAI
             SGD(float learningRate, float momentum = 0.0f, float weightDecay = 0.0f);
             void zeroGradient(const std::vector<std::shared_ptr<Tensor>>& parameters) override;
             void step(const std::vector<std::shared_ptr<Tensor>>& parameters) override;
+            size_t stateBytes() const override;
 
             float getLearningRate() const { return learningRate; }
             float getMomentum() const { return momentum; }
@@ -29,6 +32,9 @@ namespace SushiAI
             float momentum;
             float weightDecay;
             std::unordered_map<Tensor*, std::vector<float>> velocity;
+
+            /// Row-sparse parameters: only the rows in the gradient move (no velocity kept without momentum).
+            void sparseStep(Tensor& p);
     };
 
     class Adam : public Optimizer 
@@ -37,6 +43,7 @@ namespace SushiAI
             Adam(float learningRate, float b1 = 0.9f, float b2 = 0.999f, float eps = 1e-8f);
             void zeroGradient(const std::vector<std::shared_ptr<Tensor>>& parameters) override;
             void step(const std::vector<std::shared_ptr<Tensor>>& parameters) override;
+            size_t stateBytes() const override;
 
             float getLearningRate() const { return learningRate; }
         private:
@@ -47,5 +54,46 @@ namespace SushiAI
             int timeStep;
             std::unordered_map<Tensor*, std::vector<float>> meanMoment;
             std::unordered_map<Tensor*, std::vector<float>> varianceMoment;
+
+            /// Lazy Adam for row-sparse parameters: moments and weights of rows absent from the gradient are left
+            /// as they are instead of decaying, so a step costs O(touched rows) rather than O(vocabulary).
+            void sparseStep(Tensor& p, float biasCorrection1, float biasCorrection2);
+    };
+
+    /// Mixed-precision training around another optimizer. Tensor storage is fp32 anyway (see DType), so the
+    /// parameters themselves are the master weights the inner optimizer updates: under AutocastGuard the
+    /// GEMMs round them to modelDType as operands, and no second copy is kept.
+    /// Losses are multiplied by a dynamic loss scale so small bf16/fp16 gradients don't flush to zero;
+    /// a step with Inf/NaN gradients is skipped and the scale shrinks, and it grows again after
+    /// growthInterval clean steps. Run the forward pass under AutocastGuard(modelDType).
+    class MixedPrecisionOptimizer : public Optimizer
+    {
+        public:
+            MixedPrecisionOptimizer(std::shared_ptr<Optimizer> inner, DType modelDType = DType::BFloat16, float initialScale = 65536.0f,
+                float growthFactor = 2.0f, float backoffFactor = 0.5f, int growthInterval = 2000);
+
+            /// Backpropagates loss * lossScale.
+            void backward(const std::shared_ptr<Tensor>& loss);
+
+            void zeroGradient(const std::vector<std::shared_ptr<Tensor>>& parameters) override;
+            void step(const std::vector<std::shared_ptr<Tensor>>& parameters) override;
+            /// The inner optimizer's state (there are no master copies).
+            size_t stateBytes() const override;
+
+            DType getModelDType() const { return modelDType; }
+            float getLossScale() const { return lossScale; }
+            bool lastStepSkipped() const { return skipped; }
+            int getSkippedSteps() const { return skippedSteps; }
+
+        private:
+            std::shared_ptr<Optimizer> inner;
+            DType modelDType;
+            float lossScale;
+            float growthFactor;
+            float backoffFactor;
+            int growthInterval;
+            int goodSteps = 0;
+            int skippedSteps = 0;
+            bool skipped = false;
     };
 }
\ No newline at end of file
@@ -0,0 +1,508 @@
+#include <mutex>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include "pipeline.h"
+#include "parallel.h"
+
+namespace SushiAI
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        /// Activation or gradient handed from one stage to its neighbour.
+        struct StageMessage
+        {
+            int microBatch;
+            std::vector<int> shape;
+            std::vector<float> values;
+        };
+
+        struct StageOp
+        {
+            bool forward;
+            int microBatch;
+        };
+
+        /// What a stage keeps alive between the forward and the backward of a micro-batch.
+        struct StageStash
+        {
+            std::shared_ptr<Tensor> input;
+            std::shared_ptr<Tensor> output;
+        };
+
+        double secondsSince(Clock::time_point start)
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        std::shared_ptr<Tensor> makeLeaf(const std::vector<int>& shape, std::vector<float> values, bool requiresGrad)
+        {
+            auto leaf = std::make_shared<Tensor>(shape, 0.0f, requiresGrad);
+            leaf -> data = std::move(values);
+
+            return leaf;
+        }
+
+        /// Cuts a tensor into (at most) parts pieces along dim 0, as fresh leaf tensors.
+        std::vector<std::shared_ptr<Tensor>> splitRows(const std::shared_ptr<Tensor>& t, int parts)
+        {
+            const auto& shape = t -> getShape();
+            if (shape.empty())
+                throw std::invalid_argument("Pipeline: micro-batching needs a batch dimension");
+
+            int rows = shape[0];
+            int rowSize = rows > 0 ? t -> getTotalSize() / rows : 0;
+            parts = std::max(1, std::min(parts, rows));
+
+            std::vector<std::shared_ptr<Tensor>> pieces;
+            int begin = 0;
+            for (int p = 0; p < parts; ++p)
+            {
+                int count = rows / parts + (p < rows % parts ? 1 : 0);
+
+                auto subShape = shape;
+                subShape[0] = count;
+
+                std::vector<float> values(t -> data.begin() + (size_t)begin * rowSize, t -> data.begin() + (size_t)(begin + count) * rowSize);
+                pieces.push_back(makeLeaf(subShape, std::move(values), false));
+
+                begin += count;
+            }
+
+            return pieces;
+        }
+
+        std::shared_ptr<Tensor> concatRows(const std::vector<std::shared_ptr<Tensor>>& pieces)
+        {
+            auto shape = pieces.front() -> getShape();
+            shape[0] = 0;
+
+            std::vector<float> values;
+            for (auto& p : pieces)
+            {
+                shape[0] += p -> getShape()[0];
+                values.insert(values.end(), p -> data.begin(), p -> data.end());
+            }
+
+            return makeLeaf(shape, std::move(values), false);
+        }
+
+        std::vector<StageOp> buildSchedule(PipelineSchedule schedule, int stage, int stages, int microBatches, bool withBackward)
+        {
+            std::vector<StageOp> ops;
+
+            if (!withBackward)
+            {
+                for (int m = 0; m < microBatches; ++m)
+                    ops.push_back({ true, m });
+                return ops;
+            }
+
+            if (schedule == PipelineSchedule::GPipe)
+            {
+                for (int m = 0; m < microBatches; ++m)
+                    ops.push_back({ true, m });
+                for (int m = 0; m < microBatches; ++m)
+                    ops.push_back({ false, m });
+                return ops;
+            }
+
+            // 1F1B: earlier stages run ahead by (stages - stage - 1) forwards, then alternate.
+            int warmup = std::min(stages - stage - 1, microBatches);
+            int nextForward = 0, nextBackward = 0;
+
+            for (; nextForward < warmup; ++nextForward)
+                ops.push_back({ true, nextForward });
+
+            while (nextForward < microBatches)
+            {
+                ops.push_back({ true, nextForward++ });
+                ops.push_back({ false, nextBackward++ });
+            }
+
+            while (nextBackward < microBatches)
+                ops.push_back({ false, nextBackward++ });
+
+            return ops;
+        }
+
+        using Queues = std::vector<std::unique_ptr<BoundedQueue<StageMessage>>>;
+
+        /// Runs worker(s) on one thread per stage. The first exception of any stage closes every queue, so the
+        /// stages blocked on it unwind instead of waiting forever, and is rethrown on the calling thread.
+        void runStages(int stages, const std::function<void(int)>& worker, const std::vector<Queues*>& queues)
+        {
+            std::exception_ptr failure;
+            std::mutex failureMutex;
+
+            auto guarded = [&](int s)
+            {
+                try
+                {
+                    worker(s);
+                }
+                catch (...)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(failureMutex);
+                        if (!failure)
+                            failure = std::current_exception();
+                    }
+
+                    for (auto* group : queues)
+                        for (auto& queue : *group)
+                            queue -> close();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (int s = 0; s < stages; ++s)
+                threads.emplace_back(guarded, s);
+            for (auto& t : threads)
+                t.join();
+
+            if (failure)
+                std::rethrow_exception(failure);
+        }
+
+        std::shared_ptr<Tensor> runLayers(const std::vector<std::shared_ptr<Layer>>& layers, std::shared_ptr<Tensor> x, bool training)
+        {
+            for (auto& layer : layers)
+                x = layer -> forward(x, training);
+
+            return x;
+        }
+    }
+
+    #pragma region Pipeline
+
+    Pipeline::Pipeline(const std::shared_ptr<Sequential>& model, const std::vector<size_t>& stageStarts, int microBatches, PipelineSchedule schedule, size_t queueCapacity)
+        : model(model), stageStarts(stageStarts), microBatches(std::max(1, microBatches)), schedule(schedule), queueCapacity(queueCapacity)
+    {
+        size_t numLayers = model -> layersSize();
+
+        if (stageStarts.empty() || stageStarts[0] != 0)
+            throw std::invalid_argument("Pipeline: stageStarts must begin with 0");
+
+        for (size_t s = 0; s < stageStarts.size(); ++s)
+        {
+            size_t begin = stageStarts[s];
+            size_t end = (s + 1 < stageStarts.size()) ? stageStarts[s + 1] : numLayers;
+
+            if (begin >= end || end > numLayers)
+                throw std::invalid_argument("Pipeline: stageStarts must be strictly increasing and inside the model");
+
+            std::vector<std::shared_ptr<Layer>> stage;
+            for (size_t i = begin; i < end; ++i)
+                stage.push_back(model -> getLayer(i));
+
+            stages.push_back(std::move(stage));
+        }
+
+        if (this -> queueCapacity == 0)
+            this -> queueCapacity = std::max<size_t>(2, stages.size());
+    }
+
+    std::shared_ptr<Tensor> Pipeline::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        auto microInputs = splitRows(input, microBatches);
+        int M = (int)microInputs.size();
+        int S = (int)stages.size();
+
+        Queues forwardQueues;
+        for (int s = 0; s < S; ++s)
+            forwardQueues.emplace_back(new BoundedQueue<StageMessage>(queueCapacity));
+
+        std::vector<std::shared_ptr<Tensor>> outputs(M);
+
+        auto worker = [&](int s)
+        {
+            for (auto& op : buildSchedule(schedule, s, S, M, false))
+            {
+                std::shared_ptr<Tensor> x;
+                if (s == 0)
+                    x = microInputs[op.microBatch];
+                else
+                {
+                    auto msg = forwardQueues[s] -> pop();
+                    x = makeLeaf(msg.shape, std::move(msg.values), false);
+                }
+
+                auto out = runLayers(stages[s], x, training);
+
+                if (s == S - 1)
+                    outputs[op.microBatch] = out;
+                else
+                    forwardQueues[s + 1] -> push({ op.microBatch, out -> getShape(), out -> data });
+            }
+        };
+
+        runStages(S, worker, { &forwardQueues });
+
+        return concatRows(outputs);
+    }
+
+    PipelineStats Pipeline::trainStep(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& target, Loss& lossFunction)
+    {
+        auto microInputs = splitRows(input, microBatches);
+        auto microTargets = splitRows(target, (int)microInputs.size());
+        int M = (int)microInputs.size();
+        int S = (int)stages.size();
+
+        if ((int)microTargets.size() != M)
+            throw std::invalid_argument("Pipeline::trainStep(): input and target batch sizes differ");
+
+        // Each micro-batch loss is weighted by its share of the batch, so the accumulated
+        // gradient equals the gradient of the full-batch mean loss.
+        int batch = input -> getShape()[0];
+        std::vector<float> weights(M);
+        for (int m = 0; m < M; ++m)
+            weights[m] = (float)microInputs[m] -> getShape()[0] / (float)batch;
+
+        Queues forwardQueues, backwardQueues;
+        for (int s = 0; s < S; ++s)
+        {
+            forwardQueues.emplace_back(new BoundedQueue<StageMessage>(queueCapacity));
+            backwardQueues.emplace_back(new BoundedQueue<StageMessage>(queueCapacity));
+        }
+
+        std::vector<float> losses(M, 0.0f);
+        PipelineStats stats;
+        stats.stageBusySeconds.assign(S, 0.0);
+
+        auto worker = [&](int s)
+        {
+            std::unordered_map<int, StageStash> stash;
+            double busy = 0.0;
+
+            for (auto& op : buildSchedule(schedule, s, S, M, true))
+            {
+                int m = op.microBatch;
+
+                if (op.forward)
+                {
+                    std::shared_ptr<Tensor> x;
+                    if (s == 0)
+                        x = microInputs[m];
+                    else
+                    {
+                        auto msg = forwardQueues[s] -> pop();
+                        x = makeLeaf(msg.shape, std::move(msg.values), true);
+                    }
+
+                    auto start = Clock::now();
+                    auto out = runLayers(stages[s], x, true);
+
+                    if (s == S - 1)
+                    {
+                        out = lossFunction.forward(out, microTargets[m]);
+                        losses[m] = out -> data[0];
+                    }
+                    busy += secondsSince(start);
+
+                    stash[m] = { x, out };
+
+                    if (s < S - 1)
+                        forwardQueues[s + 1] -> push({ m, out -> getShape(), out -> data });
+                }
+                else
+                {
+                    std::vector<float> seed;
+                    if (s == S - 1)
+                        seed.assign(1, weights[m]);
+                    else
+                        seed = backwardQueues[s] -> pop().values;
+
+                    auto entry = std::move(stash[m]);
+                    stash.erase(m);
+
+                    auto start = Clock::now();
+                    entry.output -> backward(seed, false, false);
+                    busy += secondsSince(start);
+
+                    if (s > 0)
+                        backwardQueues[s - 1] -> push({ m, entry.input -> getShape(), std::move(entry.input -> gradient) });
+                }
+            }
+
+            stats.stageBusySeconds[s] = busy;
+        };
+
+        auto start = Clock::now();
+
+        runStages(S, worker, { &forwardQueues, &backwardQueues });
+
+        stats.seconds = secondsSince(start);
+        stats.samplesPerSecond = stats.seconds > 0.0 ? batch / stats.seconds : 0.0;
+        for (int m = 0; m < M; ++m)
+            stats.loss += weights[m] * losses[m];
+
+        return stats;
+    }
+
+    void Pipeline::printStages() const
+    {
+        std::cout << "=== Pipeline: " << stages.size() << " stages, " << microBatches << " micro-batches, "
+            << (schedule == PipelineSchedule::GPipe ? "GPipe" : "1F1B") << " ===\n";
+
+        for (size_t s = 0; s < stages.size(); ++s)
+        {
+            std::cout << "[Stage " << s << "] layers " << stageStarts[s] << ".." << stageStarts[s] + stages[s].size() - 1 << ":";
+            for (auto& layer : stages[s])
+                std::cout << " " << layer -> name();
+            std::cout << "\n";
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region Stage Balancing
+
+    std::vector<double> measureLayerCosts(const Sequential& model, const std::shared_ptr<Tensor>& sampleInput, int repeats)
+    {
+        // Timing runs backward too, so keep the real parameter gradients aside, and runs training forwards,
+        // so keep BatchNorm's running statistics and the Dropout masks' generators as well.
+        std::vector<std::shared_ptr<Layer>> layers;
+        for (size_t i = 0; i < model.layersSize(); ++i)
+            layers.push_back(model.getLayer(i));
+        TrainingStateGuard state(layers);
+
+        auto params = model.parameters();
+        std::vector<std::vector<float>> savedGradients;
+        for (auto& p : params)
+            savedGradients.push_back(p -> gradient);
+
+        std::vector<double> costs(model.layersSize(), 0.0);
+        auto current = makeLeaf(sampleInput -> getShape(), sampleInput -> data, false);
+
+        for (size_t i = 0; i < model.layersSize(); ++i)
+        {
+            auto layer = model.getLayer(i);
+            double best = std::numeric_limits<double>::max();
+
+            for (int r = 0; r < std::max(1, repeats); ++r)
+            {
+                auto x = makeLeaf(current -> getShape(), current -> data, true);
+
+                auto start = Clock::now();
+                auto out = layer -> forward(x, true);
+                out -> backward(std::vector<float>(out -> getTotalSize(), 1.0f), false, false);
+                best = std::min(best, secondsSince(start));
+            }
+
+            costs[i] = best;
+
+            auto out = layer -> forward(makeLeaf(current -> getShape(), current -> data, false), false);
+            current = makeLeaf(out -> getShape(), out -> data, false);
+        }
+
+        for (size_t j = 0; j < params.size(); ++j)
+            params[j] -> gradient = std::move(savedGradients[j]);
+
+        return costs;
+    }
+
+    std::vector<size_t> balanceStages(const std::vector<double>& layerCosts, int numStages)
+    {
+        int N = (int)layerCosts.size();
+        int S = std::max(1, std::min(numStages, N));
+
+        std::vector<double> prefix(N + 1, 0.0);
+        for (int i = 0; i < N; ++i)
+            prefix[i + 1] = prefix[i] + layerCosts[i];
+
+        // best[k][i]: smallest possible slowest-stage cost when the first i layers form k stages.
+        const double inf = std::numeric_limits<double>::max();
+        std::vector<std::vector<double>> best(S + 1, std::vector<double>(N + 1, inf));
+        std::vector<std::vector<int>> split(S + 1, std::vector<int>(N + 1, 0));
+        best[0][0] = 0.0;
+
+        for (int k = 1; k <= S; ++k)
+        {
+            for (int i = k; i <= N; ++i)
+            {
+                for (int j = k - 1; j < i; ++j)
+                {
+                    if (best[k - 1][j] == inf)
+                        continue;
+
+                    double cost = std::max(best[k - 1][j], prefix[i] - prefix[j]);
+                    if (cost < best[k][i])
+                    {
+                        best[k][i] = cost;
+                        split[k][i] = j;
+                    }
+                }
+            }
+        }
+
+        std::vector<size_t> starts(S, 0);
+        int end = N;
+        for (int k = S; k >= 1; --k)
+        {
+            starts[k - 1] = (size_t)split[k][end];
+            end = split[k][end];
+        }
+
+        return starts;
+    }
+
+    std::vector<size_t> balanceStages(const Sequential& model, const std::shared_ptr<Tensor>& sampleInput, int numStages, int repeats)
+    {
+        return balanceStages(measureLayerCosts(model, sampleInput, repeats), numStages);
+    }
+
+    #pragma endregion
+
+    #pragma region Throughput
+
+    PipelineThroughput comparePipelineThroughput(Pipeline& pipeline, const std::shared_ptr<Sequential>& model,
+        const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& target, Loss& lossFunction, int steps)
+    {
+        steps = std::max(1, steps);
+        int batch = input -> getShape()[0];
+
+        auto microInputs = splitRows(input, pipeline.getMicroBatches());
+        auto microTargets = splitRows(target, (int)microInputs.size());
+
+        auto sequentialStep = [&]()
+        {
+            for (size_t m = 0; m < microInputs.size(); ++m)
+            {
+                auto loss = lossFunction.forward(model -> forward(microInputs[m], true), microTargets[m]);
+                loss -> backward({ (float)microInputs[m] -> getShape()[0] / (float)batch }, false, false);
+            }
+        };
+
+        // One untimed round of each to warm up caches and the allocator.
+        sequentialStep();
+        pipeline.trainStep(input, target, lossFunction);
+
+        auto start = Clock::now();
+        for (int i = 0; i < steps; ++i)
+            sequentialStep();
+        double sequentialSeconds = secondsSince(start);
+
+        start = Clock::now();
+        for (int i = 0; i < steps; ++i)
+            pipeline.trainStep(input, target, lossFunction);
+        double pipelineSeconds = secondsSince(start);
+
+        PipelineThroughput result;
+        result.sequentialSamplesPerSecond = (double)batch * steps / sequentialSeconds;
+        result.pipelineSamplesPerSecond = (double)batch * steps / pipelineSeconds;
+        result.speedup = result.pipelineSamplesPerSecond / result.sequentialSamplesPerSecond;
+
+        return result;
+    }
+
+    #pragma endregion
+}
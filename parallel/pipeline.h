@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include "sequential.h"
+#include "tensor.h"
+#include "loss.h"
+
+namespace SushiAI
+{
+    /// Order in which each stage runs the forward (F) and backward (B) passes of its micro-batches.
+    enum class PipelineSchedule
+    {
+        GPipe,                  // F0 F1 ... Fm, then Bm ... B0 on every stage
+        OneForwardOneBackward   // 1F1B: short warm-up, then alternate F and B
+    };
+
+    struct PipelineStats
+    {
+        float loss = 0.0f;                      // mean loss over all micro-batches
+        double seconds = 0.0;                   // wall time of the step
+        double samplesPerSecond = 0.0;
+        std::vector<double> stageBusySeconds;   // time each stage thread spent computing
+    };
+
+    struct PipelineThroughput
+    {
+        double sequentialSamplesPerSecond = 0.0;
+        double pipelineSamplesPerSecond = 0.0;
+        double speedup = 0.0;
+    };
+
+    /// Splits the layers of a Sequential into contiguous stages, each stage running on its own thread.
+    /// A batch is cut into micro-batches along dim 0 that flow through bounded queues between the stages.
+    /// Gradients of all micro-batches are accumulated into the model parameters, so a training step is
+    /// trainStep() followed by the usual optimizer step() / zeroGradient().
+    class Pipeline
+    {
+        public:
+            /// stageStarts holds the index of the first layer of every stage and must begin with 0.
+            /// queueCapacity = 0 picks the number of stages, which bounds the in-flight micro-batches of 1F1B.
+            Pipeline(const std::shared_ptr<Sequential>& model, const std::vector<size_t>& stageStarts, int microBatches,
+                PipelineSchedule schedule = PipelineSchedule::OneForwardOneBackward, size_t queueCapacity = 0);
+
+            /// Inference through the pipeline, returns the concatenated outputs of all micro-batches.
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = false);
+            /// Forward + backward of one batch, accumulating parameter gradients.
+            /// An exception thrown in any stage stops all of them and is rethrown here; the gradients of that
+            /// step are then partial.
+            PipelineStats trainStep(const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& target, Loss& lossFunction);
+
+            size_t stagesSize() const { return stages.size(); }
+            int getMicroBatches() const { return microBatches; }
+            PipelineSchedule getSchedule() const { return schedule; }
+
+            void printStages() const;
+
+        private:
+            std::shared_ptr<Sequential> model;
+            std::vector<std::vector<std::shared_ptr<Layer>>> stages;
+            std::vector<size_t> stageStarts;
+            int microBatches;
+            PipelineSchedule schedule;
+            size_t queueCapacity;
+    };
+
+    /// Measures forward + backward time (seconds) of every layer of the model on the given sample batch.
+    /// Parameter gradients, BatchNorm running statistics and Dropout generators are left as they were.
+    std::vector<double> measureLayerCosts(const Sequential& model, const std::shared_ptr<Tensor>& sampleInput, int repeats = 5);
+
+    /// Splits per-layer costs into numStages contiguous stages minimizing the cost of the slowest stage.
+    /// Returns the index of the first layer of each stage.
+    std::vector<size_t> balanceStages(const std::vector<double>& layerCosts, int numStages);
+    std::vector<size_t> balanceStages(const Sequential& model, const std::shared_ptr<Tensor>& sampleInput, int numStages, int repeats = 5);
+
+    /// Compares the samples/second of the pipeline against running the same micro-batches on one thread.
+    /// Parameter gradients are left accumulated; zero them afterwards.
+    PipelineThroughput comparePipelineThroughput(Pipeline& pipeline, const std::shared_ptr<Sequential>& model,
+        const std::shared_ptr<Tensor>& input, const std::shared_ptr<Tensor>& target, Loss& lossFunction, int steps = 10);
+}
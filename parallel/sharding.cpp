@@ -0,0 +1,250 @@
+#include <cassert>
+#include <algorithm>
+#include <stdexcept>
+#include "sharding.h"
+#include "backend.h"
+
+namespace SushiAI
+{
+    /// Worker threads of a ShardedLinear and the per-shard buffers they reduce through.
+    struct ShardWorkers
+    {
+        ThreadPool pool;
+        std::vector<std::vector<float>> partials;
+
+        ShardWorkers(int shards, const std::vector<std::vector<int>>& cpuSets) : pool(shards, cpuSets), partials(shards) {}
+
+        /// dst[i] (+)= sum_k partials[k][i] for i < count, split across the workers.
+        void reduce(float* dst, int count, bool accumulate)
+        {
+            int shards = (int)partials.size();
+
+            pool.run([&](int k)
+            {
+                int begin = (int)((long long)count * k / shards);
+                int end = (int)((long long)count * (k + 1) / shards);
+
+                for (int i = begin; i < end; ++i)
+                {
+                    float sum = accumulate ? dst[i] : 0.0f;
+                    for (int s = 0; s < shards; ++s)
+                        sum += partials[s][i];
+                    dst[i] = sum;
+                }
+            });
+        }
+    };
+
+    ShardedLinear::ShardedLinear(int in_features, int out_features, int shards, ShardMode mode,
+        std::shared_ptr<Initializer> weightInit, std::shared_ptr<Initializer> biasInit, bool pinToNumaNodes)
+        : in(in_features), out(out_features), mode(mode)
+    {
+        int split = (mode == ShardMode::Column) ? out : in;
+        shards = std::max(1, std::min(shards, split));
+
+        for (int k = 0; k <= shards; ++k)
+            offsets.push_back((int)((long long)split * k / shards));
+
+        std::vector<std::vector<int>> cpuSets;
+        if (pinToNumaNodes)
+        {
+            auto nodes = numaNodeCpus();
+            for (int k = 0; k < shards; ++k)
+                cpuSets.push_back(nodes[k % nodes.size()]);
+        }
+
+        workers = std::make_shared<ShardWorkers>(shards, cpuSets);
+
+        // Initialize the full matrix so fan-in/fan-out match a plain Linear, then let every
+        // worker allocate (first-touch) and fill its own shard.
+        auto full = Tensor::Zeros({ in, out }, false);
+        weightInit -> initialize(full);
+
+        bias = Tensor::Zeros({ out }, true);
+        biasInit -> initialize(bias);
+
+        weightShards.resize(shards);
+        workers -> pool.run([&](int k)
+        {
+            int begin = offsets[k], n = offsets[k + 1] - offsets[k];
+            const auto& W = full -> getData();
+
+            if (this -> mode == ShardMode::Column)
+            {
+                auto shard = Tensor::Zeros({ in, n }, true);
+                for (int l = 0; l < in; ++l)
+                    std::copy(W.begin() + l * out + begin, W.begin() + l * out + begin + n, shard -> data.begin() + l * n);
+                weightShards[k] = shard;
+            }
+            else
+            {
+                auto shard = Tensor::Zeros({ n, out }, true);
+                std::copy(W.begin() + begin * out, W.begin() + (begin + n) * out, shard -> data.begin());
+                weightShards[k] = shard;
+            }
+        });
+    }
+
+    std::string ShardedLinear::name() const
+    {
+        return std::string("ShardedLinear(") + (mode == ShardMode::Column ? "column" : "row") + " x" + std::to_string(weightShards.size()) + ")";
+    }
+
+    std::vector<std::shared_ptr<Tensor>> ShardedLinear::parameters() const
+    {
+        auto params = weightShards;
+        params.push_back(bias);
+
+        return params;
+    }
+
+    std::shared_ptr<Tensor> ShardedLinear::gatherWeights() const
+    {
+        auto full = Tensor::Zeros({ in, out }, false);
+        auto& W = full -> getData();
+
+        for (size_t k = 0; k < weightShards.size(); ++k)
+        {
+            int begin = offsets[k], n = offsets[k + 1] - offsets[k];
+            const auto& S = weightShards[k] -> getData();
+
+            if (mode == ShardMode::Column)
+            {
+                for (int l = 0; l < in; ++l)
+                    std::copy(S.begin() + l * n, S.begin() + (l + 1) * n, W.begin() + l * out + begin);
+            }
+            else
+                std::copy(S.begin(), S.end(), W.begin() + begin * out);
+        }
+
+        return full;
+    }
+
+    std::shared_ptr<Tensor> ShardedLinear::forward(const std::shared_ptr<Tensor>& input, bool training)
+    {
+        if (input -> getShape().size() == 1)
+        {
+            // Same single-sample convenience as Linear: [in] → [1, in]
+            auto reshaped = std::make_shared<Tensor>(std::vector<int>{1, input -> getShape()[0]}, 0.0f, input -> requiresGradient);
+            reshaped -> data = input -> data;
+
+            reshaped -> setGradientFunction([input, reshaped]()
+            {
+                for (int i = 0; i < input -> getTotalSize(); ++i)
+                    input -> gradient[i] += reshaped -> gradient[i];
+            }, { input });
+
+            return this -> forward(reshaped, training);
+        }
+
+        if (input -> getShape().size() != 2 || input -> getShape()[1] != in)
+            throw std::invalid_argument("ShardedLinear: expected input of shape [batch, " + std::to_string(in) + "]");
+
+        int B = input -> getShape()[0];
+        int I = in, O = out;
+        bool needsGrad = input -> requiresGradient || bias -> requiresGradient;
+        for (auto& w : weightShards)
+            needsGrad = needsGrad || w -> requiresGradient;
+
+        auto result = std::make_shared<Tensor>(std::vector<int>{ B, O }, 0.0f, needsGrad);
+
+        const auto& X = input -> getData();
+        auto& R = result -> getData();
+        const auto& b = bias -> getData();
+        auto shardsCopy = weightShards;
+        auto offs = offsets;
+        auto state = workers;
+
+        if (mode == ShardMode::Column)
+        {
+            // Every shard writes its own block of output columns (row stride O): the gather is free.
+            for (int i = 0; i < B; ++i)
+                std::copy(b.begin(), b.end(), R.begin() + (size_t)i * O);
+
+            state -> pool.run([&](int k)
+            {
+                int c0 = offs[k], n = offs[k + 1] - offs[k];
+                backend().gemm(false, false, B, n, I, X.data(), I, shardsCopy[k] -> data.data(), n, R.data() + c0, O);
+            });
+        }
+        else
+        {
+            // Every shard produces a partial [B, out] product from its block of input columns, then they are summed.
+            state -> pool.run([&](int k)
+            {
+                int r0 = offs[k], n = offs[k + 1] - offs[k];
+                auto& P = state -> partials[k];
+                P.assign((size_t)B * O, 0.0f);
+
+                backend().gemm(false, false, B, O, n, X.data() + r0, I, shardsCopy[k] -> data.data(), O, P.data(), O);
+            });
+
+            state -> reduce(R.data(), B * O, false);
+            backend().addRow(R.data(), b.data(), R.data(), B, O);
+        }
+
+        if (result -> requiresGradient)
+        {
+            auto input_ptr = input;
+            auto bias_ptr = bias;
+            auto result_ptr = result;
+            ShardMode shardMode = mode;
+
+            std::vector<std::shared_ptr<Tensor>> parents = shardsCopy;
+            parents.push_back(input_ptr);
+            parents.push_back(bias_ptr);
+
+            result -> setGradientFunction([input_ptr, bias_ptr, result_ptr, shardsCopy, offs, state, shardMode, B, I, O]()
+            {
+                const auto& X = input_ptr -> getData();
+                const auto& dR = result_ptr -> getGradient();
+                bool inputGrad = input_ptr -> requiresGradient;
+
+                if (shardMode == ShardMode::Column)
+                {
+                    state -> pool.run([&](int k)
+                    {
+                        int c0 = offs[k], n = offs[k + 1] - offs[k];
+                        const Backend& be = backend();
+
+                        // Partial dX_k = dR[:, c0:c0+n] · W_k^T, reduced across shards below
+                        if (inputGrad)
+                        {
+                            auto& P = state -> partials[k];
+                            P.assign((size_t)B * I, 0.0f);
+                            be.gemm(false, true, B, I, n, dR.data() + c0, O, shardsCopy[k] -> data.data(), n, P.data(), I);
+                        }
+
+                        // dW_k = X^T · dR[:, c0:c0+n]
+                        if (shardsCopy[k] -> requiresGradient)
+                            be.gemm(true, false, I, n, B, X.data(), I, dR.data() + c0, O, shardsCopy[k] -> gradient.data(), n);
+                    });
+
+                    if (inputGrad)
+                        state -> reduce(input_ptr -> getGradient().data(), B * I, true);
+                }
+                else
+                {
+                    state -> pool.run([&](int k)
+                    {
+                        int r0 = offs[k], n = offs[k + 1] - offs[k];
+                        const Backend& be = backend();
+
+                        // dX[:, r0:r0+n] += dR · W_k^T, a disjoint block of columns per shard
+                        if (inputGrad)
+                            be.gemm(false, true, B, n, O, dR.data(), O, shardsCopy[k] -> data.data(), O, input_ptr -> gradient.data() + r0, I);
+
+                        // dW_k = X[:, r0:r0+n]^T · dR
+                        if (shardsCopy[k] -> requiresGradient)
+                            be.gemm(true, false, n, O, B, X.data() + r0, I, dR.data(), O, shardsCopy[k] -> gradient.data(), O);
+                    });
+                }
+
+                if (bias_ptr -> requiresGradient)
+                    backend().accumulateRows(dR.data(), bias_ptr -> gradient.data(), B, O);
+            }, parents);
+        }
+
+        return result;
+    }
+}
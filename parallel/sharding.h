@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include "initializer.h"
+#include "parallel.h"
+#include "layer.h"
+
+namespace SushiAI
+{
+    struct ShardWorkers;
+
+    /// How ShardedLinear cuts its [in, out] weight matrix.
+    enum class ShardMode
+    {
+        Column,     // shard k owns a block of output columns; outputs are gathered, input gradients reduced
+        Row         // shard k owns a block of input rows; outputs are reduced, input gradients gathered
+    };
+
+    /// Tensor-parallel drop-in replacement for Linear. The weight matrix is split across worker threads
+    /// (one per shard, each pinned to a NUMA node in round-robin) and every worker allocates and touches
+    /// its own shard, so it lives in that node's memory. Forward and backward run all shards in parallel.
+    /// A single instance must not be used from several threads at once.
+    class ShardedLinear : public Layer
+    {
+        public:
+            ShardedLinear(int in_features, int out_features, int shards, ShardMode mode,
+                std::shared_ptr<Initializer> weightInit, std::shared_ptr<Initializer> biasInit, bool pinToNumaNodes = true);
+
+            std::shared_ptr<Tensor> forward(const std::shared_ptr<Tensor>& input, bool training = true) override;
+            std::string name() const override;
+            std::vector<std::shared_ptr<Tensor>> parameters() const override;
+
+            /// Reassembles the full [in, out] weight matrix, e.g. to export into a plain Linear.
+            std::shared_ptr<Tensor> gatherWeights() const;
+
+            int inFeatures() const { return in; }
+            int outFeatures() const { return out; }
+            ShardMode getMode() const { return mode; }
+
+            std::vector<std::shared_ptr<Tensor>> weightShards;   // Column: [in, n_k], Row: [n_k, out]
+            std::shared_ptr<Tensor> bias;
+
+        private:
+            int in, out;
+            ShardMode mode;
+            std::vector<int> offsets;   // first column (Column) or row (Row) of every shard, plus the end
+            std::shared_ptr<ShardWorkers> workers;  // shared with pending backward closures
+    };
+}
@@ -0,0 +1,37 @@
+#include <iomanip>
+#include <iostream>
+#include "check.h"
+
+namespace SushiAI
+{
+    CheckSuite::CheckSuite(const std::string& filter) : filter(filter)
+    {
+
+    }
+
+    bool CheckSuite::wants(const std::string& group) const
+    {
+        // Names carry no '/': a filter with one matches only groups ending in the text before it
+        size_t slash = filter.find('/');
+        if (slash == std::string::npos)
+            return true;
+
+        return group.size() >= slash && group.compare(group.size() - slash, slash, filter, 0, slash) == 0;
+    }
+
+    void CheckSuite::expect(const std::string& group, const std::string& name, double error, double tolerance)
+    {
+        std::string label = group + "/" + name;
+        if (!filter.empty() && label.find(filter) == std::string::npos)
+            return;
+
+        bool passed = error <= tolerance;
+        ++checks;
+        if (!passed)
+            ++failures;
+
+        std::cout << (passed ? "ok    " : "FAIL  ") << std::left << std::setw(56) << label << std::right
+            << " error " << std::scientific << std::setprecision(2) << error << " (tolerance " << tolerance << ")"
+            << std::defaultfloat << "\n";
+    }
+}
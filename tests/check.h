@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+namespace SushiAI
+{
+    /// Runs named error-against-tolerance checks, prints one line per check and counts the failures.
+    class CheckSuite
+    {
+        private:
+            std::string filter;
+            int checks = 0;
+            int failures = 0;
+
+        public:
+            /// Only checks whose "group/name" contains filter are recorded.
+            explicit CheckSuite(const std::string& filter = "");
+
+            /// True when some check of the group can match the filter, so the caller may skip building it.
+            bool wants(const std::string& group) const;
+            /// Passes when error <= tolerance; a NaN error fails.
+            void expect(const std::string& group, const std::string& name, double error, double tolerance);
+
+            int getChecks() const { return checks; }
+            int getFailures() const { return failures; }
+    };
+}
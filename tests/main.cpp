@@ -0,0 +1,635 @@
+#include <cmath>
+#include <string>
+#include <memory>
+#include <random>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+#include <functional>
+#include "check.h"
+#include "initializer.h"
+#include "sequential.h"
+#include "optimizer.h"
+#include "derivatives.h"
+#include "inference.h"
+#include "passes.h"
+#include "staticmlp.h"
+#include "sharding.h"
+#include "jet.h"
+#include "tensor.h"
+#include "layer.h"
+#include "loss.h"
+#include "ops.h"
+
+using namespace SushiAI;
+
+namespace
+{
+    std::mt19937 gen(2024);
+
+    std::shared_ptr<Tensor> randomTensor(const std::vector<int>& shape, float scale = 1.0f, bool requiresGrad = true)
+    {
+        std::uniform_real_distribution<float> dist(-scale, scale);
+
+        auto t = std::make_shared<Tensor>(shape, 0.0f, requiresGrad);
+        for (auto& v : t -> getData())
+            v = dist(gen);
+
+        return t;
+    }
+
+    /// Overwrites parameters drawn by the (nondeterministic) initializers: Xavier-uniform matrices, small vectors.
+    void reinitialize(const std::vector<std::shared_ptr<Tensor>>& params)
+    {
+        for (auto& p : params)
+        {
+            const auto& shape = p -> getShape();
+            float limit = shape.size() >= 2 ? std::sqrt(6.0f / (shape[0] + shape[shape.size() - 1])) : 0.5f;
+
+            std::uniform_real_distribution<float> dist(-limit, limit);
+            for (auto& v : p -> getData())
+                v = dist(gen);
+        }
+    }
+
+    double maxDifference(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        if (a.size() != b.size())
+            return INFINITY;
+
+        double error = 0.0;
+        for (size_t i = 0; i < a.size(); ++i)
+            error = std::max(error, (double)std::fabs(a[i] - b[i]));
+
+        return error;
+    }
+
+    /// Largest |analytic - central difference| of the gradient of Σ w · f() over every element of the leaves,
+    /// for fixed random weights w, relative to the largest difference quotient (or 1 when all are small).
+    double gradientError(const std::function<std::shared_ptr<Tensor>()>& f, const std::vector<std::shared_ptr<Tensor>>& leaves, float h)
+    {
+        auto out = f();
+        std::vector<float> w(out -> getTotalSize());
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        for (auto& v : w)
+            v = dist(gen);
+
+        out -> backward(w);
+
+        auto weighted = [&]()
+        {
+            NoGradGuard guard;
+            auto y = f();
+
+            double sum = 0.0;
+            for (size_t i = 0; i < w.size(); ++i)
+                sum += (double)y -> getData()[i] * w[i];
+
+            return sum;
+        };
+
+        double error = 0.0, scale = 1.0;
+        for (auto& leaf : leaves)
+            for (int k = 0; k < leaf -> getTotalSize(); ++k)
+            {
+                float saved = leaf -> getData()[k];
+                leaf -> getData()[k] = saved + h;
+                double plus = weighted();
+                leaf -> getData()[k] = saved - h;
+                double minus = weighted();
+                leaf -> getData()[k] = saved;
+
+                double numeric = (plus - minus) / (2.0 * h);
+                error = std::max(error, std::fabs(numeric - leaf -> getGradient()[k]));
+                scale = std::max(scale, std::fabs(numeric));
+            }
+
+        return error / scale;
+    }
+
+    #pragma region Gradients
+
+    void checkConvGradients(CheckSuite& suite)
+    {
+        struct Case { const char* name; int channels, outChannels, kernel, stride, padding, dilation, groups; };
+        const Case cases[] =
+        {
+            { "conv2d 3x3 stride 2 pad 1",      3, 4, 3, 2, 1, 1, 1 },
+            { "conv2d 3x3 dilation 2 groups 2", 4, 6, 3, 1, 2, 2, 2 },
+            { "conv2d depthwise 3x3",           4, 8, 3, 1, 1, 1, 4 },
+            { "conv2d pointwise 1x1",           3, 5, 1, 1, 0, 1, 1 },
+        };
+
+        for (auto& c : cases)
+        {
+            auto x = randomTensor({ 2, c.channels, 6, 7 });
+            auto w = randomTensor({ c.outChannels, c.channels / c.groups, c.kernel, c.kernel }, 0.5f);
+            auto b = randomTensor({ c.outChannels }, 0.5f);
+
+            double error = gradientError([&]() { return conv2d(x, w, b, c.stride, c.padding, c.dilation, c.groups); }, { x, w, b }, 1e-2f);
+            suite.expect("gradients", c.name, error, 1e-3);
+        }
+    }
+
+    void checkPoolingGradients(CheckSuite& suite)
+    {
+        // Distinct values at least 0.05 apart, so a ±h step never changes which tap wins a max window
+        auto distinct = [](const std::vector<int>& shape)
+        {
+            auto t = std::make_shared<Tensor>(shape, 0.0f, true);
+            std::vector<float> values(t -> getTotalSize());
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = 0.05f * (float)i - 0.025f * (float)values.size();
+            std::shuffle(values.begin(), values.end(), gen);
+            t -> getData() = values;
+
+            return t;
+        };
+
+        auto x = distinct({ 2, 3, 7, 8 });
+        suite.expect("gradients", "maxPool2d k3 s2 p1", gradientError([&]() { return maxPool2d(x, 3, 2, 1); }, { x }, 1e-2f), 1e-3);
+        suite.expect("gradients", "maxPool2d k2 s2", gradientError([&]() { return maxPool2d(x, 2, 2); }, { x }, 1e-2f), 1e-3);
+        suite.expect("gradients", "avgPool2d k3 s1 p1", gradientError([&]() { return avgPool2d(x, 3, 1, 1); }, { x }, 1e-2f), 1e-3);
+        suite.expect("gradients", "adaptiveAvgPool2d 3x5", gradientError([&]() { return adaptiveAvgPool2d(x, 3, 5); }, { x }, 1e-2f), 1e-3);
+        suite.expect("gradients", "globalAvgPool2d", gradientError([&]() { return globalAvgPool2d(x); }, { x }, 1e-2f), 1e-3);
+    }
+
+    void checkAttentionGradients(CheckSuite& suite)
+    {
+        auto q = randomTensor({ 2, 5, 8 }), k = randomTensor({ 2, 5, 8 }), v = randomTensor({ 2, 5, 8 });
+        suite.expect("gradients", "attention 2 heads", gradientError([&]() { return scaledDotProductAttention(q, k, v, 2); }, { q, k, v }, 1e-2f), 1e-3);
+        suite.expect("gradients", "attention 2 heads causal", gradientError([&]() { return scaledDotProductAttention(q, k, v, 2, true); }, { q, k, v }, 1e-2f), 1e-3);
+
+        auto keys = randomTensor({ 2, 7, 8 }), values = randomTensor({ 2, 7, 8 });
+        suite.expect("gradients", "attention 4 heads, 7 keys", gradientError([&]() { return scaledDotProductAttention(q, keys, values, 4); }, { q, keys, values }, 1e-2f), 1e-3);
+    }
+
+    void checkRecurrentGradients(CheckSuite& suite)
+    {
+        const int I = 3, H = 4;
+        auto x = randomTensor({ 2, 5, I });
+
+        auto wx = randomTensor({ I, 4 * H }, 0.5f), wh = randomTensor({ H, 4 * H }, 0.5f), b = randomTensor({ 4 * H }, 0.3f);
+        suite.expect("gradients", "lstm", gradientError([&]() { return lstm(x, wx, wh, b); }, { x, wx, wh, b }, 1e-2f), 1e-3);
+
+        auto gx = randomTensor({ I, 3 * H }, 0.5f), gh = randomTensor({ H, 3 * H }, 0.5f);
+        auto bx = randomTensor({ 3 * H }, 0.3f), bh = randomTensor({ 3 * H }, 0.3f);
+        suite.expect("gradients", "gru", gradientError([&]() { return gru(x, gx, gh, bx, bh); }, { x, gx, gh, bx, bh }, 1e-2f), 1e-3);
+    }
+
+    void checkNormalizationGradients(CheckSuite& suite)
+    {
+        auto x = randomTensor({ 3, 4, 10 });
+        auto gamma = randomTensor({ 10 }), beta = randomTensor({ 10 });
+
+        suite.expect("gradients", "layerNorm", gradientError([&]() { return layerNorm(x, gamma, beta); }, { x, gamma, beta }, 1e-2f), 1e-3);
+        suite.expect("gradients", "layerNorm without affine", gradientError([&]() { return layerNorm(x, nullptr, nullptr); }, { x }, 1e-2f), 1e-3);
+        suite.expect("gradients", "rmsNorm", gradientError([&]() { return rmsNorm(x, gamma); }, { x, gamma }, 1e-2f), 1e-3);
+    }
+
+    #pragma endregion
+
+    #pragma region Derivatives
+
+    std::shared_ptr<Sequential> tanhMlp(const std::vector<int>& sizes)
+    {
+        auto model = std::make_shared<Sequential>();
+        for (size_t i = 0; i + 1 < sizes.size(); ++i)
+        {
+            if (i > 0)
+                model -> add(std::make_shared<Tanh>());
+            model -> add(std::make_shared<Linear>(sizes[i], sizes[i + 1], std::make_shared<XavierUniform>(), std::make_shared<XavierUniform>()));
+        }
+
+        reinitialize(model -> parameters());
+        return model;
+    }
+
+    /// PINN residual of Δu = f on [0,1]² with f = -2π² sin(πx) sin(πy): the Taylor-mode derivatives of
+    /// jetForward() against central differences of forward(), and the residual loss gradient against
+    /// central differences of the loss.
+    void checkPoissonJet(CheckSuite& suite)
+    {
+        const float pi = 3.14159265f;
+        const int n = 32;
+
+        auto model = tanhMlp({ 2, 16, 16, 1 });
+
+        auto points = randomTensor({ n, 2 }, 1.0f, false);
+        auto source = std::make_shared<Tensor>(std::vector<int>{ n, 1 }, 0.0f, false);
+        for (int i = 0; i < n; ++i)
+        {
+            float& x = points -> getData()[2 * i];
+            float& y = points -> getData()[2 * i + 1];
+            x = 0.5f + 0.5f * x;
+            y = 0.5f + 0.5f * y;
+            source -> getData()[i] = -2.0f * pi * pi * std::sin(pi * x) * std::sin(pi * y);
+        }
+
+        const float h = 5e-2f;
+        auto shifted = [&](int k, float delta)
+        {
+            auto p = std::make_shared<Tensor>(points -> getShape(), 0.0f, false);
+            p -> getData() = points -> getData();
+            for (int i = 0; i < n; ++i)
+                p -> getData()[2 * i + k] += delta;
+
+            return model -> forward(p, false) -> getData();
+        };
+
+        Jet jet = jetForward(*model, points);
+        auto u = model -> forward(points, false) -> getData();
+
+        double firstError = 0.0, laplacianError = 0.0, laplacianScale = 1.0;
+        std::vector<float> laplacian(n, 0.0f);
+        for (int k = 0; k < 2; ++k)
+        {
+            auto plus = shifted(k, h), minus = shifted(k, -h);
+            auto first = jet.derivative(k) -> getData();
+
+            for (int i = 0; i < n; ++i)
+            {
+                firstError = std::max(firstError, (double)std::fabs(first[i] - (plus[i] - minus[i]) / (2.0f * h)));
+                laplacian[i] += (plus[i] - 2.0f * u[i] + minus[i]) / (h * h);
+            }
+        }
+
+        auto jetLaplacian = jet.laplacian() -> getData();
+        for (int i = 0; i < n; ++i)
+        {
+            laplacianError = std::max(laplacianError, (double)std::fabs(jetLaplacian[i] - laplacian[i]));
+            laplacianScale = std::max(laplacianScale, (double)std::fabs(laplacian[i]));
+        }
+
+        suite.expect("derivatives", "jet value == forward", maxDifference(jet.value() -> getData(), u), 1e-5);
+        suite.expect("derivatives", "jet first derivatives vs FD", firstError, 2e-3);
+        suite.expect("derivatives", "jet laplacian vs FD", laplacianError / laplacianScale, 1e-2);
+
+        MSELoss mse;
+        suite.expect("derivatives", "jet residual loss gradient vs FD",
+            gradientError([&]() { return mse.forward(jetForward(*model, points).laplacian(), source); }, model -> parameters(), 1e-2f), 2e-2);
+    }
+
+    /// jacobian() against one backward() per sample and output, hvp() against central differences of the
+    /// parameter gradients along v.
+    void checkJacobianAndHvp(CheckSuite& suite)
+    {
+        const int n = 4, in = 3, out = 2;
+
+        auto model = tanhMlp({ in, 8, out });
+        auto inputs = randomTensor({ n, in }, 1.0f, false);
+        auto targets = randomTensor({ n, out }, 1.0f, false);
+
+        auto J = jacobian(*model, inputs) -> getData();
+
+        double jacobianError = 0.0;
+        for (int i = 0; i < n; ++i)
+            for (int o = 0; o < out; ++o)
+            {
+                auto x = std::make_shared<Tensor>(std::vector<int>{ 1, in }, 0.0f, true);
+                std::copy(inputs -> getData().begin() + i * in, inputs -> getData().begin() + (i + 1) * in, x -> getData().begin());
+
+                std::vector<float> seed(out, 0.0f);
+                seed[o] = 1.0f;
+                model -> forward(x, false) -> backwardTo(seed, { x });
+
+                for (int k = 0; k < in; ++k)
+                    jacobianError = std::max(jacobianError, (double)std::fabs(J[(i * out + o) * in + k] - x -> getGradient()[k]));
+            }
+
+        suite.expect("derivatives", "jacobian vs per-row backward", jacobianError, 1e-6);
+
+        auto params = model -> parameters();
+        std::vector<std::shared_ptr<Tensor>> v;
+        for (auto& p : params)
+            v.push_back(randomTensor(p -> getShape(), 1.0f, false));
+
+        MSELoss mse;
+        auto Hv = hvp(*model, mse, inputs, targets, params, v);
+
+        // ∇L at θ + t v
+        auto gradients = [&](float t)
+        {
+            for (size_t p = 0; p < params.size(); ++p)
+                for (size_t j = 0; j < params[p] -> getData().size(); ++j)
+                    params[p] -> getData()[j] += t * v[p] -> getData()[j];
+
+            mse.forward(model -> forward(inputs, false), targets) -> backward();
+
+            std::vector<std::vector<float>> g;
+            for (size_t p = 0; p < params.size(); ++p)
+            {
+                g.push_back(params[p] -> getGradient());
+                for (size_t j = 0; j < params[p] -> getData().size(); ++j)
+                    params[p] -> getData()[j] -= t * v[p] -> getData()[j];
+            }
+
+            return g;
+        };
+
+        const float t = 1e-2f;
+        auto plus = gradients(t), minus = gradients(-t);
+
+        double hvpError = 0.0, hvpScale = 1.0;
+        for (size_t p = 0; p < params.size(); ++p)
+            for (size_t j = 0; j < plus[p].size(); ++j)
+            {
+                double numeric = (plus[p][j] - minus[p][j]) / (2.0 * t);
+                hvpError = std::max(hvpError, std::fabs(Hv[p] -> getData()[j] - numeric));
+                hvpScale = std::max(hvpScale, std::fabs(numeric));
+            }
+
+        suite.expect("derivatives", "hvp vs FD of gradients", hvpError / hvpScale, 1e-2);
+    }
+
+    #pragma endregion
+
+    #pragma region Inference
+
+    /// InferencePlan::run() must reproduce Sequential::forward(input, false) bit for bit; with the norm
+    /// affine folded into the next Linear it may differ by rounding only.
+    void checkInferencePlan(CheckSuite& suite)
+    {
+        auto xavier = std::make_shared<XavierUniform>();
+
+        auto inner = std::make_shared<Sequential>();
+        inner -> add(std::make_shared<Linear>(16, 12, xavier, xavier));
+        inner -> add(std::make_shared<Sigmoid>());
+
+        auto norm = std::make_shared<BatchNorm>(16);
+
+        Sequential model;
+        model.add(std::make_shared<Linear>(6, 16, xavier, xavier));
+        model.add(std::make_shared<ReLU>());
+        model.add(norm);
+        model.add(std::make_shared<Linear>(16, 16, xavier, xavier));
+        model.add(std::make_shared<LeakyReLU>());
+        model.add(std::make_shared<Dropout>(0.3f));
+        model.add(inner);
+        model.add(std::make_shared<LayerNorm>(12));
+        model.add(std::make_shared<Linear>(12, 8, xavier, xavier));
+        model.add(std::make_shared<Tanh>());
+        model.add(std::make_shared<RMSNorm>(8));
+        model.add(std::make_shared<Linear>(8, 3, xavier, xavier));
+        reinitialize(model.parameters());
+
+        std::uniform_real_distribution<float> dist(0.5f, 1.5f);
+        for (auto& v : norm -> getRunningVar() -> getData())
+            v = dist(gen);
+        for (auto& v : norm -> getRunningMean() -> getData())
+            v = dist(gen) - 1.0f;
+
+        auto input = randomTensor({ 5, 6 }, 1.0f, false);
+        auto expected = model.forward(input, false) -> getData();
+
+        for (bool fold : { false, true })
+        {
+            auto plan = InferencePlan::compile(model, input -> getShape(), fold);
+            Tensor output(plan.getOutputShape());
+            plan.run(*input, output);
+
+            if (fold)
+                suite.expect("inference", "plan with folded norms vs forward", maxDifference(output.getData(), expected), 1e-5);
+            else
+                suite.expect("inference", "plan bit-exact vs forward", maxDifference(output.getData(), expected), 0.0);
+        }
+    }
+
+    void checkStaticSequential(CheckSuite& suite)
+    {
+        constexpr int Batch = 8;
+
+        auto model = tanhMlp({ 2, 16, 16, 1 });
+        auto input = randomTensor({ Batch, 2 }, 1.0f, false);
+        auto expected = model -> forward(input, false) -> getData();
+
+        StaticSequential<StaticLinear<2, 16, PlanActivation::Tanh>, StaticLinear<16, 16, PlanActivation::Tanh>, StaticLinear<16, 1>> net;
+        net.load(*model);
+
+        std::vector<float> single(Batch), batched(Batch);
+        for (int s = 0; s < Batch; ++s)
+            net.forward(input -> getData().data() + 2 * s, single.data() + s);
+        net.forwardBatch<Batch>(input -> getData().data(), batched.data());
+
+        suite.expect("inference", "StaticSequential forward vs Sequential", maxDifference(single, expected), 1e-5);
+        suite.expect("inference", "StaticSequential forwardBatch vs Sequential", maxDifference(batched, expected), 1e-5);
+    }
+
+    /// optimizeForInference() folds a BatchNorm on either side of a Linear and merges the Linear pair left
+    /// behind; the rewritten model must compute the same function.
+    void checkOptimizeForInference(CheckSuite& suite)
+    {
+        auto xavier = std::make_shared<XavierUniform>();
+        auto after = std::make_shared<BatchNorm>(8), before = std::make_shared<BatchNorm>(8);
+
+        Sequential model;
+        model.add(std::make_shared<Linear>(4, 8, xavier, xavier));
+        model.add(after);
+        model.add(std::make_shared<Tanh>());
+        model.add(before);
+        model.add(std::make_shared<Linear>(8, 8, xavier, xavier));
+        model.add(std::make_shared<Dropout>(0.5f));
+        model.add(std::make_shared<Linear>(8, 3, xavier, xavier));
+        reinitialize(model.parameters());
+
+        std::uniform_real_distribution<float> dist(0.5f, 1.5f);
+        for (auto& bn : { after, before })
+        {
+            for (auto& v : bn -> getRunningVar() -> getData())
+                v = dist(gen);
+            for (auto& v : bn -> getRunningMean() -> getData())
+                v = dist(gen) - 1.0f;
+        }
+
+        std::vector<std::shared_ptr<Tensor>> samples = { randomTensor({ 5, 4 }, 1.0f, false), randomTensor({ 3, 4 }, 1.0f, false) };
+
+        OptimizationReport report;
+        auto optimized = optimizeForInference(model, samples, &report);
+
+        suite.expect("inference", "optimizeForInference vs original", report.maxAbsError, 1e-5);
+        suite.expect("inference", "optimizeForInference layer count", std::fabs((double)report.layersAfter - 3.0), 0.0);
+    }
+
+    #pragma endregion
+
+    #pragma region Sparse Gradients
+
+    /// A sparse-gradient Embedding against a dense one with the same table: the coalesced row gradient must
+    /// scatter to the dense gradient, and steps that touch every row must move both tables the same.
+    void checkSparseEmbedding(CheckSuite& suite)
+    {
+        const int vocab = 40, dim = 6;
+        auto init = std::make_shared<UniformInitializer>(-1.0f, 1.0f);
+
+        auto indices = std::make_shared<Tensor>(std::vector<int>{ 4, 20 }, 0.0f, false);
+        std::uniform_int_distribution<int> row(0, vocab - 1);
+        for (int i = 0; i < indices -> getTotalSize(); ++i)
+            indices -> getData()[i] = (float)(i < vocab ? i : row(gen));         // every row at least once, with repeats
+
+        auto target = randomTensor({ 4, 20, dim }, 1.0f, false);
+        MSELoss mse;
+
+        {
+            auto sparse = std::make_shared<Embedding>(vocab, dim, init, true);
+            auto dense = std::make_shared<Embedding>(vocab, dim, init, false);
+            dense -> weights -> getData() = sparse -> weights -> getData();
+
+            mse.forward(sparse -> forward(indices), target) -> backward();
+            mse.forward(dense -> forward(indices), target) -> backward();
+
+            std::vector<float> scattered((size_t)vocab * dim, 0.0f);
+            sparse -> weights -> sparseGradient.addTo(scattered);
+            suite.expect("sparse", "embedding row gradient == dense gradient", maxDifference(scattered, dense -> weights -> getGradient()), 1e-6);
+        }
+
+        struct Case { const char* name; std::function<std::shared_ptr<Optimizer>()> make; };
+        const Case cases[] =
+        {
+            { "SGD step sparse == dense",                  []() { return std::make_shared<SGD>(0.1f); } },
+            { "SGD momentum + decay step sparse == dense", []() { return std::make_shared<SGD>(0.1f, 0.9f, 0.01f); } },
+            { "Adam step sparse == dense",                 []() { return std::make_shared<Adam>(0.01f); } },
+        };
+
+        for (auto& c : cases)
+        {
+            auto sparse = std::make_shared<Embedding>(vocab, dim, init, true);
+            auto dense = std::make_shared<Embedding>(vocab, dim, init, false);
+            dense -> weights -> getData() = sparse -> weights -> getData();
+            auto sparseOptimizer = c.make(), denseOptimizer = c.make();
+
+            for (int step = 0; step < 5; ++step)
+            {
+                sparseOptimizer -> zeroGradient(sparse -> parameters());
+                mse.forward(sparse -> forward(indices), target) -> backward();
+                sparseOptimizer -> step(sparse -> parameters());
+
+                denseOptimizer -> zeroGradient(dense -> parameters());
+                mse.forward(dense -> forward(indices), target) -> backward();
+                denseOptimizer -> step(dense -> parameters());
+            }
+
+            suite.expect("sparse", c.name, maxDifference(sparse -> weights -> getData(), dense -> weights -> getData()), 1e-5);
+        }
+    }
+
+    #pragma endregion
+
+    #pragma region Sharding
+
+    /// ShardedLinear against a Linear holding the gathered weights: outputs, input gradient and the slice
+    /// of the weight gradient every shard owns.
+    void checkShardedLinear(CheckSuite& suite)
+    {
+        const int in = 7, out = 10, shards = 3;
+        auto xavier = std::make_shared<XavierUniform>();
+
+        for (ShardMode mode : { ShardMode::Column, ShardMode::Row })
+        {
+            std::string label = mode == ShardMode::Column ? "ShardedLinear column" : "ShardedLinear row";
+
+            ShardedLinear sharded(in, out, shards, mode, xavier, xavier, false);
+            reinitialize(sharded.parameters());
+
+            Linear linear(in, out, xavier, xavier);
+            linear.weights -> getData() = sharded.gatherWeights() -> getData();
+            linear.bias -> getData() = sharded.bias -> getData();
+
+            auto x = randomTensor({ 5, in });
+            auto xCopy = std::make_shared<Tensor>(x -> getShape(), 0.0f, true);
+            xCopy -> getData() = x -> getData();
+
+            auto y = sharded.forward(x);
+            auto expected = linear.forward(xCopy);
+            suite.expect("sharding", label + " forward == Linear", maxDifference(y -> getData(), expected -> getData()), 1e-5);
+
+            std::vector<float> seed(y -> getTotalSize());
+            std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+            for (auto& v : seed)
+                v = dist(gen);
+
+            y -> backward(seed);
+            expected -> backward(seed);
+            suite.expect("sharding", label + " input gradient == Linear", maxDifference(x -> getGradient(), xCopy -> getGradient()), 1e-5);
+            suite.expect("sharding", label + " bias gradient == Linear", maxDifference(sharded.bias -> getGradient(), linear.bias -> getGradient()), 1e-5);
+
+            // Shard k holds a block of columns (Column) or rows (Row) of the [in, out] weight
+            std::vector<float> gathered((size_t)in * out, 0.0f);
+            int offset = 0;
+            for (auto& shard : sharded.weightShards)
+            {
+                const int rows = shard -> getShape()[0], cols = shard -> getShape()[1];
+                for (int r = 0; r < rows; ++r)
+                    for (int c = 0; c < cols; ++c)
+                    {
+                        size_t index = mode == ShardMode::Column ? (size_t)r * out + offset + c : (size_t)(offset + r) * out + c;
+                        gathered[index] = shard -> getGradient()[(size_t)r * cols + c];
+                    }
+
+                offset += mode == ShardMode::Column ? cols : rows;
+            }
+
+            suite.expect("sharding", label + " weight gradient == Linear", maxDifference(gathered, linear.weights -> getGradient()), 1e-5);
+        }
+    }
+
+    #pragma endregion
+
+    void usage()
+    {
+        std::cout << "Usage: SushiAITests [--filter <text>]\n"
+            << "  --filter <text>  only run checks whose \"group/name\" contains text (groups: gradients,\n"
+            << "                   derivatives, inference, sparse, sharding)\n"
+            << "Exits with 1 when any check exceeds its tolerance.\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else
+        {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    CheckSuite suite(filter);
+
+    const std::pair<const char*, std::function<void(CheckSuite&)>> checks[] =
+    {
+        { "gradients",   checkConvGradients },
+        { "gradients",   checkPoolingGradients },
+        { "gradients",   checkAttentionGradients },
+        { "gradients",   checkRecurrentGradients },
+        { "gradients",   checkNormalizationGradients },
+        { "derivatives", checkPoissonJet },
+        { "derivatives", checkJacobianAndHvp },
+        { "inference",   checkInferencePlan },
+        { "inference",   checkStaticSequential },
+        { "inference",   checkOptimizeForInference },
+        { "sparse",      checkSparseEmbedding },
+        { "sharding",    checkShardedLinear },
+    };
+
+    for (auto& check : checks)
+        if (suite.wants(check.first))
+            check.second(suite);
+
+    std::cout << suite.getChecks() - suite.getFailures() << " of " << suite.getChecks() << " checks passed\n";
+
+    if (suite.getChecks() == 0)
+    {
+        std::cerr << "No check matches \"" << filter << "\"\n";
+        return 1;
+    }
+
+    return suite.getFailures() > 0 ? 1 : 0;
+}